@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "field.h"
+#include "lenia_sim.h"
+#include "volume.h"
+#include "bmpfile.h"
+#include "exporter.h"
+#include "checkpoint.h"
+
+#define COVERAGE 0.2f
+#define SNAPSHOT_QUEUE 8    /* snapshots waiting for the writer thread before a step waits for it */
+
+// Headless Lenia / SmoothLife / 3D driver, no window: steps the field and prints timings.
+//
+//   headless [width height] [--engine lenia|smoothlife|lenia3d|life3d] [--fft]
+//            [--steps N] [--storage f32|f16|u16] [--seed S] [--radius R]
+//            [--coverage C] [--tile T] [--eps E] [--validate]
+//            [--depth D] [--rule 4555] [--slice Z file.bmp] [--volume file.raw]
+//            [--snapshots N prefix] [--checkpoint N file] [--restore file]
+//
+// --fft convolves through the FFT (SmoothLife and lenia3d always do).
+// The 3D engines take --depth (defaults to height), life3d takes --rule, and
+// both can export one z slice as a BMP or the whole volume as raw bytes.
+// --tile sets the empty region skipping tile edge (0 convolves everything).
+// --radius can be at most half the smaller of width and height.
+// --validate runs a dense fp32 reference next to the chosen storage mode and
+// tiling from the same seed and prints the drift after every step.
+// --snapshots saves the state as an 8 bit grey BMP every N steps, to
+// prefix_<step>.bmp (the 3D engines save slice Z, 0 without --slice). The
+// step loop only copies the state; a writer thread does the disk I/O.
+// --checkpoint writes the whole run to file every N generations and after the
+// last one (N = 0 only at the end). --restore picks a run back up from such
+// a file: engine, size, storage, parameters, generation and RNG state all
+// come from it, and --steps more steps are run.
+
+typedef enum {
+    ENGINE_2D = 0,
+    ENGINE_LENIA3D = 1,
+    ENGINE_LIFE3D = 2
+} engine_kind;
+
+typedef struct {
+    engine_kind engine;
+    lenia_rule rule;
+    lenia_conv conv;
+    size_t width;
+    size_t height;
+    size_t depth;
+    size_t steps;
+    uint64_t seed;
+    float coverage;
+    field_storage storage;
+    lenia_params params;
+    size_t tile;
+    float eps;
+    bool validate;
+    const char* life_rule;
+    size_t slice_z;
+    const char* slice_path;
+    const char* volume_path;
+    size_t snapshot_every;
+    const char* snapshot_prefix;
+    size_t checkpoint_every;
+    const char* checkpoint_path;
+    const char* restore_path;
+    checkpoint_map restore;     // mapped while the engine is set up from it
+    char restored_rule[CHECKPOINT_NAME_MAX];
+} run_config;
+
+unsigned long safe_atoi(const char *str) {
+    unsigned long value;
+    if (sscanf(str, "%lu", &value) == 1) {
+        return value;
+    } else {
+        // Handle conversion error
+        fprintf(stderr, "Invalid input\n");
+        return 0;
+    }
+}
+
+double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// the engines that convolve with the Lenia kernel, the only ones --radius means anything to
+bool uses_radius(const run_config* cfg) {
+    return cfg->engine == ENGINE_LENIA3D || (cfg->engine == ENGINE_2D && cfg->rule == LENIA_RULE_LENIA);
+}
+
+// a kernel wider than the board would overlap itself around the torus
+size_t radius_limit(const run_config* cfg) {
+    return (cfg->width < cfg->height ? cfg->width : cfg->height) / 2;
+}
+
+/*  Take the engine, its size and parameters from the checkpoint to
+    restore, which stays mapped until the engine has copied its state out
+*/
+int restore_config(run_config* cfg) {
+    int res = checkpoint_open(&cfg->restore, cfg->restore_path);
+    if(res != CHECKPOINT_OK) {
+        fprintf(stderr, "Can't restore from %s (%d)\n", cfg->restore_path, res);
+        return 1;
+    }
+    const checkpoint_header* h = cfg->restore.header;
+
+    cfg->width = h->width;
+    cfg->height = h->height;
+    cfg->depth = h->depth;
+    cfg->storage = (field_storage) h->storage;
+    size_t state_bytes = cfg->width * cfg->height * cfg->depth * field_cell_bytes(cfg->storage);
+
+    if(strcmp(h->engine, "lenia") == 0 || strcmp(h->engine, "smoothlife") == 0) {
+        cfg->engine = ENGINE_2D;
+        cfg->rule = strcmp(h->engine, "lenia") == 0 ? LENIA_RULE_LENIA : LENIA_RULE_SMOOTHLIFE;
+    } else if(strcmp(h->engine, "lenia3d") == 0) {
+        cfg->engine = ENGINE_LENIA3D;
+    } else if(strcmp(h->engine, "life3d") == 0) {
+        cfg->engine = ENGINE_LIFE3D;
+        memcpy(cfg->restored_rule, h->rule, CHECKPOINT_NAME_MAX);
+        cfg->restored_rule[CHECKPOINT_NAME_MAX - 1] = '\0';
+        cfg->life_rule = cfg->restored_rule;
+        state_bytes = cfg->width / 8 * cfg->height * cfg->depth;
+    } else {
+        fprintf(stderr, "%s is a checkpoint of %s, not a headless engine\n", cfg->restore_path, h->engine);
+        checkpoint_close(&cfg->restore);
+        return 1;
+    }
+
+    // only the Lenia kernels have parameters, the other engines keep their defaults
+    bool params_ok = true;
+    if(uses_radius(cfg)) {
+        float radius = h->params[0];
+        params_ok = isfinite(radius) && radius >= 1 && radius <= (float) radius_limit(cfg);
+        if(params_ok)
+            cfg->params = (lenia_params) { (size_t) radius, h->params[1], h->params[2], h->params[3] };
+    }
+
+    bool known_storage = h->storage == FIELD_F32 || h->storage == FIELD_F16 || h->storage == FIELD_U16;
+    if(h->state_bytes != state_bytes || !known_storage || !params_ok) {
+        fprintf(stderr, "%s doesn't hold the state its header describes\n", cfg->restore_path);
+        checkpoint_close(&cfg->restore);
+        return 1;
+    }
+    return 0;
+}
+
+// every N generations like the snapshots, so restarts stay on the same grid,
+// and after this process's last step
+bool checkpoint_due(const run_config* cfg, size_t step, uint64_t generation) {
+    return cfg->checkpoint_path && ((cfg->checkpoint_every && generation % cfg->checkpoint_every == 0) || step == cfg->steps);
+}
+
+/* Write h and the state to --checkpoint, the step loop waits for the disk */
+int write_checkpoint(const run_config* cfg, checkpoint_header* h, const void* state) {
+    h->width = cfg->width;
+    h->height = cfg->height;
+    h->depth = cfg->engine == ENGINE_2D ? 1 : cfg->depth;
+    h->storage = (uint32_t) cfg->storage;
+    if(uses_radius(cfg)) {
+        h->params[0] = (float) cfg->params.radius;
+        h->params[1] = cfg->params.mu;
+        h->params[2] = cfg->params.sigma;
+        h->params[3] = cfg->params.dt;
+    }
+
+    double start = now_ms();
+    int res = checkpoint_write(cfg->checkpoint_path, h, state);
+    if(res != CHECKPOINT_OK) {
+        fprintf(stderr, "Failed to write checkpoint %s (%d)\n", cfg->checkpoint_path, res);
+        return 1;
+    }
+    printf("checkpoint=%s generation=%llu ms=%.1f\n", cfg->checkpoint_path, (unsigned long long) h->generation,
+        now_ms() - start);
+    return 0;
+}
+
+int checkpoint_field(const run_config* cfg, const lenia_sim* sim) {
+    checkpoint_header h;
+    checkpoint_describe(&h, cfg->rule == LENIA_RULE_SMOOTHLIFE ? "smoothlife" : "lenia", NULL);
+    h.generation = sim->generation;
+    h.rng = sim->rng;
+    h.cell_bits = (uint32_t) field_cell_bytes(sim->state.storage) * 8;
+    h.state_bytes = field_bytes(&sim->state);
+    return write_checkpoint(cfg, &h, sim->state.data);
+}
+
+int checkpoint_volume(const run_config* cfg, const life3d* life, const lenia3d* lenia) {
+    checkpoint_header h;
+    if(life) {
+        checkpoint_describe(&h, "life3d", cfg->life_rule ? cfg->life_rule : "4555");
+        h.generation = life->generation;
+        h.rng = life->rng;
+        h.cell_bits = 1;
+        h.state_bytes = life->words * life->height * life->depth * sizeof(uint64_t);
+        return write_checkpoint(cfg, &h, life->cells);
+    }
+    checkpoint_describe(&h, "lenia3d", NULL);
+    h.generation = lenia->generation;
+    h.rng = lenia->rng;
+    h.cell_bits = (uint32_t) field_cell_bytes(lenia->state.storage) * 8;
+    h.state_bytes = field_bytes(&lenia->state);
+    return write_checkpoint(cfg, &h, lenia->state.data);
+}
+
+int parse_args(run_config* cfg, int argc, char** argv) {
+    int positional = 0;
+
+    for(int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if(strcmp(argv[i], "--engine") == 0 && has_value) {
+            i++;
+            if(strcmp(argv[i], "lenia") == 0) {
+                cfg->rule = LENIA_RULE_LENIA;
+            } else if(strcmp(argv[i], "smoothlife") == 0) {
+                cfg->rule = LENIA_RULE_SMOOTHLIFE;
+            } else if(strcmp(argv[i], "lenia3d") == 0) {
+                cfg->engine = ENGINE_LENIA3D;
+            } else if(strcmp(argv[i], "life3d") == 0) {
+                cfg->engine = ENGINE_LIFE3D;
+            } else {
+                fprintf(stderr, "Unknown engine %s (lenia, smoothlife, lenia3d, life3d)\n", argv[i]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--fft") == 0) {
+            cfg->conv = LENIA_CONV_FFT;
+        } else if(strcmp(argv[i], "--steps") == 0 && has_value) {
+            cfg->steps = safe_atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && has_value) {
+            cfg->seed = safe_atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--radius") == 0 && has_value) {
+            cfg->params.radius = safe_atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--coverage") == 0 && has_value) {
+            cfg->coverage = strtof(argv[++i], NULL);
+        } else if(strcmp(argv[i], "--tile") == 0 && has_value) {
+            cfg->tile = safe_atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--eps") == 0 && has_value) {
+            cfg->eps = strtof(argv[++i], NULL);
+        } else if(strcmp(argv[i], "--storage") == 0 && has_value) {
+            if(field_storage_parse(argv[++i], &cfg->storage) != FIELD_OK) {
+                fprintf(stderr, "Unknown storage mode %s (f32, f16, u16)\n", argv[i]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--depth") == 0 && has_value) {
+            cfg->depth = safe_atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--rule") == 0 && has_value) {
+            cfg->life_rule = argv[++i];
+        } else if(strcmp(argv[i], "--slice") == 0 && i + 2 < argc) {
+            cfg->slice_z = safe_atoi(argv[++i]);
+            cfg->slice_path = argv[++i];
+        } else if(strcmp(argv[i], "--snapshots") == 0 && i + 2 < argc) {
+            cfg->snapshot_every = safe_atoi(argv[++i]);
+            cfg->snapshot_prefix = argv[++i];
+        } else if(strcmp(argv[i], "--checkpoint") == 0 && i + 2 < argc) {
+            cfg->checkpoint_every = safe_atoi(argv[++i]);
+            cfg->checkpoint_path = argv[++i];
+        } else if(strcmp(argv[i], "--restore") == 0 && has_value) {
+            cfg->restore_path = argv[++i];
+        } else if(strcmp(argv[i], "--volume") == 0 && has_value) {
+            cfg->volume_path = argv[++i];
+        } else if(strcmp(argv[i], "--validate") == 0) {
+            cfg->validate = true;
+        } else if(argv[i][0] != '-' && positional < 2) {
+            if(positional++ == 0)
+                cfg->width = safe_atoi(argv[i]);
+            else
+                cfg->height = safe_atoi(argv[i]);
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(cfg->restore_path && restore_config(cfg))
+        return 1;
+
+    if(cfg->depth == 0)
+        cfg->depth = cfg->height;
+
+    if(cfg->width == 0 || cfg->height == 0 || cfg->params.radius == 0) {
+        fprintf(stderr, "Board dimensions and radius must be positive\n");
+        return 1;
+    }
+
+    if(uses_radius(cfg) && cfg->params.radius > radius_limit(cfg)) {
+        fprintf(stderr, "Radius %zu doesn't fit a %zux%zu board (at most %zu)\n", cfg->params.radius,
+            cfg->width, cfg->height, radius_limit(cfg));
+        return 1;
+    }
+
+    if(cfg->restore_path && cfg->validate) {
+        fprintf(stderr, "--validate starts both runs from the seed, it can't --restore\n");
+        return 1;
+    }
+
+    if(cfg->engine != ENGINE_2D && cfg->validate) {
+        fprintf(stderr, "--validate only covers the 2D engines\n");
+        return 1;
+    }
+
+    if(cfg->slice_path && cfg->slice_z >= cfg->depth) {
+        fprintf(stderr, "Slice %zu is outside the volume (depth %zu)\n", cfg->slice_z, cfg->depth);
+        return 1;
+    }
+
+    return 0;
+}
+
+// The reference is always the dense fp32 version of the same engine
+int init_sim(run_config* cfg, lenia_sim* sim, bool reference) {
+    field_storage storage = reference ? FIELD_F32 : cfg->storage;
+    int res;
+
+    if(cfg->rule == LENIA_RULE_SMOOTHLIFE)
+        res = lenia_init_smoothlife(sim, cfg->width, cfg->height, storage, SMOOTHLIFE_DEFAULT_PARAMS);
+    else
+        res = lenia_init(sim, cfg->width, cfg->height, storage, cfg->params);
+
+    if(res == LENIA_OK && cfg->rule == LENIA_RULE_LENIA)
+        res = lenia_set_conv(sim, reference ? LENIA_CONV_DIRECT : cfg->conv);
+    if(res == LENIA_OK)
+        res = lenia_set_tiling(sim, reference ? 0 : cfg->tile, reference ? 0.0f : cfg->eps);
+
+    if(res != LENIA_OK) {
+        fprintf(stderr, "Failed to allocate the %s field\n", field_storage_name(storage));
+        return 1;
+    }
+
+    if(cfg->restore_path) {
+        memcpy(sim->state.data, cfg->restore.state, field_bytes(&sim->state));
+        sim->generation = cfg->restore.header->generation;
+        sim->rng = cfg->restore.header->rng;
+        lenia_refresh_tiles(sim);
+    } else {
+        lenia_seed(sim, cfg->seed, cfg->coverage);
+    }
+    return 0;
+}
+
+bool snapshot_due(const run_config* cfg, size_t step) {
+    return cfg->snapshot_every && step % cfg->snapshot_every == 0;
+}
+
+/* Hand a width x height grey image (malloc'd, rows top first) to the writer thread */
+void submit_snapshot(const run_config* cfg, exporter* out, uint8_t* grey, size_t step) {
+    export_job job = { .data = grey, .width = cfg->width, .height = cfg->height, .depth = 8 };
+    snprintf(job.path, EXPORTER_PATH_MAX, "%s_%06zu.bmp", cfg->snapshot_prefix, step);
+    // the queue bounds memory: a step only waits when the disk is SNAPSHOT_QUEUE images behind
+    exporter_submit(out, &job, true);
+}
+
+/* Copy the 2D state out as 8 bit grey, the only part of a snapshot on the step loop */
+void snapshot_field(const run_config* cfg, exporter* out, const field_t* state, size_t step) {
+    uint8_t* grey = malloc(cfg->width * cfg->height);
+    float* row = malloc(cfg->width * sizeof(float));
+    if(grey == NULL || row == NULL) {
+        fprintf(stderr, "No memory for snapshot %zu, skipped\n", step);
+        free(grey);
+        free(row);
+        return;
+    }
+
+    for(size_t y = 0; y < cfg->height; y++) {
+        field_load_row(state, y, row);
+        for(size_t x = 0; x < cfg->width; x++) {
+            float v = row[x] < 0.0f ? 0.0f : row[x] > 1.0f ? 1.0f : row[x];
+            grey[y * cfg->width + x] = (uint8_t) (v * 255.0f + 0.5f);
+        }
+    }
+    free(row);
+    submit_snapshot(cfg, out, grey, step);
+}
+
+/* Writer thread for --snapshots, false if it couldn't be started */
+bool start_snapshots(const run_config* cfg, exporter* out) {
+    if(cfg->snapshot_every == 0)
+        return true;
+    if(exporter_start(out, SNAPSHOT_QUEUE) != EXPORTER_OK) {
+        fprintf(stderr, "Failed to start the snapshot writer\n");
+        return false;
+    }
+    return true;
+}
+
+/* Wait for the writer to finish the queue, non zero if a snapshot was lost */
+int finish_snapshots(const run_config* cfg, exporter* out) {
+    if(cfg->snapshot_every == 0)
+        return 0;
+    exporter_stop(out);
+    printf("snapshots_written=%lu snapshots_failed=%lu\n", (unsigned long) out->written, (unsigned long) out->failed);
+    return out->failed != 0;
+}
+
+int run(run_config* cfg) {
+    lenia_sim sim;
+    exporter snapshots;
+    if(init_sim(cfg, &sim, false))
+        return 1;
+    if(!start_snapshots(cfg, &snapshots)) {
+        lenia_destroy(&sim);
+        return 1;
+    }
+    size_t active = 0;
+    int res = 0;
+    double start = now_ms();
+    for(size_t s = 0; s < cfg->steps; s++) {
+        lenia_step(&sim);
+        active += sim.active_tiles;
+        if(snapshot_due(cfg, sim.generation))
+            snapshot_field(cfg, &snapshots, &sim.state, sim.generation);
+        if(checkpoint_due(cfg, s + 1, sim.generation))
+            res |= checkpoint_field(cfg, &sim);
+    }
+    double elapsed = now_ms() - start;
+
+    printf("engine=%s conv=%s storage=%s size=%zux%zu radius=%zu tile=%zu steps=%zu ms_per_step=%.3f active_tiles=%.3f state_bytes=%zu mass=%.3f\n",
+        cfg->rule == LENIA_RULE_SMOOTHLIFE ? "smoothlife" : "lenia", sim.conv == LENIA_CONV_FFT ? "fft" : "direct",
+        field_storage_name(cfg->storage), cfg->width, cfg->height, sim.params.radius, cfg->tile, cfg->steps,
+        cfg->steps ? elapsed / cfg->steps : 0.0,
+        cfg->steps ? (double) active / ((double) cfg->steps * sim.tiles_x * sim.tiles_y) : 0.0,
+        field_bytes(&sim.state), lenia_mass(&sim));
+
+    res |= finish_snapshots(cfg, &snapshots);
+    lenia_destroy(&sim);
+    return res;
+}
+
+int validate(run_config* cfg) {
+    lenia_sim ref, test;
+    if(init_sim(cfg, &ref, true))
+        return 1;
+    if(init_sim(cfg, &test, false)) {
+        lenia_destroy(&ref);
+        return 1;
+    }
+
+    // machine readable, one line per step
+    printf("step\tmax_abs\trms\tmass_f32\tmass_%s\n", field_storage_name(cfg->storage));
+    for(size_t s = 1; s <= cfg->steps; s++) {
+        float max_abs;
+        double rms;
+
+        lenia_step(&ref);
+        lenia_step(&test);
+        lenia_drift(&ref, &test, &max_abs, &rms);
+
+        printf("%zu\t%.6g\t%.6g\t%.4f\t%.4f\n", s, max_abs, rms, lenia_mass(&ref), lenia_mass(&test));
+    }
+
+    lenia_destroy(&ref);
+    lenia_destroy(&test);
+    return 0;
+}
+
+typedef struct {
+    const uint8_t* slice;
+    size_t width;
+} slice_rows;
+
+bool slice_row(void* ctx, uint32_t y, uint8_t* row) {
+    const slice_rows* src = (const slice_rows*) ctx;
+    memcpy(row, src->slice + (size_t) y * src->width, src->width);
+    return true;
+}
+
+// 8 bit grey straight from the slice, a row at a time
+int write_slice_bmp(const uint8_t* slice, size_t width, size_t height, const char* path) {
+    slice_rows src = { slice, width };
+    return bmp_save_rows(path, width, height, 8, slice_row, &src) ? 0 : 1;
+}
+
+int export_volume(run_config* cfg, life3d* life, lenia3d* lenia) {
+    int res = 0;
+
+    if(cfg->slice_path) {
+        uint8_t* slice = malloc(cfg->width * cfg->height);
+        if(slice == NULL)
+            return 1;
+
+        if(life)
+            life3d_slice(life, cfg->slice_z, slice);
+        else
+            lenia3d_slice(lenia, cfg->slice_z, slice);
+
+        res |= write_slice_bmp(slice, cfg->width, cfg->height, cfg->slice_path);
+        free(slice);
+    }
+
+    if(cfg->volume_path) {
+        int written = life ? life3d_write_raw(life, cfg->volume_path) : lenia3d_write_raw(lenia, cfg->volume_path);
+        res |= written != VOLUME_OK;
+    }
+
+    if(res)
+        fprintf(stderr, "Failed to export the volume\n");
+    return res;
+}
+
+int run_volume(run_config* cfg) {
+    life3d life;
+    lenia3d lenia;
+    bool is_life = cfg->engine == ENGINE_LIFE3D;
+    int res;
+
+    if(is_life) {
+        res = life3d_init(&life, cfg->width, cfg->height, cfg->depth);
+        if(res == VOLUME_OK && cfg->life_rule)
+            res = life3d_set_rule(&life, cfg->life_rule);
+    } else {
+        res = lenia3d_init(&lenia, cfg->width, cfg->height, cfg->depth, cfg->storage, cfg->params);
+    }
+
+    if(res != VOLUME_OK) {
+        fprintf(stderr, res == VOLUME_INVALID ? "Invalid volume (life3d needs width %% 64 == 0) or rule\n"
+                                              : "Failed to allocate the volume\n");
+        return 1;
+    }
+
+    if(cfg->restore_path) {
+        const checkpoint_header* h = cfg->restore.header;
+        memcpy(is_life ? (void*) life.cells : lenia.state.data, cfg->restore.state, h->state_bytes);
+        if(is_life) {
+            life.generation = h->generation;
+            life.rng = h->rng;
+        } else {
+            lenia.generation = h->generation;
+            lenia.rng = h->rng;
+        }
+    } else if(is_life) {
+        life3d_seed(&life, cfg->seed, cfg->coverage);
+    } else {
+        lenia3d_seed(&lenia, cfg->seed, cfg->coverage);
+    }
+
+    exporter snapshots;
+    if(!start_snapshots(cfg, &snapshots)) {
+        if(is_life)
+            life3d_destroy(&life);
+        else
+            lenia3d_destroy(&lenia);
+        return 1;
+    }
+
+    double start = now_ms();
+    for(size_t s = 0; s < cfg->steps; s++) {
+        if(is_life)
+            life3d_step(&life);
+        else
+            lenia3d_step(&lenia);
+
+        uint64_t generation = is_life ? life.generation : lenia.generation;
+        if(checkpoint_due(cfg, s + 1, generation))
+            res |= checkpoint_volume(cfg, is_life ? &life : NULL, is_life ? NULL : &lenia);
+        if(snapshot_due(cfg, generation)) {
+            uint8_t* slice = malloc(cfg->width * cfg->height);
+            if(slice == NULL) {
+                fprintf(stderr, "No memory for snapshot %llu, skipped\n", (unsigned long long) generation);
+                continue;
+            }
+            if(is_life)
+                life3d_slice(&life, cfg->slice_z, slice);
+            else
+                lenia3d_slice(&lenia, cfg->slice_z, slice);
+            submit_snapshot(cfg, &snapshots, slice, generation);
+        }
+    }
+    double elapsed = now_ms() - start;
+
+    if(is_life)
+        printf("engine=life3d size=%zux%zux%zu steps=%zu ms_per_step=%.3f state_bytes=%zu population=%llu\n",
+            cfg->width, cfg->height, cfg->depth, cfg->steps, cfg->steps ? elapsed / cfg->steps : 0.0,
+            life.words * life.height * life.depth * sizeof(uint64_t), (unsigned long long) life3d_population(&life));
+    else
+        printf("engine=lenia3d storage=%s size=%zux%zux%zu radius=%zu steps=%zu ms_per_step=%.3f state_bytes=%zu mass=%.3f\n",
+            field_storage_name(cfg->storage), cfg->width, cfg->height, cfg->depth, cfg->params.radius, cfg->steps,
+            cfg->steps ? elapsed / cfg->steps : 0.0, field_bytes(&lenia.state), lenia3d_mass(&lenia));
+
+    res |= export_volume(cfg, is_life ? &life : NULL, is_life ? NULL : &lenia);
+    res |= finish_snapshots(cfg, &snapshots);
+
+    if(is_life)
+        life3d_destroy(&life);
+    else
+        lenia3d_destroy(&lenia);
+    return res;
+}
+
+int main(int argc, char** argv) {
+    run_config cfg = {
+        .engine = ENGINE_2D,
+        .rule = LENIA_RULE_LENIA,
+        .conv = LENIA_CONV_DIRECT,
+        .width = 256,
+        .height = 256,
+        .steps = 100,
+        .seed = (uint64_t) time(NULL),
+        .coverage = COVERAGE,
+        .storage = FIELD_F32,
+        .params = LENIA_DEFAULT_PARAMS,
+        .tile = LENIA_DEFAULT_TILE,
+        .eps = LENIA_DEFAULT_EPS,
+        .validate = false
+    };
+
+    if(parse_args(&cfg, argc, argv))
+        return 1;
+
+    int res;
+    if(cfg.engine != ENGINE_2D)
+        res = run_volume(&cfg);
+    else
+        res = cfg.validate ? validate(&cfg) : run(&cfg);
+    checkpoint_close(&cfg.restore);
+    return res;
+}
@@ -0,0 +1,150 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+#define CHECKPOINT_CHUNK (64u << 20)    /* bytes per pwrite, some systems cap a single write */
+
+_Static_assert(sizeof(checkpoint_header) <= CHECKPOINT_ALIGN, "the header has to fit its page");
+
+/* PRIVATE FUNCTIONS */
+static bool __pwrite_all(int fd, const void* data, size_t bytes, off_t offset);
+static void __sync_directory(const char* path);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+void checkpoint_describe(checkpoint_header* h, const char* engine, const char* rule) {
+    memset(h, 0, sizeof(checkpoint_header));
+    strncpy(h->engine, engine, CHECKPOINT_NAME_MAX - 1);
+    if(rule)
+        strncpy(h->rule, rule, CHECKPOINT_NAME_MAX - 1);
+    h->depth = 1;
+}
+
+int checkpoint_write(const char* path, const checkpoint_header* h, const void* state) {
+    size_t path_length = strlen(path);
+    char* tmp = malloc(path_length + 5);
+    uint8_t* page = calloc(1, CHECKPOINT_ALIGN);
+    if(tmp == NULL || page == NULL) {
+        free(tmp);
+        free(page);
+        return CHECKPOINT_MALLOC_ERROR;
+    }
+    memcpy(tmp, path, path_length);
+    memcpy(tmp + path_length, ".tmp", 5);
+
+    checkpoint_header header = *h;
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.state_offset = CHECKPOINT_ALIGN;
+    memcpy(page, &header, sizeof(header));
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0;
+    ok = ok && __pwrite_all(fd, page, CHECKPOINT_ALIGN, 0);
+    ok = ok && __pwrite_all(fd, state, header.state_bytes, CHECKPOINT_ALIGN);
+    // the data has to be on disk before the rename makes it the checkpoint
+    ok = ok && fsync(fd) == 0;
+    if(fd >= 0)
+        ok = close(fd) == 0 && ok;
+    ok = ok && rename(tmp, path) == 0;
+
+    if(ok)
+        __sync_directory(path);
+    else
+        unlink(tmp);
+    free(tmp);
+    free(page);
+    return ok ? CHECKPOINT_OK : CHECKPOINT_FILE_ERROR;
+}
+
+int checkpoint_open(checkpoint_map* m, const char* path) {
+    memset(m, 0, sizeof(checkpoint_map));
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return CHECKPOINT_FILE_ERROR;
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return CHECKPOINT_FILE_ERROR;
+    }
+    if((size_t) st.st_size < CHECKPOINT_ALIGN) {
+        close(fd);
+        return CHECKPOINT_FORMAT_ERROR;
+    }
+
+    void* base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED)
+        return CHECKPOINT_FILE_ERROR;
+    m->base = base;
+    m->length = (size_t) st.st_size;
+    m->header = (const checkpoint_header*) base;
+
+    const checkpoint_header* h = m->header;
+    int status = CHECKPOINT_OK;
+    if(memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic)) != 0)
+        status = CHECKPOINT_FORMAT_ERROR;
+    else if(h->version > CHECKPOINT_VERSION)
+        status = CHECKPOINT_VERSION_ERROR;
+    else if(h->state_offset % CHECKPOINT_ALIGN != 0 || h->state_offset > m->length
+            || h->state_bytes > m->length - h->state_offset)
+        status = CHECKPOINT_FORMAT_ERROR;
+    if(status != CHECKPOINT_OK) {
+        checkpoint_close(m);
+        return status;
+    }
+
+    m->state = (const uint8_t*) base + h->state_offset;
+    // restores read the state front to back once
+    madvise(base, m->length, MADV_SEQUENTIAL);
+    return CHECKPOINT_OK;
+}
+
+void checkpoint_close(checkpoint_map* m) {
+    if(m->base)
+        munmap(m->base, m->length);
+    memset(m, 0, sizeof(checkpoint_map));
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+static bool __pwrite_all(int fd, const void* data, size_t bytes, off_t offset) {
+    const uint8_t* p = (const uint8_t*) data;
+    while(bytes) {
+        ssize_t written = pwrite(fd, p, bytes < CHECKPOINT_CHUNK ? bytes : CHECKPOINT_CHUNK, offset);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return false;
+        p += written;
+        bytes -= (size_t) written;
+        offset += written;
+    }
+    return true;
+}
+
+// the rename itself only lasts a crash once the directory is synced too
+static void __sync_directory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    char* dir = slash ? strndup(path, slash == path ? 1 : (size_t) (slash - path)) : strdup(".");
+    if(dir == NULL)
+        return;
+    int fd = open(dir, O_RDONLY);
+    if(fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
@@ -0,0 +1,93 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Checkpoints for runs that outlive a process: a one page header (what
+// engine, its rule and parameters, the board's size, the generation and the
+// RNG state) followed by the engine's state as it sits in memory. Two state
+// engines store their packed bits, field engines their values at the
+// field's storage width. The state starts on a page boundary, so a restore
+// maps the file and reads the state straight from the page cache, faulting
+// in only what it touches.
+//
+// A checkpoint is written to path.tmp with pwrite, fsync'd, then renamed
+// over path, so a crash mid write leaves the previous checkpoint whole.
+//
+//     checkpoint_header h;
+//     checkpoint_describe(&h, "life3d", "4555");
+//     h.width = ...; h.generation = ...; h.rng = ...; h.state_bytes = ...;
+//     checkpoint_write("run.ckpt", &h, cells);
+//
+//     checkpoint_map m;
+//     if(checkpoint_open(&m, "run.ckpt") == CHECKPOINT_OK) {
+//         ...m.header->engine, memcpy(cells, m.state, m.header->state_bytes)...
+//         checkpoint_close(&m);
+//     }
+//
+// The file is in the writing machine's byte order, POSIX only.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC "AUTOCKPT"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ALIGN 4096       /* header page, where the state starts */
+#define CHECKPOINT_NAME_MAX 32
+#define CHECKPOINT_PARAMS 12
+
+#define CHECKPOINT_OK 0
+#define CHECKPOINT_FILE_ERROR -1
+#define CHECKPOINT_MALLOC_ERROR -2
+#define CHECKPOINT_FORMAT_ERROR -3
+#define CHECKPOINT_VERSION_ERROR -4
+
+typedef struct {
+    char magic[8];                      // CHECKPOINT_MAGIC, not terminated
+    uint32_t version;
+    uint32_t state_offset;              // multiple of CHECKPOINT_ALIGN
+    char engine[CHECKPOINT_NAME_MAX];   // "life", "lenia", "smoothlife", "lenia3d", "life3d"
+    char rule[CHECKPOINT_NAME_MAX];     // "B3/S23", "4555", empty for the field engines
+    uint64_t width;
+    uint64_t height;
+    uint64_t depth;                     // 1 for the 2D engines
+    uint64_t generation;
+    uint64_t rng;                       // the engine's generator state
+    uint32_t cell_bits;                 // 1 for packed two state cells, else bits per field value
+    uint32_t storage;                   // field_storage of the field engines
+    float params[CHECKPOINT_PARAMS];    // engine parameters, in the engine's own order
+    uint64_t state_bytes;
+} checkpoint_header;
+
+typedef struct {
+    void* base;                         // the whole file, read only
+    size_t length;
+    const checkpoint_header* header;
+    const void* state;                  // header->state_bytes, page aligned
+} checkpoint_map;
+
+/* Zero h and name its engine and rule, the rest is the caller's to fill */
+void checkpoint_describe(checkpoint_header* h, const char* engine, const char* rule);
+
+/*  Write h and state_bytes of state to path by way of path.tmp. magic,
+    version and state_offset are filled in here.
+
+    Returns:
+        CHECKPOINT_OK once the checkpoint is on disk under path
+        CHECKPOINT_MALLOC_ERROR if the header page could not be allocated
+        CHECKPOINT_FILE_ERROR if writing failed, path is left as it was
+*/
+int checkpoint_write(const char* path, const checkpoint_header* h, const void* state);
+
+/*  Map the checkpoint at path
+
+    Returns:
+        CHECKPOINT_OK on success
+        CHECKPOINT_FILE_ERROR if the file could not be opened or mapped
+        CHECKPOINT_FORMAT_ERROR if it isn't a checkpoint or is cut short
+        CHECKPOINT_VERSION_ERROR if it was written by a newer version
+*/
+int checkpoint_open(checkpoint_map* m, const char* path);
+
+/* Unmap the file, m->state is gone after this */
+void checkpoint_close(checkpoint_map* m);
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+
+#include "density.h"
+
+/* PRIVATE FUNCTIONS */
+static uint8_t __level_one(const density_pyramid* d, const uint64_t* bits, size_t r, size_t c);
+static uint8_t __average(const density_pyramid* d, unsigned level, size_t r, size_t c);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int density_init(density_pyramid* d, size_t board_rows, size_t board_cols) {
+    d->board_rows = board_rows;
+    d->board_cols = board_cols;
+    d->count = 0;
+
+    size_t rows = board_rows, cols = board_cols;
+    while((rows > 1 || cols > 1) && d->count < DENSITY_MAX_LEVELS) {
+        rows = (rows + 1) / 2;
+        cols = (cols + 1) / 2;
+        d->count++;
+        d->rows[d->count] = rows;
+        d->cols[d->count] = cols;
+        d->levels[d->count] = calloc(rows * cols, sizeof(uint8_t));
+        if(d->levels[d->count] == NULL) {
+            density_destroy(d);
+            return DENSITY_MALLOC_ERROR;
+        }
+    }
+    return DENSITY_OK;
+}
+
+void density_destroy(density_pyramid* d) {
+    for(unsigned l = 1; l <= d->count; l++) {
+        free(d->levels[l]);
+        d->levels[l] = NULL;
+    }
+    d->count = 0;
+}
+
+void density_update_block(density_pyramid* d, const uint64_t* bits, size_t i0, size_t i1, size_t j0, size_t j1) {
+    if(i0 >= i1 || j0 >= j1 || d->count == 0)
+        return;
+
+    // the blocks covering the cells on each level shrink by half per level
+    size_t r0 = i0 >> 1, r1 = (i1 - 1) >> 1;
+    size_t c0 = j0 >> 1, c1 = (j1 - 1) >> 1;
+    for(size_t r = r0; r <= r1; r++)
+        for(size_t c = c0; c <= c1; c++)
+            d->levels[1][r * d->cols[1] + c] = __level_one(d, bits, r, c);
+
+    for(unsigned l = 2; l <= d->count; l++) {
+        r0 >>= 1; r1 >>= 1;
+        c0 >>= 1; c1 >>= 1;
+        for(size_t r = r0; r <= r1; r++)
+            for(size_t c = c0; c <= c1; c++)
+                d->levels[l][r * d->cols[l] + c] = __average(d, l - 1, r, c);
+    }
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+// share of the (up to) four live cells of block (r, c), rounded
+static uint8_t __level_one(const density_pyramid* d, const uint64_t* bits, size_t r, size_t c) {
+    unsigned alive = 0, cells = 0;
+    for(size_t i = 2 * r; i < 2 * r + 2 && i < d->board_rows; i++) {
+        for(size_t j = 2 * c; j < 2 * c + 2 && j < d->board_cols; j++) {
+            size_t k = i * d->board_cols + j;
+            alive += (bits[k / 64] >> (k % 64)) & 1;
+            cells++;
+        }
+    }
+    return (uint8_t) ((alive * 255 + cells / 2) / cells);
+}
+
+// mean of the (up to) four blocks under block (r, c) of the level above
+static uint8_t __average(const density_pyramid* d, unsigned level, size_t r, size_t c) {
+    unsigned sum = 0, blocks = 0;
+    for(size_t i = 2 * r; i < 2 * r + 2 && i < d->rows[level]; i++) {
+        for(size_t j = 2 * c; j < 2 * c + 2 && j < d->cols[level]; j++) {
+            sum += d->levels[level][i * d->cols[level] + j];
+            blocks++;
+        }
+    }
+    return (uint8_t) ((sum + blocks / 2) / blocks);
+}
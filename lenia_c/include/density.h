@@ -0,0 +1,49 @@
+#ifndef DENSITY_H
+#define DENSITY_H
+
+// Population density pyramid of a packed two state board, for drawing it
+// zoomed out. Level l holds one byte per 2^l x 2^l block of cells, the share
+// of live cells scaled to 0 .. 255, so a level can go to the screen as a
+// grey level as is. Level 1 is counted from the cells, every level above
+// averages the (up to) four blocks below. Blocks hanging over the board edge
+// only average what is on the board.
+//
+// Updates are by region: density_update_block recomputes the blocks over a
+// rectangle of cells on every level, so keeping the pyramid in step with a
+// board only costs the area that changed plus one block per level.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DENSITY_MAX_LEVELS 32
+
+typedef struct {
+    uint8_t* levels[DENSITY_MAX_LEVELS + 1];    // levels[1 .. count], levels[0] unused
+    size_t rows[DENSITY_MAX_LEVELS + 1];        // blocks per level, rows x cols
+    size_t cols[DENSITY_MAX_LEVELS + 1];
+    unsigned count;                             // the top level is one block
+    size_t board_rows;                          // board of board_rows x board_cols cells,
+    size_t board_cols;                          // cell (i, j) is bit i * board_cols + j
+} density_pyramid;
+
+#define DENSITY_OK 0
+#define DENSITY_MALLOC_ERROR -2
+
+/*  Levels for a board_rows x board_cols board, all zero (an empty board)
+
+    Returns:
+        DENSITY_OK on success
+        DENSITY_MALLOC_ERROR if a level could not be allocated
+*/
+int density_init(density_pyramid* d, size_t board_rows, size_t board_cols);
+
+void density_destroy(density_pyramid* d);
+
+/* Recompute every block over cells [i0, i1) x [j0, j1) from the packed board, on every level */
+void density_update_block(density_pyramid* d, const uint64_t* bits, size_t i0, size_t i1, size_t j0, size_t j1);
+
+static inline uint8_t density_at(const density_pyramid* d, unsigned level, size_t row, size_t col) {
+    return d->levels[level][row * d->cols[level] + col];
+}
+
+#endif
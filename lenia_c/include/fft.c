@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "fft.h"
+
+#define FFT_BLOCK 16    /* columns gathered per pass over a strided axis */
+
+/* PRIVATE FUNCTIONS */
+static size_t __next_pow2(size_t n);
+static void __radix2(const fft_plan* p, float complex* a, bool inverse);
+static void __bluestein(const fft_plan* p, float complex* a, bool inverse, float complex* scratch);
+static int __init_radix2(fft_plan* p, size_t m);
+static int __init_work(fft_plan* p);
+static float complex* __worker_work(const fft_plan* p);
+static void __fft3d(const fft3d* f, float complex* data, bool inverse);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int fft_plan_init(fft_plan* p, size_t n) {
+    memset(p, 0, sizeof(fft_plan));
+    p->n = n;
+
+    if((n & (n - 1)) == 0)
+        return __init_radix2(p, n) == FFT_OK ? __init_work(p) : FFT_MALLOC_ERROR;
+
+    size_t m = __next_pow2(2 * n - 1);
+    if(__init_radix2(p, m) != FFT_OK)
+        return FFT_MALLOC_ERROR;
+
+    p->chirp = malloc(n * sizeof(float complex));
+    p->chirp_fft = calloc(m, sizeof(float complex));
+    if(p->chirp == NULL || p->chirp_fft == NULL) {
+        fft_plan_destroy(p);
+        return FFT_MALLOC_ERROR;
+    }
+
+    // exp(-pi i k^2 / n), k^2 reduced mod 2n in integers to keep the phase exact
+    for(size_t k = 0; k < n; k++) {
+        unsigned long long k2 = ((unsigned long long) k * k) % (2 * n);
+        double phase = -M_PI * (double) k2 / (double) n;
+        p->chirp[k] = (float) cos(phase) + (float) sin(phase) * I;
+    }
+
+    p->chirp_fft[0] = conjf(p->chirp[0]);
+    for(size_t k = 1; k < n; k++) {
+        p->chirp_fft[k] = conjf(p->chirp[k]);
+        p->chirp_fft[m - k] = conjf(p->chirp[k]);
+    }
+    __radix2(p, p->chirp_fft, false);
+
+    return __init_work(p);
+}
+
+void fft_plan_destroy(fft_plan* p) {
+    free(p->bitrev);
+    free(p->twiddle);
+    free(p->chirp);
+    free(p->chirp_fft);
+    free(p->work);
+    memset(p, 0, sizeof(fft_plan));
+}
+
+size_t fft_scratch_len(const fft_plan* p) {
+    return p->chirp ? p->m : 0;
+}
+
+void fft_execute(const fft_plan* p, float complex* data, bool inverse, float complex* scratch) {
+    if(p->chirp)
+        __bluestein(p, data, inverse, scratch);
+    else
+        __radix2(p, data, inverse);
+}
+
+void fft_execute_many(const fft_plan* p, float complex* data, size_t count, size_t stride, size_t dist, bool inverse) {
+    const size_t n = p->n;
+
+    if(stride == 1) {
+        #pragma omp parallel num_threads(p->workers)
+        {
+            float complex* scratch = __worker_work(p) + FFT_BLOCK * n;
+
+            #pragma omp for schedule(static)
+            for(size_t v = 0; v < count; v++)
+                fft_execute(p, data + v * dist, inverse, scratch);
+        }
+        return;
+    }
+
+    // strided axis: gather FFT_BLOCK neighbouring vectors per sweep when they are adjacent
+    const size_t block = dist == 1 ? FFT_BLOCK : 1;
+    const size_t blocks = (count + block - 1) / block;
+
+    #pragma omp parallel num_threads(p->workers)
+    {
+        float complex* buf = __worker_work(p);
+        float complex* scratch = buf + FFT_BLOCK * n;
+
+        #pragma omp for schedule(static)
+        for(size_t b = 0; b < blocks; b++) {
+            size_t v0 = b * block, nv = count - v0 < block ? count - v0 : block;
+
+            for(size_t k = 0; k < n; k++)
+                for(size_t v = 0; v < nv; v++)
+                    buf[v * n + k] = data[(v0 + v) * dist + k * stride];
+
+            for(size_t v = 0; v < nv; v++)
+                fft_execute(p, buf + v * n, inverse, scratch);
+
+            for(size_t k = 0; k < n; k++)
+                for(size_t v = 0; v < nv; v++)
+                    data[(v0 + v) * dist + k * stride] = buf[v * n + k];
+        }
+    }
+}
+
+int fft2d_init(fft2d* f, size_t width, size_t height) {
+    f->width = width;
+    f->height = height;
+    memset(&f->rows, 0, sizeof(fft_plan));
+    memset(&f->cols, 0, sizeof(fft_plan));
+
+    if(fft_plan_init(&f->rows, width) != FFT_OK || fft_plan_init(&f->cols, height) != FFT_OK) {
+        fft2d_destroy(f);
+        return FFT_MALLOC_ERROR;
+    }
+
+    return FFT_OK;
+}
+
+void fft2d_destroy(fft2d* f) {
+    fft_plan_destroy(&f->rows);
+    fft_plan_destroy(&f->cols);
+}
+
+void fft2d_forward(const fft2d* f, float complex* data) {
+    fft_execute_many(&f->rows, data, f->height, 1, f->width, false);
+    fft_execute_many(&f->cols, data, f->width, f->width, 1, false);
+}
+
+void fft2d_inverse(const fft2d* f, float complex* data) {
+    const size_t n = f->width * f->height;
+    const float scale = 1.0f / (float) n;
+
+    fft_execute_many(&f->rows, data, f->height, 1, f->width, true);
+    fft_execute_many(&f->cols, data, f->width, f->width, 1, true);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < n; i++)
+        data[i] *= scale;
+}
+
+int fft3d_init(fft3d* f, size_t width, size_t height, size_t depth) {
+    f->width = width;
+    f->height = height;
+    f->depth = depth;
+    memset(&f->x, 0, sizeof(fft_plan));
+    memset(&f->y, 0, sizeof(fft_plan));
+    memset(&f->z, 0, sizeof(fft_plan));
+
+    if(fft_plan_init(&f->x, width) != FFT_OK || fft_plan_init(&f->y, height) != FFT_OK
+        || fft_plan_init(&f->z, depth) != FFT_OK) {
+        fft3d_destroy(f);
+        return FFT_MALLOC_ERROR;
+    }
+
+    return FFT_OK;
+}
+
+void fft3d_destroy(fft3d* f) {
+    fft_plan_destroy(&f->x);
+    fft_plan_destroy(&f->y);
+    fft_plan_destroy(&f->z);
+}
+
+void fft3d_forward(const fft3d* f, float complex* data) {
+    __fft3d(f, data, false);
+}
+
+void fft3d_inverse(const fft3d* f, float complex* data) {
+    const size_t n = f->width * f->height * f->depth;
+    const float scale = 1.0f / (float) n;
+
+    __fft3d(f, data, true);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < n; i++)
+        data[i] *= scale;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static size_t __next_pow2(size_t n) {
+    size_t m = 1;
+    while(m < n)
+        m <<= 1;
+    return m;
+}
+
+static int __init_radix2(fft_plan* p, size_t m) {
+    p->m = m;
+    p->bitrev = malloc(m * sizeof(size_t));
+    p->twiddle = malloc((m / 2 + 1) * sizeof(float complex));
+    if(p->bitrev == NULL || p->twiddle == NULL) {
+        fft_plan_destroy(p);
+        return FFT_MALLOC_ERROR;
+    }
+
+    size_t bits = 0;
+    while(((size_t) 1 << bits) < m)
+        bits++;
+
+    for(size_t i = 0; i < m; i++) {
+        size_t r = 0;
+        for(size_t b = 0; b < bits; b++)
+            if(i & ((size_t) 1 << b))
+                r |= (size_t) 1 << (bits - 1 - b);
+        p->bitrev[i] = r;
+    }
+
+    for(size_t k = 0; k < m / 2 + 1; k++) {
+        double phase = -2.0 * M_PI * (double) k / (double) m;
+        p->twiddle[k] = (float) cos(phase) + (float) sin(phase) * I;
+    }
+
+    return FFT_OK;
+}
+
+// the gather block and scratch of every worker, allocated with the plan so a transform can't fail
+static int __init_work(fft_plan* p) {
+    p->workers = 1;
+#ifdef _OPENMP
+    p->workers = (size_t) omp_get_max_threads();
+#endif
+    p->work = malloc(p->workers * (FFT_BLOCK * p->n + fft_scratch_len(p)) * sizeof(float complex));
+    if(p->work == NULL) {
+        fft_plan_destroy(p);
+        return FFT_MALLOC_ERROR;
+    }
+    return FFT_OK;
+}
+
+static float complex* __worker_work(const fft_plan* p) {
+    size_t t = 0;
+#ifdef _OPENMP
+    t = (size_t) omp_get_thread_num();
+#endif
+    return p->work + t * (FFT_BLOCK * p->n + fft_scratch_len(p));
+}
+
+static void __radix2(const fft_plan* p, float complex* a, bool inverse) {
+    const size_t m = p->m;
+
+    for(size_t i = 0; i < m; i++) {
+        size_t r = p->bitrev[i];
+        if(i < r) {
+            float complex t = a[i];
+            a[i] = a[r];
+            a[r] = t;
+        }
+    }
+
+    for(size_t len = 2; len <= m; len <<= 1) {
+        size_t half = len / 2, step = m / len;
+        for(size_t i = 0; i < m; i += len) {
+            for(size_t k = 0; k < half; k++) {
+                float complex w = p->twiddle[k * step];
+                if(inverse)
+                    w = conjf(w);
+
+                float complex u = a[i + k];
+                float complex v = a[i + k + half] * w;
+                a[i + k] = u + v;
+                a[i + k + half] = u - v;
+            }
+        }
+    }
+}
+
+static void __bluestein(const fft_plan* p, float complex* a, bool inverse, float complex* scratch) {
+    const size_t n = p->n, m = p->m;
+    const float scale = 1.0f / (float) m;
+
+    // the inverse DFT is the conjugate of the forward DFT of the conjugate
+    for(size_t k = 0; k < n; k++)
+        scratch[k] = (inverse ? conjf(a[k]) : a[k]) * p->chirp[k];
+    memset(scratch + n, 0, (m - n) * sizeof(float complex));
+
+    __radix2(p, scratch, false);
+    for(size_t k = 0; k < m; k++)
+        scratch[k] *= p->chirp_fft[k];
+    __radix2(p, scratch, true);
+
+    for(size_t k = 0; k < n; k++) {
+        float complex v = scratch[k] * scale * p->chirp[k];
+        a[k] = inverse ? conjf(v) : v;
+    }
+}
+
+static void __fft3d(const fft3d* f, float complex* data, bool inverse) {
+    const size_t w = f->width, h = f->height, d = f->depth;
+
+    fft_execute_many(&f->x, data, h * d, 1, w, inverse);
+    for(size_t z = 0; z < d; z++)
+        fft_execute_many(&f->y, data + z * w * h, w, w, 1, inverse);
+    if(d > 1)
+        fft_execute_many(&f->z, data, w * h, w * h, 1, inverse);
+}
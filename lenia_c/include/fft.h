@@ -0,0 +1,79 @@
+#ifndef FFT_H
+#define FFT_H
+
+// Single precision complex FFT. Power of two lengths use an iterative radix-2
+// transform, anything else goes through Bluestein on the next power of two
+// so boards don't have to be sized for the FFT.
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    size_t n;                   // transform length
+    size_t m;                   // radix-2 length actually run (n, or >= 2n - 1 for Bluestein)
+    size_t* bitrev;             // m
+    float complex* twiddle;     // m / 2, exp(-2 pi i k / m)
+    float complex* chirp;       // n, Bluestein only
+    float complex* chirp_fft;   // m, Bluestein only
+    size_t workers;             // threads fft_execute_many runs on
+    float complex* work;        // per worker, a block of gathered vectors and the Bluestein scratch
+} fft_plan;
+
+typedef struct {
+    size_t width;
+    size_t height;
+    fft_plan rows;
+    fft_plan cols;
+} fft2d;
+
+typedef struct {
+    size_t width;
+    size_t height;
+    size_t depth;
+    fft_plan x;
+    fft_plan y;
+    fft_plan z;
+} fft3d;
+
+#define FFT_OK 0
+#define FFT_MALLOC_ERROR -2
+
+int fft_plan_init(fft_plan* p, size_t n);
+void fft_plan_destroy(fft_plan* p);
+
+/* Complex elements of scratch fft_execute needs (0 for power of two lengths) */
+size_t fft_scratch_len(const fft_plan* p);
+
+/* In place, unnormalized transform of n contiguous elements */
+void fft_execute(const fft_plan* p, float complex* data, bool inverse, float complex* scratch);
+
+/*  Transform count vectors of n elements, element k of vector v at
+    data[v * dist + k * stride]. Runs in parallel over the vectors.
+*/
+void fft_execute_many(const fft_plan* p, float complex* data, size_t count, size_t stride, size_t dist, bool inverse);
+
+/*  2D transform of a row major width x height array
+
+    Returns:
+        FFT_OK on success
+        FFT_MALLOC_ERROR if a plan could not be allocated
+*/
+int fft2d_init(fft2d* f, size_t width, size_t height);
+void fft2d_destroy(fft2d* f);
+
+void fft2d_forward(const fft2d* f, float complex* data);
+
+/* Inverse, normalized by 1 / (width * height) */
+void fft2d_inverse(const fft2d* f, float complex* data);
+
+/* 3D transform of a width x height x depth array, x fastest then y then z */
+int fft3d_init(fft3d* f, size_t width, size_t height, size_t depth);
+void fft3d_destroy(fft3d* f);
+
+void fft3d_forward(const fft3d* f, float complex* data);
+
+/* Inverse, normalized by 1 / (width * height * depth) */
+void fft3d_inverse(const fft3d* f, float complex* data);
+
+#endif
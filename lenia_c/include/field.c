@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#include "field.h"
+
+#define U16_SCALE 65535.0f
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int field_init(field_t* f, size_t width, size_t height, field_storage storage) {
+    f->width = width;
+    f->height = height;
+    f->storage = storage;
+    f->data = calloc(width * height, field_cell_bytes(storage));
+    if(f->data == NULL)
+        return FIELD_MALLOC_ERROR;
+
+    return FIELD_OK;
+}
+
+void field_destroy(field_t* f) {
+    free(f->data);
+    f->data = NULL;
+    f->width = 0;
+    f->height = 0;
+}
+
+size_t field_cell_bytes(field_storage storage) {
+    return storage == FIELD_F32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+size_t field_bytes(const field_t* f) {
+    return f->width * f->height * field_cell_bytes(f->storage);
+}
+
+void field_load_row(const field_t* f, size_t row, float* out) {
+    size_t x = 0, n = f->width;
+
+    switch(f->storage) {
+        case FIELD_F32:
+            memcpy(out, (const float*) f->data + row * n, n * sizeof(float));
+            break;
+
+        case FIELD_F16: {
+            const uint16_t* src = (const uint16_t*) f->data + row * n;
+#ifdef __F16C__
+            for(; x + 8 <= n; x += 8)
+                _mm256_storeu_ps(out + x, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) (src + x))));
+#endif
+            for(; x < n; x++)
+                out[x] = field_half_to_float(src[x]);
+            break;
+        }
+
+        case FIELD_U16: {
+            const uint16_t* src = (const uint16_t*) f->data + row * n;
+            for(; x < n; x++)
+                out[x] = (float) src[x] * (1.0f / U16_SCALE);
+            break;
+        }
+    }
+}
+
+void field_store_row(field_t* f, size_t row, const float* in) {
+    size_t x = 0, n = f->width;
+
+    switch(f->storage) {
+        case FIELD_F32:
+            memcpy((float*) f->data + row * n, in, n * sizeof(float));
+            break;
+
+        case FIELD_F16: {
+            uint16_t* dst = (uint16_t*) f->data + row * n;
+#ifdef __F16C__
+            for(; x + 8 <= n; x += 8)
+                _mm_storeu_si128((__m128i*) (dst + x), _mm256_cvtps_ph(_mm256_loadu_ps(in + x), _MM_FROUND_TO_NEAREST_INT));
+#endif
+            for(; x < n; x++)
+                dst[x] = field_float_to_half(in[x]);
+            break;
+        }
+
+        case FIELD_U16: {
+            uint16_t* dst = (uint16_t*) f->data + row * n;
+            for(; x < n; x++) {
+                float v = in[x] < 0.0f ? 0.0f : (in[x] > 1.0f ? 1.0f : in[x]);
+                dst[x] = (uint16_t) (v * U16_SCALE + 0.5f);
+            }
+            break;
+        }
+    }
+}
+
+float field_get(const field_t* f, size_t x, size_t y) {
+    size_t idx = y * f->width + x;
+
+    switch(f->storage) {
+        case FIELD_F16:
+            return field_half_to_float(((const uint16_t*) f->data)[idx]);
+        case FIELD_U16:
+            return (float) ((const uint16_t*) f->data)[idx] * (1.0f / U16_SCALE);
+        default:
+            return ((const float*) f->data)[idx];
+    }
+}
+
+void field_set(field_t* f, size_t x, size_t y, float v) {
+    size_t idx = y * f->width + x;
+
+    switch(f->storage) {
+        case FIELD_F16:
+            ((uint16_t*) f->data)[idx] = field_float_to_half(v);
+            break;
+        case FIELD_U16:
+            v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+            ((uint16_t*) f->data)[idx] = (uint16_t) (v * U16_SCALE + 0.5f);
+            break;
+        default:
+            ((float*) f->data)[idx] = v;
+            break;
+    }
+}
+
+void field_clear(field_t* f) {
+    memset(f->data, 0, field_bytes(f));
+}
+
+const char* field_storage_name(field_storage storage) {
+    switch(storage) {
+        case FIELD_F16:
+            return "f16";
+        case FIELD_U16:
+            return "u16";
+        default:
+            return "f32";
+    }
+}
+
+int field_storage_parse(const char* name, field_storage* storage) {
+    if(strcmp(name, "f32") == 0)
+        *storage = FIELD_F32;
+    else if(strcmp(name, "f16") == 0)
+        *storage = FIELD_F16;
+    else if(strcmp(name, "u16") == 0)
+        *storage = FIELD_U16;
+    else
+        return FIELD_INVALID;
+
+    return FIELD_OK;
+}
+
+// Round-to-nearest-even float -> half, handles subnormals, inf and nan
+uint16_t field_float_to_half(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t mant = x & 0x7fffff;
+    int32_t exp = (int32_t) ((x >> 23) & 0xff) - 127 + 15;
+
+    if(((x >> 23) & 0xff) == 0xff)
+        return (uint16_t) (sign | 0x7c00 | (mant ? 0x200 : 0));
+
+    if(exp >= 31)
+        return (uint16_t) (sign | 0x7c00);
+
+    if(exp <= 0) {
+        if(exp < -10)
+            return (uint16_t) sign;
+
+        mant |= 0x800000;
+        uint32_t shift = (uint32_t) (14 - exp);
+        uint32_t h = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(rem > halfway || (rem == halfway && (h & 1)))
+            h++;
+        return (uint16_t) (sign | h);
+    }
+
+    uint32_t h = sign | ((uint32_t) exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1fff;
+    // a carry out of the mantissa correctly bumps the exponent
+    if(rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        h++;
+
+    return (uint16_t) h;
+}
+
+float field_half_to_float(uint16_t h) {
+    uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+    int32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t x;
+
+    if(exp == 0) {
+        if(mant == 0) {
+            x = sign;
+        } else {
+            // subnormal, renormalize
+            exp = 1;
+            while(!(mant & 0x400)) {
+                mant <<= 1;
+                exp--;
+            }
+            mant &= 0x3ff;
+            x = sign | ((uint32_t) (exp + 112) << 23) | (mant << 13);
+        }
+    } else if(exp == 31) {
+        x = sign | 0x7f800000 | (mant << 13);
+    } else {
+        x = sign | ((uint32_t) (exp + 112) << 23) | (mant << 13);
+    }
+
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
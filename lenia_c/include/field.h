@@ -0,0 +1,59 @@
+#ifndef FIELD_H
+#define FIELD_H
+
+// Scalar state grid for the continuous engines (Lenia and friends).
+// Values live in [0, 1] and can be stored in reduced precision; the compute
+// kernels only ever see fp32 rows produced by field_load_row.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    FIELD_F32 = 0,  // plain float, 4 bytes per cell
+    FIELD_F16 = 1,  // IEEE half, 2 bytes per cell
+    FIELD_U16 = 2   // unsigned 16 bit fixed point (v * 65535), 2 bytes per cell
+} field_storage;
+
+typedef struct {
+    void* data;
+    size_t width;
+    size_t height;
+    field_storage storage;
+} field_t;
+
+#define FIELD_OK 0
+#define FIELD_INVALID -1
+#define FIELD_MALLOC_ERROR -2
+
+/*  Allocate a zeroed width x height field using the given storage mode
+
+    Returns:
+        FIELD_OK on success
+        FIELD_MALLOC_ERROR if the buffer could not be allocated
+*/
+int field_init(field_t* f, size_t width, size_t height, field_storage storage);
+
+void field_destroy(field_t* f);
+
+/* Bytes per cell / total bytes of the backing buffer */
+size_t field_cell_bytes(field_storage storage);
+size_t field_bytes(const field_t* f);
+
+/* Convert one row to / from fp32 (out / in must hold width floats) */
+void field_load_row(const field_t* f, size_t row, float* out);
+void field_store_row(field_t* f, size_t row, const float* in);
+
+/* Single cell access, for seeding and drawing, not for the hot loop */
+float field_get(const field_t* f, size_t x, size_t y);
+void field_set(field_t* f, size_t x, size_t y, float v);
+
+void field_clear(field_t* f);
+
+/* "f32" / "f16" / "u16" <-> field_storage, parse returns FIELD_INVALID on unknown names */
+const char* field_storage_name(field_storage storage);
+int field_storage_parse(const char* name, field_storage* storage);
+
+uint16_t field_float_to_half(float f);
+float field_half_to_float(uint16_t h);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+// Exact membership for cell indices on a bounded board: one bit per cell plus
+// the list of indices set so far, so clearing only touches what was added.
+// Return codes follow set.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "set.h"
+
+// Append only buffer owned by one thread, padded so neighbours don't share a line
+typedef struct {
+    uint64_t* items;
+    uint64_t length;
+    uint64_t capacity;
+    uint64_t start;         // offset in list, set by frontier_merge
+    char _pad[64 - sizeof(uint64_t*) - 3 * sizeof(uint64_t)];
+} frontier_local;
+
+typedef struct {
+    uint64_t* bits;         // number_cells bits
+    uint64_t* list;         // indices in insertion order, length entries
+    uint64_t length;
+    uint64_t number_cells;
+    frontier_local* local;  // per thread buffers, NULL until frontier_init_local
+    int threads;
+} Frontier;
+
+/*  Initialize the frontier for indices 0 .. number_cells - 1
+
+    Returns:
+        SET_MALLOC_ERROR: If an error occured setting up the memory
+        SET_TRUE: On success
+*/
+int frontier_init(Frontier *f, uint64_t number_cells);
+
+/* Free all memory that is part of the frontier */
+int frontier_destroy(Frontier *f);
+
+/* Empty the frontier, cost is proportional to its length */
+int frontier_clear(Frontier *f);
+
+/*  Add a cell index
+
+    Returns:
+        SET_TRUE if added
+        SET_ALREADY_PRESENT if already present
+*/
+int frontier_add(Frontier *f, uint64_t index);
+
+/*  Add count indices first, first + stride, ... wrapping around past
+    number_cells, so a row of cells on a board stored column by column (or a
+    column of a row major one) goes in with one call. first < number_cells.
+
+    Returns:
+        how many of them were not already present
+*/
+uint64_t frontier_add_run(Frontier *f, uint64_t first, uint64_t count, uint64_t stride);
+
+/* Same as frontier_add but safe to call from several threads at once */
+int frontier_add_atomic(Frontier *f, uint64_t index);
+
+/*  Give each of threads workers a private buffer for frontier_add_local
+
+    Returns:
+        SET_MALLOC_ERROR: If an error occured setting up the memory
+        SET_TRUE: On success
+*/
+int frontier_init_local(Frontier *f, int threads);
+
+/*  Claim the cell in the shared bitmap and append it to the thread's own
+    buffer, so the only contention between threads is on bitmap words.
+    Not visible in list until frontier_merge.
+
+    Returns:
+        SET_TRUE if added
+        SET_ALREADY_PRESENT if already present
+        SET_MALLOC_ERROR if the thread's buffer could not grow
+*/
+int frontier_add_local(Frontier *f, int thread, uint64_t index);
+
+/*  Append every thread's buffer to list: the offsets come from a prefix sum
+    over the buffer lengths so the copies run in parallel. Call after the
+    parallel region, the local buffers are emptied.
+*/
+void frontier_merge(Frontier *f);
+
+static __inline__ int frontier_contains(const Frontier *f, uint64_t index) {
+    return (f->bits[index >> 6] >> (index & 63)) & 1 ? SET_TRUE : SET_FALSE;
+}
+
+static __inline__ uint64_t frontier_length(const Frontier *f) {
+    return f->length;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* END FRONTIER HEADER */
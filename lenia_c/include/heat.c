@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "heat.h"
+
+/* PRIVATE FUNCTIONS */
+static uint32_t __lerp(uint32_t from, uint32_t to, uint32_t t);
+static void __warm(heat_plane* h, size_t i, size_t j, uint32_t generation);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int heat_init(heat_plane* h, size_t board_rows, size_t board_cols, unsigned shift, heat_palette palette) {
+    const size_t cells = board_rows * board_cols;
+    h->board_rows = board_rows;
+    h->board_cols = board_cols;
+    h->shift = shift;
+    h->tiles_x = (board_cols + ((size_t) 1 << shift) - 1) >> shift;
+    h->tiles_y = (board_rows + ((size_t) 1 << shift) - 1) >> shift;
+    h->warm_count = 0;
+    h->palette = palette;
+
+    // one spare word, spans read a word past the one their last cell is in
+    h->stamps = malloc((cells + 1) * sizeof(uint32_t));
+    h->bits = calloc((cells + 63) / 64 + 1, sizeof(uint64_t));
+    h->tile_stamps = calloc(h->tiles_x * h->tiles_y + 1, sizeof(uint32_t));
+    h->listed = calloc(h->tiles_x * h->tiles_y + 1, sizeof(bool));
+    h->warm = malloc((h->tiles_x * h->tiles_y + 1) * sizeof(size_t));
+    if(h->stamps == NULL || h->bits == NULL || h->tile_stamps == NULL || h->listed == NULL || h->warm == NULL) {
+        heat_destroy(h);
+        return HEAT_MALLOC_ERROR;
+    }
+
+    heat_reset(h, h->bits, 0);
+    return HEAT_OK;
+}
+
+void heat_destroy(heat_plane* h) {
+    free(h->stamps);
+    free(h->bits);
+    free(h->tile_stamps);
+    free(h->listed);
+    free(h->warm);
+    h->stamps = NULL;
+    h->bits = NULL;
+    h->tile_stamps = NULL;
+    h->listed = NULL;
+    h->warm = NULL;
+    h->warm_count = 0;
+}
+
+void heat_reset(heat_plane* h, const uint64_t* bits, uint32_t generation) {
+    const size_t cells = h->board_rows * h->board_cols;
+    if(bits != h->bits)
+        memcpy(h->bits, bits, (cells + 63) / 64 * sizeof(uint64_t));
+    for(size_t k = 0; k < cells; k++)
+        h->stamps[k] = generation - HEAT_SPAN;
+    for(size_t k = 0; k < h->warm_count; k++)
+        h->listed[h->warm[k]] = false;
+    h->warm_count = 0;
+}
+
+void heat_update_block(heat_plane* h, const uint64_t* bits, size_t i0, size_t i1, size_t j0, size_t j1, uint32_t generation) {
+    for(size_t i = i0; i < i1; i++) {
+        size_t k = i * h->board_cols + j0, end = i * h->board_cols + j1;
+        // a word at a time, only the flipped bits cost anything
+        while(k < end) {
+            size_t w = k / 64, off = k % 64;
+            size_t take = 64 - off < end - k ? 64 - off : end - k;
+            uint64_t mask = (take == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << take) - 1) << off;
+            uint64_t flipped = (h->bits[w] ^ bits[w]) & mask;
+            h->bits[w] ^= flipped;
+            for(; flipped; flipped &= flipped - 1) {
+                size_t cell = w * 64 + __builtin_ctzll(flipped);
+                h->stamps[cell] = generation;
+                __warm(h, i, cell - i * h->board_cols, generation);
+            }
+            k += take;
+        }
+    }
+}
+
+void heat_cool(heat_plane* h, uint32_t generation) {
+    size_t kept = 0;
+    for(size_t k = 0; k < h->warm_count; k++) {
+        size_t tile = h->warm[k];
+        if(generation - h->tile_stamps[tile] < HEAT_SPAN)
+            h->warm[kept++] = tile;
+        else
+            h->listed[tile] = false;
+    }
+    h->warm_count = kept;
+}
+
+uint32_t heat_color(const heat_plane* h, size_t i, size_t j, uint32_t generation) {
+    size_t k = i * h->board_cols + j;
+    uint32_t age = generation - h->stamps[k];
+    uint32_t t = age < HEAT_SPAN ? age : HEAT_SPAN;
+    if((h->bits[k / 64] >> (k % 64)) & 1)
+        return __lerp(h->palette.young, h->palette.old, t);
+    return __lerp(h->palette.died, h->palette.faded, t);
+}
+
+// every channel is from + ((to - from) * t >> HEAT_SHIFT), t in 0 .. HEAT_SPAN
+void heat_span(const heat_plane* h, uint32_t* out, size_t i, size_t j, size_t count, uint32_t generation) {
+    size_t k = i * h->board_cols + j;
+    size_t n = 0;
+
+#ifdef __SSE2__
+    const __m128i young = _mm_set1_epi32((int) h->palette.young);
+    const __m128i old = _mm_set1_epi32((int) h->palette.old);
+    const __m128i died = _mm_set1_epi32((int) h->palette.died);
+    const __m128i faded = _mm_set1_epi32((int) h->palette.faded);
+    const __m128i gen = _mm_set1_epi32((int) generation);
+    const __m128i span = _mm_set1_epi32(HEAT_SPAN);
+    const __m128i sign = _mm_set1_epi32((int) 0x80000000u);
+    const __m128i lanes = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    for(; n + 4 <= count; n += 4, k += 4) {
+        // ages clamped to the span, an unsigned compare through the sign bit
+        __m128i age = _mm_sub_epi32(gen, _mm_loadu_si128((const __m128i*) (h->stamps + k)));
+        __m128i past = _mm_cmpgt_epi32(_mm_xor_si128(age, sign), _mm_xor_si128(span, sign));
+        __m128i t = _mm_or_si128(_mm_andnot_si128(past, age), _mm_and_si128(past, span));
+
+        // the four alive bits, which may straddle two words
+        size_t w = k / 64, off = k % 64;
+        uint64_t nibble = h->bits[w] >> off;
+        if(off > 60)
+            nibble |= h->bits[w + 1] << (64 - off);
+        __m128i live = _mm_set1_epi32((int) (nibble & 15));
+        live = _mm_cmpeq_epi32(_mm_and_si128(live, lanes), lanes);
+
+        // pick each cell's ramp
+        __m128i from = _mm_or_si128(_mm_and_si128(live, young), _mm_andnot_si128(live, died));
+        __m128i to = _mm_or_si128(_mm_and_si128(live, old), _mm_andnot_si128(live, faded));
+
+        // t of each cell over its four channels, as 16 bit lanes
+        __m128i t_lo = _mm_unpacklo_epi32(t, t);
+        __m128i t_hi = _mm_unpackhi_epi32(t, t);
+        t_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t_lo, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+        t_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t_hi, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+
+        __m128i from_lo = _mm_unpacklo_epi8(from, zero), from_hi = _mm_unpackhi_epi8(from, zero);
+        __m128i to_lo = _mm_unpacklo_epi8(to, zero), to_hi = _mm_unpackhi_epi8(to, zero);
+        __m128i lo = _mm_add_epi16(from_lo, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(to_lo, from_lo), t_lo), HEAT_SHIFT));
+        __m128i hi = _mm_add_epi16(from_hi, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(to_hi, from_hi), t_hi), HEAT_SHIFT));
+        _mm_storeu_si128((__m128i*) (out + n), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for(; n < count; n++)
+        out[n] = heat_color(h, i, j + n, generation);
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+static uint32_t __lerp(uint32_t from, uint32_t to, uint32_t t) {
+    uint32_t color = 0;
+    for(int shift = 0; shift < 32; shift += 8) {
+        int a = (int) (from >> shift & 0xff), b = (int) (to >> shift & 0xff);
+        // an arithmetic shift, the same rounding (down) as the SSE2 path
+        int c = a + ((b - a) * (int) t >> HEAT_SHIFT);
+        color |= (uint32_t) c << shift;
+    }
+    return color;
+}
+
+static void __warm(heat_plane* h, size_t i, size_t j, uint32_t generation) {
+    size_t tile = (i >> h->shift) * h->tiles_x + (j >> h->shift);
+    h->tile_stamps[tile] = generation;
+    if(!h->listed[tile]) {
+        h->listed[tile] = true;
+        h->warm[h->warm_count++] = tile;
+    }
+}
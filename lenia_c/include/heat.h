@@ -0,0 +1,84 @@
+#ifndef HEAT_H
+#define HEAT_H
+
+// Cell age and activity trails of a packed two state board. Instead of a
+// counter every live cell would bump each generation, the plane keeps the
+// generation each cell last flipped: a live cell's age and a dead cell's
+// time since it died both fall out of generation - stamp. Only cells that
+// flip get written, so keeping it up to date costs the change, not the board.
+//
+// Colors come from two ramps, young to old for live cells and just died to
+// faded for dead ones, HEAT_SPAN generations long. Past the end of its ramp
+// a cell's color stops moving, so only tiles that changed in the last
+// HEAT_SPAN generations ever need redrawing: those are kept in warm.
+//
+//     heat_update_block(&h, bits, i0, i1, j0, j1, generation);   // per changed tile
+//     ...redraw the tiles in h.warm[0 .. h.warm_count)...
+//     heat_span(&h, out, i, j, count, generation);              // RGBA per cell
+//     heat_cool(&h, generation);
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HEAT_SHIFT 6
+#define HEAT_SPAN (1u << HEAT_SHIFT)    /* generations from one end of a ramp to the other */
+
+typedef struct {
+    uint32_t young;     // just born, PIXELS_RGBA texels
+    uint32_t old;       // alive HEAT_SPAN generations or more
+    uint32_t died;      // just died
+    uint32_t faded;     // dead HEAT_SPAN generations or more, the background
+} heat_palette;
+
+typedef struct {
+    uint32_t* stamps;       // generation cell (i, j) last flipped, at i * board_cols + j
+    uint64_t* bits;         // the board as of the last update, same layout
+    size_t board_rows;
+    size_t board_cols;
+    unsigned shift;         // warm tiles are 1 << shift cells square
+    size_t tiles_x;
+    size_t tiles_y;
+    uint32_t* tile_stamps;  // last generation a cell of the tile flipped
+    bool* listed;           // tile is in warm
+    size_t* warm;           // tiles (ty * tiles_x + tx) whose colors still move
+    size_t warm_count;
+    heat_palette palette;
+} heat_plane;
+
+#define HEAT_OK 0
+#define HEAT_MALLOC_ERROR -2
+
+/*  A plane for a board_rows x board_cols board with warm tiles of
+    1 << shift cells, all dead and long faded
+
+    Returns:
+        HEAT_OK on success
+        HEAT_MALLOC_ERROR if the plane could not be allocated
+*/
+int heat_init(heat_plane* h, size_t board_rows, size_t board_cols, unsigned shift, heat_palette palette);
+
+void heat_destroy(heat_plane* h);
+
+/*  Take the whole board as is at generation: every cell at the end of its
+    ramp, nothing warm. For turning the plane on mid run.
+*/
+void heat_reset(heat_plane* h, const uint64_t* bits, uint32_t generation);
+
+/*  Cells [i0, i1) x [j0, j1) of bits may have changed: stamp the ones that
+    flipped since the last update with generation and warm their tiles
+*/
+void heat_update_block(heat_plane* h, const uint64_t* bits, size_t i0, size_t i1, size_t j0, size_t j1, uint32_t generation);
+
+/* Drop the warm tiles whose colors have reached the end of their ramps at generation */
+void heat_cool(heat_plane* h, uint32_t generation);
+
+/*  Colors of cells (i, j) .. (i, j + count - 1) at generation into out.
+    Four cells at a time with SSE2.
+*/
+void heat_span(const heat_plane* h, uint32_t* out, size_t i, size_t j, size_t count, uint32_t generation);
+
+/* One cell's color, what heat_span computes */
+uint32_t heat_color(const heat_plane* h, size_t i, size_t j, uint32_t generation);
+
+#endif
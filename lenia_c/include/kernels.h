@@ -1,5 +1,78 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
 #include <complex.h>
+#include <math.h>
 
 #ifdef DEBUG
 double complex a = 1.0 + 3.0 * I;
-#endif
\ No newline at end of file
+#endif
+
+// Exponential kernel core for Lenia, r is the distance normalized to the radius (0..1)
+static inline float lenia_kernel_core(float r) {
+    if(r <= 0.0f || r >= 1.0f)
+        return 0.0f;
+
+    return expf(4.0f - 1.0f / (r * (1.0f - r)));
+}
+
+// Gaussian growth mapping, returns a value in [-1, 1]
+static inline float lenia_growth(float u, float mu, float sigma) {
+    float d = u - mu;
+    return 2.0f * expf(-(d * d) / (2.0f * sigma * sigma)) - 1.0f;
+}
+
+// Fraction of a cell at distance dist covered by a disk of radius r (1 cell anti aliasing)
+static inline float disk_coverage(float dist, float r) {
+    float c = r + 0.5f - dist;
+    return c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+}
+
+typedef enum {
+    KERNEL_LENIA = 0,   // exponential shell of radius r_outer
+    KERNEL_DISK = 1,    // filled disk of radius r_outer
+    KERNEL_ANNULUS = 2  // ring between r_inner and r_outer
+} kernel_shape;
+
+typedef struct {
+    kernel_shape shape;
+    float r_outer;
+    float r_inner;
+} kernel_desc;
+
+// Unnormalized kernel weight at distance dist from the center
+static inline float kernel_weight(const kernel_desc* k, float dist) {
+    switch(k->shape) {
+        case KERNEL_DISK:
+            return disk_coverage(dist, k->r_outer);
+        case KERNEL_ANNULUS:
+            return disk_coverage(dist, k->r_outer) - disk_coverage(dist, k->r_inner);
+        default:
+            return lenia_kernel_core(dist / k->r_outer);
+    }
+}
+
+// SmoothLife logistic helpers (Rafler 2011)
+static inline float smooth_sigma1(float x, float a, float alpha) {
+    return 1.0f / (1.0f + expf(-(x - a) * 4.0f / alpha));
+}
+
+static inline float smooth_sigma_n(float x, float a, float b, float alpha_n) {
+    return smooth_sigma1(x, a, alpha_n) * (1.0f - smooth_sigma1(x, b, alpha_n));
+}
+
+static inline float smooth_sigma_m(float x, float y, float m, float alpha_m) {
+    float s = smooth_sigma1(m, 0.5f, alpha_m);
+    return x * (1.0f - s) + y * s;
+}
+
+// Transition for outer filling n and inner filling m, returns [0, 1]
+static inline float smoothlife_transition(float n, float m, float b1, float b2, float d1, float d2, float alpha_n, float alpha_m) {
+    return smooth_sigma_n(n, smooth_sigma_m(b1, d1, m, alpha_m), smooth_sigma_m(b2, d2, m, alpha_m), alpha_n);
+}
+
+static inline float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+#endif
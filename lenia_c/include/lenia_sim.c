@@ -0,0 +1,577 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "kernels.h"
+#include "spectrum.h"
+#include "lenia_sim.h"
+
+/* PRIVATE FUNCTIONS */
+static uint64_t __next_rand(uint64_t* state);
+static size_t __wrap(ptrdiff_t v, size_t n);
+static float* __window_row(float* rows, const lenia_sim* sim, ptrdiff_t y);
+static void __load_window_row(const lenia_sim* sim, float* rows, ptrdiff_t y);
+static int __build_taps(lenia_sim* sim);
+static void __update_active(lenia_sim* sim);
+static void __dilate_line(const uint8_t* src, uint8_t* dst, size_t stride, size_t tiles, size_t cells, size_t tile, size_t r);
+static int __alloc_scratch(lenia_sim* sim);
+static float* __worker_scratch(const lenia_sim* sim);
+static void __worker_rows(const lenia_sim* sim, size_t* y0, size_t* y1);
+static void __swap_buffers(lenia_sim* sim);
+static void __step_direct(lenia_sim* sim);
+static void __step_fft(lenia_sim* sim);
+static void __release_fft(lenia_sim* sim);
+static void __convolve_span(const lenia_sim* sim, float* rows, size_t y, size_t x0, size_t x1, float* acc);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int lenia_init(lenia_sim* sim, size_t width, size_t height, field_storage storage, lenia_params params) {
+    memset(sim, 0, sizeof(lenia_sim));
+    sim->rule = LENIA_RULE_LENIA;
+    sim->conv = LENIA_CONV_DIRECT;
+    sim->params = params;
+    sim->rng = 0x9E3779B97F4A7C15ULL;
+
+    if(field_init(&sim->state, width, height, storage) != FIELD_OK
+        || field_init(&sim->next, width, height, storage) != FIELD_OK
+        || __build_taps(sim) != LENIA_OK
+        || __alloc_scratch(sim) != LENIA_OK
+        || lenia_set_tiling(sim, LENIA_DEFAULT_TILE, LENIA_DEFAULT_EPS) != LENIA_OK) {
+        lenia_destroy(sim);
+        return LENIA_MALLOC_ERROR;
+    }
+
+    return LENIA_OK;
+}
+
+int lenia_init_smoothlife(lenia_sim* sim, size_t width, size_t height, field_storage storage, smoothlife_params params) {
+    memset(sim, 0, sizeof(lenia_sim));
+    sim->rule = LENIA_RULE_SMOOTHLIFE;
+    sim->conv = LENIA_CONV_DIRECT;
+    sim->smooth = params;
+    // radius only sizes the seeding patches here, there are no direct taps
+    sim->params = LENIA_DEFAULT_PARAMS;
+    sim->params.radius = (size_t) ceilf(params.ra);
+    sim->rng = 0x9E3779B97F4A7C15ULL;
+
+    if(field_init(&sim->state, width, height, storage) != FIELD_OK
+        || field_init(&sim->next, width, height, storage) != FIELD_OK
+        || __alloc_scratch(sim) != LENIA_OK
+        || lenia_set_tiling(sim, LENIA_DEFAULT_TILE, LENIA_DEFAULT_EPS) != LENIA_OK) {
+        lenia_destroy(sim);
+        return LENIA_MALLOC_ERROR;
+    }
+
+    if(lenia_set_conv(sim, LENIA_CONV_FFT) != LENIA_OK) {
+        lenia_destroy(sim);
+        return LENIA_MALLOC_ERROR;
+    }
+
+    return LENIA_OK;
+}
+
+void lenia_destroy(lenia_sim* sim) {
+    __release_fft(sim);
+    field_destroy(&sim->state);
+    field_destroy(&sim->next);
+    free(sim->taps);
+    free(sim->occ);
+    free(sim->occ_next);
+    free(sim->active);
+    free(sim->scratch);
+    sim->taps = NULL;
+    sim->occ = sim->occ_next = sim->active = NULL;
+    sim->scratch = NULL;
+    sim->n_taps = 0;
+}
+
+int lenia_set_conv(lenia_sim* sim, lenia_conv conv) {
+    if(conv == LENIA_CONV_DIRECT) {
+        if(sim->rule == LENIA_RULE_SMOOTHLIFE)
+            return LENIA_INVALID;
+
+        __release_fft(sim);
+        sim->conv = conv;
+        return LENIA_OK;
+    }
+
+    if(sim->buf != NULL) {
+        sim->conv = conv;
+        return LENIA_OK;
+    }
+
+    size_t w = sim->state.width, h = sim->state.height;
+    if(fft2d_init(&sim->fft, w, h) != FFT_OK)
+        return LENIA_MALLOC_ERROR;
+
+    sim->buf = malloc(w * h * sizeof(float complex));
+    if(sim->rule == LENIA_RULE_SMOOTHLIFE) {
+        kernel_desc inner = { KERNEL_DISK, sim->smooth.ri, 0.0f };
+        kernel_desc outer = { KERNEL_ANNULUS, sim->smooth.ra, sim->smooth.ri };
+        sim->spectrum[0] = spectrum_acquire(&inner, w, h);
+        sim->spectrum[1] = spectrum_acquire(&outer, w, h);
+    } else {
+        kernel_desc shell = { KERNEL_LENIA, (float) sim->params.radius, 0.0f };
+        sim->spectrum[0] = spectrum_acquire(&shell, w, h);
+    }
+
+    if(sim->buf == NULL || sim->spectrum[0] == NULL
+        || (sim->rule == LENIA_RULE_SMOOTHLIFE && sim->spectrum[1] == NULL)) {
+        __release_fft(sim);
+        return LENIA_MALLOC_ERROR;
+    }
+
+    sim->conv = conv;
+    return LENIA_OK;
+}
+
+int lenia_set_tiling(lenia_sim* sim, size_t tile, float eps) {
+    size_t w = sim->state.width, h = sim->state.height;
+
+    // disabled tiling still keeps one "tile" per row so the step code stays the same
+    sim->tile = tile;
+    sim->eps = eps;
+    sim->tiles_x = tile ? (w + tile - 1) / tile : 1;
+    sim->tiles_y = tile ? (h + tile - 1) / tile : h;
+
+    size_t n = sim->tiles_x * sim->tiles_y;
+    free(sim->occ);
+    free(sim->occ_next);
+    free(sim->active);
+    sim->occ = calloc(n, 1);
+    sim->occ_next = calloc(n, 1);
+    sim->active = calloc(n, 1);
+    if(sim->occ == NULL || sim->occ_next == NULL || sim->active == NULL)
+        return LENIA_MALLOC_ERROR;
+
+    lenia_refresh_tiles(sim);
+    return LENIA_OK;
+}
+
+void lenia_refresh_tiles(lenia_sim* sim) {
+    size_t w = sim->state.width, h = sim->state.height;
+    size_t tw = sim->tile ? sim->tile : w, th = sim->tile ? sim->tile : 1;
+    float* row = malloc(w * sizeof(float));
+    if(row == NULL)
+        return;
+
+    memset(sim->occ, 0, sim->tiles_x * sim->tiles_y);
+    for(size_t y = 0; y < h; y++) {
+        uint8_t* occ = sim->occ + (y / th) * sim->tiles_x;
+        field_load_row(&sim->state, y, row);
+        for(size_t x = 0; x < w; x++)
+            if(row[x] > sim->eps)
+                occ[x / tw] = 1;
+    }
+
+    free(row);
+}
+
+void lenia_seed(lenia_sim* sim, uint64_t seed, float coverage) {
+    size_t w = sim->state.width, h = sim->state.height;
+    size_t side = 2 * sim->params.radius;
+    if(side > w)
+        side = w;
+    if(side > h)
+        side = h;
+
+    sim->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    field_clear(&sim->state);
+
+    size_t patches = (size_t) (coverage * (float) (w * h) / (float) (side * side)) + 1;
+    for(size_t p = 0; p < patches; p++) {
+        size_t x0 = __next_rand(&sim->rng) % w;
+        size_t y0 = __next_rand(&sim->rng) % h;
+
+        for(size_t j = 0; j < side; j++)
+            for(size_t i = 0; i < side; i++) {
+                float v = (float) (__next_rand(&sim->rng) >> 40) / (float) (1 << 24);
+                field_set(&sim->state, (x0 + i) % w, (y0 + j) % h, v);
+            }
+    }
+
+    lenia_refresh_tiles(sim);
+}
+
+void lenia_step(lenia_sim* sim) {
+    if(sim->conv == LENIA_CONV_FFT)
+        __step_fft(sim);
+    else
+        __step_direct(sim);
+}
+
+double lenia_mass(const lenia_sim* sim) {
+    float* row = malloc(sim->state.width * sizeof(float));
+    double sum = 0.0;
+    if(row == NULL)
+        return 0.0;
+
+    for(size_t y = 0; y < sim->state.height; y++) {
+        field_load_row(&sim->state, y, row);
+        for(size_t x = 0; x < sim->state.width; x++)
+            sum += row[x];
+    }
+
+    free(row);
+    return sum;
+}
+
+void lenia_drift(const lenia_sim* ref, const lenia_sim* test, float* max_abs, double* rms) {
+    size_t w = ref->state.width, h = ref->state.height;
+    float* a = malloc(w * sizeof(float));
+    float* b = malloc(w * sizeof(float));
+    double sq = 0.0;
+    float mx = 0.0f;
+
+    if(a && b) {
+        for(size_t y = 0; y < h; y++) {
+            field_load_row(&ref->state, y, a);
+            field_load_row(&test->state, y, b);
+            for(size_t x = 0; x < w; x++) {
+                float d = fabsf(a[x] - b[x]);
+                if(d > mx)
+                    mx = d;
+                sq += (double) d * d;
+            }
+        }
+    }
+
+    *max_abs = mx;
+    *rms = sqrt(sq / (double) (w * h));
+    free(a);
+    free(b);
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static uint64_t __next_rand(uint64_t* state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static size_t __wrap(ptrdiff_t v, size_t n) {
+    ptrdiff_t m = v % (ptrdiff_t) n;
+    return (size_t) (m < 0 ? m + (ptrdiff_t) n : m);
+}
+
+static float* __window_row(float* rows, const lenia_sim* sim, ptrdiff_t y) {
+    size_t r = sim->params.radius;
+    return rows + __wrap(y, 2 * r + 1) * (sim->state.width + 2 * r);
+}
+
+static void __load_window_row(const lenia_sim* sim, float* rows, ptrdiff_t y) {
+    size_t w = sim->state.width, r = sim->params.radius;
+    float* dst = __window_row(rows, sim, y);
+
+    field_load_row(&sim->state, __wrap(y, sim->state.height), dst + r);
+
+    // horizontal halo so the tap loop never has to wrap
+    for(size_t k = 0; k < r; k++) {
+        dst[k] = dst[r + __wrap((ptrdiff_t) k - (ptrdiff_t) r, w)];
+        dst[r + w + k] = dst[r + k % w];
+    }
+}
+
+static int __build_taps(lenia_sim* sim) {
+    ptrdiff_t r = (ptrdiff_t) sim->params.radius;
+    size_t side = 2 * (size_t) r + 1;
+    kernel_desc shell = { KERNEL_LENIA, (float) r, 0.0f };
+
+    sim->taps = malloc(side * side * sizeof(lenia_tap));
+    if(sim->taps == NULL)
+        return LENIA_MALLOC_ERROR;
+
+    double total = 0.0;
+    sim->n_taps = 0;
+    for(ptrdiff_t dy = -r; dy <= r; dy++) {
+        for(ptrdiff_t dx = -r; dx <= r; dx++) {
+            float wt = kernel_weight(&shell, sqrtf((float) (dx * dx + dy * dy)));
+            if(wt <= 0.0f)
+                continue;
+
+            sim->taps[sim->n_taps++] = (lenia_tap) { (int) dx, (int) dy, wt };
+            total += wt;
+        }
+    }
+
+    for(size_t k = 0; k < sim->n_taps; k++)
+        sim->taps[k].w = (float) (sim->taps[k].w / total);
+
+    return LENIA_OK;
+}
+
+static void __update_active(lenia_sim* sim) {
+    const size_t tx_n = sim->tiles_x, ty_n = sim->tiles_y, n = tx_n * ty_n;
+    const lenia_params p = sim->params;
+    float zero_growth = clampf(p.dt * lenia_growth(0.0f, p.mu, p.sigma), 0.0f, 1.0f);
+
+    // without tiling, or if nothing decays to zero, every tile has to be computed
+    if(sim->tile == 0 || zero_growth > sim->eps) {
+        memset(sim->active, 1, n);
+        sim->active_tiles = n;
+        return;
+    }
+
+    uint8_t* rowmax = calloc(n, 1);
+    if(rowmax == NULL) {
+        memset(sim->active, 1, n);
+        sim->active_tiles = n;
+        return;
+    }
+
+    // separable dilation by R cells, wrapping around the torus
+    memset(sim->active, 0, n);
+    for(size_t ty = 0; ty < ty_n; ty++)
+        __dilate_line(sim->occ + ty * tx_n, rowmax + ty * tx_n, 1, tx_n, sim->state.width, sim->tile, p.radius);
+    for(size_t tx = 0; tx < tx_n; tx++)
+        __dilate_line(rowmax + tx, sim->active + tx, tx_n, ty_n, sim->state.height, sim->tile, p.radius);
+
+    sim->active_tiles = 0;
+    for(size_t k = 0; k < n; k++)
+        sim->active_tiles += sim->active[k];
+
+    free(rowmax);
+}
+
+/*  Mark in dst every tile of the line holding a cell within r of a cell of
+    an occupied tile in src. Works in cells rather than whole tiles: the last
+    tile is partial when tile doesn't divide cells, so the seam is nearer
+    than a count of tiles says.
+*/
+static void __dilate_line(const uint8_t* src, uint8_t* dst, size_t stride, size_t tiles, size_t cells, size_t tile, size_t r) {
+    for(size_t t = 0; t < tiles; t++) {
+        if(!src[t * stride])
+            continue;
+
+        size_t x1 = (t + 1) * tile > cells ? cells : (t + 1) * tile;
+        ptrdiff_t c = (ptrdiff_t) (t * tile) - (ptrdiff_t) r, end = (ptrdiff_t) (x1 + r);
+        if(end - c >= (ptrdiff_t) cells) {
+            for(size_t u = 0; u < tiles; u++)
+                dst[u * stride] = 1;
+            return;
+        }
+
+        // walk the reach one tile at a time, the wrap can land mid tile
+        while(c < end) {
+            size_t x = __wrap(c, cells), u = x / tile;
+            size_t next = (u + 1) * tile > cells ? cells : (u + 1) * tile;
+            dst[u * stride] = 1;
+            c += (ptrdiff_t) (next - x);
+        }
+    }
+}
+
+static void __convolve_span(const lenia_sim* sim, float* rows, size_t y, size_t x0, size_t x1, float* acc) {
+    const size_t r = sim->params.radius;
+    const float mu = sim->params.mu, sigma = sim->params.sigma, dt = sim->params.dt;
+
+    for(size_t k = 0; k < sim->n_taps; k++) {
+        const lenia_tap tap = sim->taps[k];
+        const float* src = __window_row(rows, sim, (ptrdiff_t) y + tap.dy) + r + tap.dx;
+        for(size_t x = x0; x < x1; x++)
+            acc[x] += tap.w * src[x];
+    }
+
+    const float* center = __window_row(rows, sim, (ptrdiff_t) y) + r;
+    for(size_t x = x0; x < x1; x++)
+        acc[x] = clampf(center[x] + dt * lenia_growth(acc[x], mu, sigma), 0.0f, 1.0f);
+}
+
+static void __step_direct(lenia_sim* sim) {
+    const size_t w = sim->state.width;
+    const size_t r = sim->params.radius;
+    const size_t tw = sim->tile ? sim->tile : w, th = sim->tile ? sim->tile : 1;
+    const size_t tiles_x = sim->tiles_x;
+
+    __update_active(sim);
+
+    #pragma omp parallel num_threads(sim->workers)
+    {
+        size_t y0, y1;
+        __worker_rows(sim, &y0, &y1);
+
+        // every worker keeps its own window of 2R + 1 rows, converted to fp32 once
+        float* acc = __worker_scratch(sim);
+        float* rows = acc + w;
+
+        if(y0 < y1) {
+            for(ptrdiff_t y = (ptrdiff_t) y0 - (ptrdiff_t) r; y < (ptrdiff_t) (y0 + r); y++)
+                __load_window_row(sim, rows, y);
+
+            for(size_t y = y0; y < y1; y++) {
+                const uint8_t* active = sim->active + (y / th) * tiles_x;
+                uint8_t* occ_next = sim->occ_next + (y / th) * tiles_x;
+
+                __load_window_row(sim, rows, (ptrdiff_t) (y + r));
+                if(y % th == 0)
+                    memset(occ_next, 0, tiles_x);
+
+                // convolve runs of active tiles, empty neighborhoods stay zero
+                memset(acc, 0, w * sizeof(float));
+                for(size_t tx = 0; tx < tiles_x; ) {
+                    if(!active[tx]) {
+                        tx++;
+                        continue;
+                    }
+
+                    size_t run = tx;
+                    while(run < tiles_x && active[run])
+                        run++;
+
+                    size_t x0 = tx * tw, x1 = run * tw > w ? w : run * tw;
+                    __convolve_span(sim, rows, y, x0, x1, acc);
+                    for(size_t x = x0; x < x1; x++)
+                        if(acc[x] > sim->eps)
+                            occ_next[x / tw] = 1;
+
+                    tx = run;
+                }
+
+                field_store_row(&sim->next, y, acc);
+            }
+        }
+    }
+
+    __swap_buffers(sim);
+}
+
+static void __step_fft(lenia_sim* sim) {
+    const size_t w = sim->state.width, h = sim->state.height, n = w * h;
+    const size_t tw = sim->tile ? sim->tile : w, th = sim->tile ? sim->tile : 1;
+    const float* k0 = sim->spectrum[0];
+    const float* k1 = sim->spectrum[1];
+    float complex* buf = sim->buf;
+
+    #pragma omp parallel num_threads(sim->workers)
+    {
+        float* row = __worker_scratch(sim);
+
+        #pragma omp for schedule(static)
+        for(size_t y = 0; y < h; y++) {
+            field_load_row(&sim->state, y, row);
+            for(size_t x = 0; x < w; x++)
+                buf[y * w + x] = row[x];
+        }
+    }
+
+    fft2d_forward(&sim->fft, buf);
+
+    // SmoothLife: inner filling comes back in the real part, outer in the imaginary
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < n; i++)
+        buf[i] = k1 ? buf[i] * (k0[i] + I * k1[i]) : buf[i] * k0[i];
+
+    fft2d_inverse(&sim->fft, buf);
+
+    const lenia_params lp = sim->params;
+    const smoothlife_params sp = sim->smooth;
+
+    #pragma omp parallel num_threads(sim->workers)
+    {
+        size_t y0, y1;
+        __worker_rows(sim, &y0, &y1);
+        float* row = __worker_scratch(sim);
+
+        for(size_t y = y0; y < y1; y++) {
+            uint8_t* occ_next = sim->occ_next + (y / th) * sim->tiles_x;
+            const float complex* u = buf + y * w;
+
+            if(y % th == 0)
+                memset(occ_next, 0, sim->tiles_x);
+
+            field_load_row(&sim->state, y, row);
+            for(size_t x = 0; x < w; x++) {
+                float v;
+                if(sim->rule == LENIA_RULE_SMOOTHLIFE) {
+                    float s = smoothlife_transition(cimagf(u[x]), crealf(u[x]), sp.b1, sp.b2, sp.d1, sp.d2, sp.alpha_n, sp.alpha_m);
+                    v = sp.dt >= 1.0f ? s : clampf(row[x] + sp.dt * (2.0f * s - 1.0f), 0.0f, 1.0f);
+                } else {
+                    v = clampf(row[x] + lp.dt * lenia_growth(crealf(u[x]), lp.mu, lp.sigma), 0.0f, 1.0f);
+                }
+
+                row[x] = v;
+                if(v > sim->eps)
+                    occ_next[x / tw] = 1;
+            }
+            field_store_row(&sim->next, y, row);
+        }
+    }
+
+    sim->active_tiles = sim->tiles_x * sim->tiles_y;
+    __swap_buffers(sim);
+}
+
+static int __alloc_scratch(lenia_sim* sim) {
+    size_t w = sim->state.width, r = sim->params.radius;
+    sim->workers = 1;
+#ifdef _OPENMP
+    sim->workers = (size_t) omp_get_max_threads();
+#endif
+    // SmoothLife only ever takes the FFT path, which needs no window
+    sim->scratch_floats = w;
+    if(sim->rule == LENIA_RULE_LENIA)
+        sim->scratch_floats += (2 * r + 1) * (w + 2 * r);
+
+    sim->scratch = malloc(sim->workers * sim->scratch_floats * sizeof(float));
+    return sim->scratch ? LENIA_OK : LENIA_MALLOC_ERROR;
+}
+
+static float* __worker_scratch(const lenia_sim* sim) {
+    size_t t = 0;
+#ifdef _OPENMP
+    t = (size_t) omp_get_thread_num();
+#endif
+    return sim->scratch + t * sim->scratch_floats;
+}
+
+static void __worker_rows(const lenia_sim* sim, size_t* y0, size_t* y1) {
+    const size_t h = sim->state.height, th = sim->tile ? sim->tile : 1;
+    size_t nt = 1, t = 0;
+#ifdef _OPENMP
+    nt = (size_t) omp_get_num_threads();
+    t = (size_t) omp_get_thread_num();
+#endif
+    // split on tile rows so no two workers share an occupancy byte
+    *y0 = sim->tiles_y * t / nt * th;
+    *y1 = sim->tiles_y * (t + 1) / nt * th;
+    if(*y1 > h)
+        *y1 = h;
+    if(*y0 > h)
+        *y0 = h;
+}
+
+static void __swap_buffers(lenia_sim* sim) {
+    field_t tmp = sim->state;
+    sim->state = sim->next;
+    sim->next = tmp;
+
+    uint8_t* occ = sim->occ;
+    sim->occ = sim->occ_next;
+    sim->occ_next = occ;
+
+    sim->generation++;
+}
+
+static void __release_fft(lenia_sim* sim) {
+    for(size_t k = 0; k < 2; k++) {
+        if(sim->spectrum[k])
+            spectrum_release(sim->spectrum[k]);
+        sim->spectrum[k] = NULL;
+    }
+
+    free(sim->buf);
+    sim->buf = NULL;
+    fft2d_destroy(&sim->fft);
+}
@@ -0,0 +1,147 @@
+#ifndef LENIA_SIM_H
+#define LENIA_SIM_H
+
+// Lenia on a torus, direct convolution over a rolling window of fp32 rows or
+// through the FFT. The state itself is a field_t so it can be kept in reduced
+// precision. SmoothLife runs on the same state, FFT and spectrum cache, it only
+// swaps the kernels and the growth / transition function.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <complex.h>
+
+#include "field.h"
+#include "fft.h"
+
+typedef struct {
+    size_t radius;  // kernel radius R in cells
+    float mu;       // growth center
+    float sigma;    // growth width
+    float dt;       // time step (1 / T)
+} lenia_params;
+
+// Orbium-like defaults
+#define LENIA_DEFAULT_PARAMS ((lenia_params) { 13, 0.15f, 0.015f, 0.1f })
+
+// Tile edge used for empty region skipping, eps 0 keeps the step bit exact
+#define LENIA_DEFAULT_TILE 32
+#define LENIA_DEFAULT_EPS 0.0f
+
+typedef struct {
+    float ri;       // inner disk radius
+    float ra;       // outer annulus radius
+    float b1;       // birth interval
+    float b2;
+    float d1;       // death (survival) interval
+    float d2;
+    float alpha_n;  // sigmoid widths
+    float alpha_m;
+    float dt;       // >= 1 is the discrete rule, smaller values integrate 2s - 1
+} smoothlife_params;
+
+#define SMOOTHLIFE_DEFAULT_PARAMS ((smoothlife_params) { 7.0f, 21.0f, 0.278f, 0.365f, 0.267f, 0.445f, 0.028f, 0.147f, 1.0f })
+
+typedef enum {
+    LENIA_RULE_LENIA = 0,
+    LENIA_RULE_SMOOTHLIFE = 1
+} lenia_rule;
+
+typedef enum {
+    LENIA_CONV_DIRECT = 0,
+    LENIA_CONV_FFT = 1
+} lenia_conv;
+
+typedef struct {
+    int dx;
+    int dy;
+    float w;
+} lenia_tap;
+
+typedef struct {
+    field_t state;
+    field_t next;
+    lenia_rule rule;
+    lenia_conv conv;
+    lenia_params params;
+    smoothlife_params smooth;
+    lenia_tap* taps;    // non zero kernel weights, sorted by dy, summing to 1
+    size_t n_taps;
+    uint64_t generation;
+    uint64_t rng;
+
+    // Tile occupancy: a tile is convolved only if some value above eps sits
+    // within R of it, everything else is the (zero) growth of an empty
+    // neighborhood. tile == 0 convolves every cell.
+    size_t tile;
+    float eps;
+    size_t tiles_x;
+    size_t tiles_y;
+    uint8_t* occ;       // per tile, state has a value above eps
+    uint8_t* occ_next;  // written by the step for the next state
+    uint8_t* active;    // occ dilated by R, rebuilt every step
+    size_t active_tiles; // tiles convolved by the last step
+
+    // Per worker scratch, allocated once so a step can't fail halfway: one
+    // fp32 row, then for the direct path the window of 2R + 1 rows.
+    size_t workers;
+    size_t scratch_floats;  // per worker
+    float* scratch;
+
+    // FFT path: one forward transform of the state, then every kernel is a
+    // spectrum multiply. Two real convolutions share one inverse transform by
+    // riding in the real and imaginary parts.
+    fft2d fft;
+    float complex* buf;
+    const float* spectrum[2];   // from the spectrum cache, [1] only for SmoothLife
+} lenia_sim;
+
+#define LENIA_OK 0
+#define LENIA_INVALID -1
+#define LENIA_MALLOC_ERROR -2
+
+/*  Allocate state, double buffer and kernel taps
+
+    Returns:
+        LENIA_OK on success
+        LENIA_MALLOC_ERROR if anything could not be allocated
+*/
+int lenia_init(lenia_sim* sim, size_t width, size_t height, field_storage storage, lenia_params params);
+
+/* Same as lenia_init, but for SmoothLife (always convolves through the FFT) */
+int lenia_init_smoothlife(lenia_sim* sim, size_t width, size_t height, field_storage storage, smoothlife_params params);
+
+void lenia_destroy(lenia_sim* sim);
+
+/*  Switch between direct and FFT convolution (Lenia only)
+
+    Returns:
+        LENIA_OK on success
+        LENIA_INVALID if asking SmoothLife for direct convolution
+        LENIA_MALLOC_ERROR if the FFT plan, buffer or spectra could not be allocated
+*/
+int lenia_set_conv(lenia_sim* sim, lenia_conv conv);
+
+/*  Change the skipping tile size (0 disables it) and emptiness threshold
+
+    Returns:
+        LENIA_OK on success
+        LENIA_MALLOC_ERROR if the occupancy maps could not be allocated
+*/
+int lenia_set_tiling(lenia_sim* sim, size_t tile, float eps);
+
+/* Rebuild tile occupancy from the state, needed after writing cells by hand */
+void lenia_refresh_tiles(lenia_sim* sim);
+
+/* Scatter random square patches (side 2R) over coverage of the field, reproducible from seed */
+void lenia_seed(lenia_sim* sim, uint64_t seed, float coverage);
+
+/* Advance one generation */
+void lenia_step(lenia_sim* sim);
+
+/* Sum of all cell values */
+double lenia_mass(const lenia_sim* sim);
+
+/* Max absolute and RMS difference between two equally sized sims, in fp32 */
+void lenia_drift(const lenia_sim* ref, const lenia_sim* test, float* max_abs, double* rms);
+
+#endif
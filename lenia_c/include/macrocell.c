@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macrocell.h"
+
+#define MC_INITIAL_NODES 1024
+
+typedef struct {
+    uint64_t x0, y0, x1, y1;    // x1 == 0 until worked out, a live node's box is never empty
+} mc_box;
+
+/* PRIVATE FUNCTIONS */
+static uint32_t __intern(mc_tree* t, const mc_node* n);
+static int __rehash(mc_tree* t);
+static uint64_t __hash(const mc_node* n);
+static bool __same(const mc_node* a, const mc_node* b);
+static uint32_t __build(mc_tree* t, uint32_t level, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+    mc_tile_fn tile, void* ctx);
+static void __visit(const mc_tree* t, uint32_t id, uint32_t level, uint64_t ox, uint64_t oy,
+    const uint64_t window[4], mc_leaf_fn leaf, void* ctx);
+static const mc_box* __bounds(const mc_tree* t, uint32_t id, mc_box* boxes);
+static bool __write_node(const mc_tree* t, FILE* fp, uint32_t id, uint32_t* numbers, uint32_t* next);
+static int __parse_leaf(const char* line, uint64_t* bits);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int mc_init(mc_tree* t) {
+    memset(t, 0, sizeof(mc_tree));
+    t->nodes = calloc(MC_INITIAL_NODES, sizeof(mc_node));
+    t->slots = calloc(2 * MC_INITIAL_NODES, sizeof(uint32_t));
+    if(t->nodes == NULL || t->slots == NULL) {
+        mc_destroy(t);
+        return MC_MALLOC_ERROR;
+    }
+    t->count = 1;
+    t->capacity = MC_INITIAL_NODES;
+    t->slot_mask = 2 * MC_INITIAL_NODES - 1;
+    t->root = 0;
+    t->root_level = MC_LEAF_LEVEL;
+    strcpy(t->rule, "B3/S23");
+    return MC_OK;
+}
+
+void mc_destroy(mc_tree* t) {
+    free(t->nodes);
+    free(t->slots);
+    t->nodes = NULL;
+    t->slots = NULL;
+    t->count = 0;
+    t->capacity = 0;
+    t->root = 0;
+}
+
+uint32_t mc_leaf(mc_tree* t, uint64_t bits) {
+    if(bits == 0)
+        return 0;
+    mc_node n = { .bits = bits, .population = (uint64_t) __builtin_popcountll(bits), .level = MC_LEAF_LEVEL };
+    return __intern(t, &n);
+}
+
+uint32_t mc_node_of(mc_tree* t, uint32_t level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    if((nw | ne | sw | se) == 0)
+        return 0;
+    mc_node n = { .child = { nw, ne, sw, se }, .level = level };
+    // a population past 2^64 only happens in patterns nobody counts, it saturates
+    for(int q = 0; q < 4; q++) {
+        uint64_t p = t->nodes[n.child[q]].population;
+        n.population = n.population + p < p ? UINT64_MAX : n.population + p;
+    }
+    return __intern(t, &n);
+}
+
+int mc_read(mc_tree* t, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL)
+        return MC_FILE_ERROR;
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+    mc_destroy(t);
+    int status = mc_init(t);
+    char* line = NULL;
+    size_t line_capacity = 0;
+    // file node n (from 1) is tree node ids[n], 0 is the empty node in both
+    uint32_t* ids = malloc(MC_INITIAL_NODES * sizeof(uint32_t));
+    size_t n_ids = 1, ids_capacity = MC_INITIAL_NODES;
+    if(ids == NULL && status == MC_OK)
+        status = MC_MALLOC_ERROR;
+    else if(ids)
+        ids[0] = 0;
+
+    if(status == MC_OK && (getline(&line, &line_capacity, fp) < 0 || strncmp(line, "[M2]", 4) != 0))
+        status = ferror(fp) ? MC_FILE_ERROR : MC_FORMAT_ERROR;
+
+    ssize_t length;
+    while(status == MC_OK && (length = getline(&line, &line_capacity, fp)) >= 0) {
+        while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        if(length == 0)
+            continue;
+
+        if(line[0] == '#') {
+            if(line[1] == 'R') {
+                const char* rule = line + 2 + strspn(line + 2, " \t");
+                size_t rule_length = strcspn(rule, " \t");
+                if(rule_length >= MC_RULE_MAX)
+                    rule_length = MC_RULE_MAX - 1;
+                memcpy(t->rule, rule, rule_length);
+                t->rule[rule_length] = '\0';
+            } else if(line[1] == 'G') {
+                t->generation = strtoull(line + 2, NULL, 10);
+            }
+            continue;
+        }
+
+        uint32_t id, level;
+        if(line[0] == '.' || line[0] == '*' || line[0] == '$') {
+            uint64_t bits;
+            status = __parse_leaf(line, &bits);
+            if(status != MC_OK)
+                break;
+            id = mc_leaf(t, bits);
+            level = MC_LEAF_LEVEL;
+        } else {
+            unsigned long child[4];
+            if(sscanf(line, "%u %lu %lu %lu %lu", &level, &child[0], &child[1], &child[2], &child[3]) != 5
+               || level <= MC_LEAF_LEVEL || level > MC_MAX_LEVEL) {
+                status = MC_FORMAT_ERROR;
+                break;
+            }
+            uint32_t quadrant[4];
+            for(int q = 0; q < 4; q++) {
+                // children come before their parents and are one level down
+                if(child[q] >= n_ids || (ids[child[q]] && t->nodes[ids[child[q]]].level != level - 1)) {
+                    status = MC_FORMAT_ERROR;
+                    break;
+                }
+                quadrant[q] = ids[child[q]];
+            }
+            if(status != MC_OK)
+                break;
+            id = mc_node_of(t, level, quadrant[mc_nw], quadrant[mc_ne], quadrant[mc_sw], quadrant[mc_se]);
+        }
+        if(id == UINT32_MAX) {
+            status = MC_MALLOC_ERROR;
+            break;
+        }
+
+        if(n_ids == ids_capacity) {
+            uint32_t* grown = realloc(ids, 2 * ids_capacity * sizeof(uint32_t));
+            if(grown == NULL) {
+                status = MC_MALLOC_ERROR;
+                break;
+            }
+            ids = grown;
+            ids_capacity *= 2;
+        }
+        ids[n_ids++] = id;
+        t->root = id;
+        t->root_level = level;
+    }
+    if(status == MC_OK && ferror(fp))
+        status = MC_FILE_ERROR;
+
+    free(line);
+    free(ids);
+    fclose(fp);
+    return status;
+}
+
+int mc_write(const mc_tree* t, const char* path) {
+    uint32_t* numbers = calloc(t->count ? t->count : 1, sizeof(uint32_t));
+    if(numbers == NULL)
+        return MC_MALLOC_ERROR;
+    FILE* fp = fopen(path, "wb");
+    if(fp == NULL) {
+        free(numbers);
+        return MC_FILE_ERROR;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+    fprintf(fp, "[M2] (automata-raylib)\n#R %s\n", t->rule);
+    if(t->generation)
+        fprintf(fp, "#G %llu\n", (unsigned long long) t->generation);
+    uint32_t next = 1;
+    bool ok = __write_node(t, fp, t->root, numbers, &next);
+
+    free(numbers);
+    ok = !ferror(fp) && ok;
+    ok = fclose(fp) == 0 && ok;
+    if(!ok)
+        remove(path);
+    return ok ? MC_OK : MC_FILE_ERROR;
+}
+
+uint32_t mc_build(mc_tree* t, uint64_t width, uint64_t height, mc_tile_fn tile, void* ctx) {
+    uint32_t level = MC_LEAF_LEVEL;
+    while(level < MC_MAX_LEVEL && (((uint64_t) 1 << level) < width || ((uint64_t) 1 << level) < height))
+        level++;
+
+    uint32_t root = __build(t, level, 0, 0, width, height, tile, ctx);
+    if(root != UINT32_MAX) {
+        t->root = root;
+        t->root_level = level;
+    }
+    return root;
+}
+
+void mc_for_each_leaf(const mc_tree* t, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+    mc_leaf_fn leaf, void* ctx) {
+    // the window as x0, y0, x1, y1, cut short rather than wrapped past 2^64
+    const uint64_t window[4] = { x, y, x + width < x ? UINT64_MAX : x + width, y + height < y ? UINT64_MAX : y + height };
+    __visit(t, t->root, t->root_level, 0, 0, window, leaf, ctx);
+}
+
+bool mc_bounds(const mc_tree* t, uint64_t* x0, uint64_t* y0, uint64_t* x1, uint64_t* y1) {
+    if(t->root == 0)
+        return false;
+    mc_box* boxes = calloc(t->count, sizeof(mc_box));
+    if(boxes == NULL)
+        return false;
+    const mc_box* box = __bounds(t, t->root, boxes);
+    *x0 = box->x0;
+    *y0 = box->y0;
+    *x1 = box->x1;
+    *y1 = box->y1;
+    free(boxes);
+    return true;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+// the existing copy of n, or n added as a new node
+static uint32_t __intern(mc_tree* t, const mc_node* n) {
+    uint32_t slot = (uint32_t) __hash(n) & t->slot_mask;
+    while(t->slots[slot]) {
+        if(__same(&t->nodes[t->slots[slot]], n))
+            return t->slots[slot];
+        slot = (slot + 1) & t->slot_mask;
+    }
+
+    if(t->count == t->capacity) {
+        if(t->capacity >= UINT32_MAX / 2)
+            return UINT32_MAX;
+        mc_node* grown = realloc(t->nodes, 2 * (size_t) t->capacity * sizeof(mc_node));
+        if(grown == NULL)
+            return UINT32_MAX;
+        t->nodes = grown;
+        t->capacity *= 2;
+    }
+    uint32_t id = t->count++;
+    t->nodes[id] = *n;
+    t->slots[slot] = id;
+
+    // at most half full, so probes stay short
+    if((uint64_t) t->count * 2 > (uint64_t) t->slot_mask + 1 && __rehash(t) != MC_OK) {
+        t->count--;
+        t->slots[slot] = 0;
+        return UINT32_MAX;
+    }
+    return id;
+}
+
+static int __rehash(mc_tree* t) {
+    uint64_t slots = 2 * ((uint64_t) t->slot_mask + 1);
+    if(slots > ((uint64_t) 1 << 32))
+        return MC_MALLOC_ERROR;
+    uint32_t* grown = calloc(slots, sizeof(uint32_t));
+    if(grown == NULL)
+        return MC_MALLOC_ERROR;
+    free(t->slots);
+    t->slots = grown;
+    t->slot_mask = (uint32_t) (slots - 1);
+    for(uint32_t id = 1; id < t->count; id++) {
+        uint32_t slot = (uint32_t) __hash(&t->nodes[id]) & t->slot_mask;
+        while(t->slots[slot])
+            slot = (slot + 1) & t->slot_mask;
+        t->slots[slot] = id;
+    }
+    return MC_OK;
+}
+
+static uint64_t __hash(const mc_node* n) {
+    uint64_t h = n->level * 0x9e3779b97f4a7c15ull ^ n->bits * 0xbf58476d1ce4e5b9ull;
+    for(int q = 0; q < 4; q++)
+        h = (h ^ n->child[q]) * 0x94d049bb133111ebull;
+    return h ^ h >> 31;
+}
+
+static bool __same(const mc_node* a, const mc_node* b) {
+    return a->level == b->level && a->bits == b->bits && a->child[0] == b->child[0] && a->child[1] == b->child[1]
+           && a->child[2] == b->child[2] && a->child[3] == b->child[3];
+}
+
+static uint32_t __build(mc_tree* t, uint32_t level, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+    mc_tile_fn tile, void* ctx) {
+    if(x >= width || y >= height)
+        return 0;
+    if(level == MC_LEAF_LEVEL)
+        return mc_leaf(t, tile(ctx, x, y));
+
+    uint64_t half = (uint64_t) 1 << (level - 1);
+    uint32_t quadrant[4] = {
+        __build(t, level - 1, x, y, width, height, tile, ctx),
+        __build(t, level - 1, x + half, y, width, height, tile, ctx),
+        __build(t, level - 1, x, y + half, width, height, tile, ctx),
+        __build(t, level - 1, x + half, y + half, width, height, tile, ctx)
+    };
+    for(int q = 0; q < 4; q++)
+        if(quadrant[q] == UINT32_MAX)
+            return UINT32_MAX;
+    return mc_node_of(t, level, quadrant[mc_nw], quadrant[mc_ne], quadrant[mc_sw], quadrant[mc_se]);
+}
+
+static void __visit(const mc_tree* t, uint32_t id, uint32_t level, uint64_t ox, uint64_t oy,
+    const uint64_t window[4], mc_leaf_fn leaf, void* ctx) {
+    uint64_t size = (uint64_t) 1 << level;
+    if(id == 0 || ox >= window[2] || oy >= window[3] || ox + size <= window[0] || oy + size <= window[1])
+        return;
+    const mc_node* n = &t->nodes[id];
+    if(level == MC_LEAF_LEVEL) {
+        leaf(ctx, ox, oy, n->bits);
+        return;
+    }
+    uint64_t half = size / 2;
+    __visit(t, n->child[mc_nw], level - 1, ox, oy, window, leaf, ctx);
+    __visit(t, n->child[mc_ne], level - 1, ox + half, oy, window, leaf, ctx);
+    __visit(t, n->child[mc_sw], level - 1, ox, oy + half, window, leaf, ctx);
+    __visit(t, n->child[mc_se], level - 1, ox + half, oy + half, window, leaf, ctx);
+}
+
+// box of a live node relative to its own corner, shared nodes are worked out once
+static const mc_box* __bounds(const mc_tree* t, uint32_t id, mc_box* boxes) {
+    mc_box* box = &boxes[id];
+    if(box->x1)
+        return box;
+    const mc_node* n = &t->nodes[id];
+
+    if(n->level == MC_LEAF_LEVEL) {
+        uint64_t rows = n->bits;
+        rows |= rows >> 32;
+        rows |= rows >> 16;
+        rows |= rows >> 8;
+        rows &= 0xff;
+        box->x0 = (uint64_t) __builtin_ctzll(n->bits) / 8;
+        box->x1 = (uint64_t) (63 - __builtin_clzll(n->bits)) / 8 + 1;
+        box->y0 = (uint64_t) __builtin_ctzll(rows);
+        box->y1 = (uint64_t) (63 - __builtin_clzll(rows)) + 1;
+        return box;
+    }
+
+    uint64_t half = (uint64_t) 1 << (n->level - 1);
+    box->x0 = box->y0 = UINT64_MAX;
+    for(int q = 0; q < 4; q++) {
+        if(n->child[q] == 0)
+            continue;
+        const mc_box* c = __bounds(t, n->child[q], boxes);
+        uint64_t dx = q & 1 ? half : 0, dy = q & 2 ? half : 0;
+        box->x0 = c->x0 + dx < box->x0 ? c->x0 + dx : box->x0;
+        box->y0 = c->y0 + dy < box->y0 ? c->y0 + dy : box->y0;
+        box->x1 = c->x1 + dx > box->x1 ? c->x1 + dx : box->x1;
+        box->y1 = c->y1 + dy > box->y1 ? c->y1 + dy : box->y1;
+    }
+    return box;
+}
+
+// children first, numbered as they are written, each node only once
+static bool __write_node(const mc_tree* t, FILE* fp, uint32_t id, uint32_t* numbers, uint32_t* next) {
+    if(id == 0 || numbers[id])
+        return true;
+    const mc_node* n = &t->nodes[id];
+
+    if(n->level == MC_LEAF_LEVEL) {
+        // rows of . and *, trailing dead cells and rows left out
+        char line[8 * 9 + 2];
+        size_t length = 0;
+        for(int y = 0; y < 8; y++) {
+            int last = -1;
+            for(int x = 0; x < 8; x++)
+                if(n->bits >> (8 * x + y) & 1)
+                    last = x;
+            for(int x = 0; x <= last; x++)
+                line[length++] = n->bits >> (8 * x + y) & 1 ? '*' : '.';
+            line[length++] = '$';
+        }
+        while(length > 1 && line[length - 1] == '$' && line[length - 2] == '$')
+            length--;
+        line[length++] = '\n';
+        fwrite(line, 1, length, fp);
+    } else {
+        for(int q = 0; q < 4; q++)
+            if(!__write_node(t, fp, n->child[q], numbers, next))
+                return false;
+        fprintf(fp, "%u %u %u %u %u\n", n->level, numbers[n->child[mc_nw]], numbers[n->child[mc_ne]],
+            numbers[n->child[mc_sw]], numbers[n->child[mc_se]]);
+    }
+    numbers[id] = (*next)++;
+    return !ferror(fp);
+}
+
+static int __parse_leaf(const char* line, uint64_t* bits) {
+    uint64_t x = 0, y = 0;
+    *bits = 0;
+    for(const char* c = line; *c; c++) {
+        if(*c == '$') {
+            x = 0;
+            y++;
+        } else if(*c == '.' || *c == '*') {
+            if(x >= 8 || y >= 8)
+                return MC_FORMAT_ERROR;
+            *bits |= (uint64_t) (*c == '*') << (8 * x + y);
+            x++;
+        } else if(*c != ' ' && *c != '\t') {
+            return MC_FORMAT_ERROR;
+        }
+    }
+    return MC_OK;
+}
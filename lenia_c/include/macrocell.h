@@ -0,0 +1,119 @@
+#ifndef MACROCELL_H
+#define MACROCELL_H
+
+// Golly's Macrocell (.mc) pattern files and the quadtree they describe. A
+// node of level k is a 2^k square made of four level k - 1 quadrants, and
+// level 3 nodes are 8x8 leaves of cells. Nodes are hash-consed: making a
+// node that already exists returns the existing one, so every distinct
+// subtree is stored once however often it repeats, both when a file is read
+// and when a board is turned into a tree. Node 0 is the empty square of
+// every level.
+//
+//     mc_tree t;
+//     mc_init(&t);
+//     mc_read(&t, "metapixel.mc");                    // never flattened
+//     mc_for_each_leaf(&t, 0, 0, w, h, place, ctx);   // only what a w x h board shows
+//     t.root = mc_build(&t, w, h, board_tile, ctx);   // repeated tiles become one node
+//     mc_write(&t, "board.mc");
+//     mc_destroy(&t);
+//
+// Only two state patterns are read, the levels 1 and 2 that multi-state
+// files use give MC_FORMAT_ERROR.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MC_LEAF_LEVEL 3
+#define MC_MAX_LEVEL 62     /* coordinates are uint64_t */
+#define MC_RULE_MAX 64
+
+#define MC_OK 0
+#define MC_FILE_ERROR -1
+#define MC_MALLOC_ERROR -2
+#define MC_FORMAT_ERROR -3
+
+enum { mc_nw = 0, mc_ne = 1, mc_sw = 2, mc_se = 3 };
+
+typedef struct {
+    uint32_t child[4];      // mc_nw .. mc_se, above MC_LEAF_LEVEL
+    uint64_t bits;          // level MC_LEAF_LEVEL: cell (x, y) at bit 8 * x + y
+    uint64_t population;
+    uint32_t level;
+} mc_node;
+
+typedef struct {
+    mc_node* nodes;         // nodes[0] is the empty node
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* slots;        // open addressing on the node's contents, 0 is a free slot
+    uint32_t slot_mask;
+    uint32_t root;
+    uint32_t root_level;    // the tree covers 2^root_level cells square from (0, 0)
+    char rule[MC_RULE_MAX];
+    uint64_t generation;
+} mc_tree;
+
+/* The 8x8 tile with its top left cell at (x, y), cell (x + dx, y + dy) at bit 8 * dx + dy */
+typedef uint64_t (*mc_tile_fn)(void* ctx, uint64_t x, uint64_t y);
+
+/* A leaf that isn't empty, its top left cell at (x, y) of the tree */
+typedef void (*mc_leaf_fn)(void* ctx, uint64_t x, uint64_t y, uint64_t bits);
+
+/*  An empty tree, rule B3/S23
+
+    Returns:
+        MC_OK on success
+        MC_MALLOC_ERROR if the node table could not be allocated
+*/
+int mc_init(mc_tree* t);
+
+/* Free the nodes */
+void mc_destroy(mc_tree* t);
+
+/* The leaf holding bits, 0 if they are all dead. UINT32_MAX when out of memory */
+uint32_t mc_leaf(mc_tree* t, uint64_t bits);
+
+/* The level node with these quadrants, 0 if all are empty. UINT32_MAX when out of memory */
+uint32_t mc_node_of(mc_tree* t, uint32_t level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+
+/*  Read path into t, replacing what was there. The last node in the file
+    is the root, rule and generation come from the #R and #G lines.
+
+    Returns:
+        MC_OK on success
+        MC_FILE_ERROR if the file could not be read
+        MC_MALLOC_ERROR if the nodes could not be allocated
+        MC_FORMAT_ERROR if the file is not a two state Macrocell file
+*/
+int mc_read(mc_tree* t, const char* path);
+
+/*  Write the tree under t->root to path, each distinct node once. On
+    failure the file is removed.
+
+    Returns:
+        MC_OK on success
+        MC_FILE_ERROR if the file could not be written
+        MC_MALLOC_ERROR if the node numbering could not be allocated
+*/
+int mc_write(const mc_tree* t, const char* path);
+
+/*  The tree of a width x height board, tile by tile: t->root_level is set
+    to the smallest level that covers it, tiles entirely past the board
+    are never asked for. Returns the root, UINT32_MAX when out of memory.
+*/
+uint32_t mc_build(mc_tree* t, uint64_t width, uint64_t height, mc_tile_fn tile, void* ctx);
+
+/* Call leaf for each non-empty leaf that overlaps the width x height window at (x, y) */
+void mc_for_each_leaf(const mc_tree* t, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+    mc_leaf_fn leaf, void* ctx);
+
+/*  The live cells' bounding box, x0 <= x < x1 and y0 <= y < y1, worked out
+    once per distinct node rather than once per leaf
+
+    Returns:
+        false if the tree is empty or the boxes could not be allocated
+*/
+bool mc_bounds(const mc_tree* t, uint64_t* x0, uint64_t* y0, uint64_t* x1, uint64_t* y1);
+
+#endif
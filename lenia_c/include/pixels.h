@@ -0,0 +1,117 @@
+#ifndef PIXELS_H
+#define PIXELS_H
+
+// RGBA8 image of a two state board, filled without raylib so it can be built
+// and checked headless. The image keeps the board's own memory order: image
+// row i is board column i (cells[i][0 .. board_height)), so filling it never
+// transposes and bit k of a packed board is texel k. render.h draws it with
+// the axes swapped back.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// texel as the bytes r, g, b, a in memory (PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+#define PIXELS_RGBA(r, g, b, a) \
+    ((uint32_t) (r) | (uint32_t) (g) << 8 | (uint32_t) (b) << 16 | (uint32_t) (a) << 24)
+
+#define PIXELS_WHITE PIXELS_RGBA(255, 255, 255, 255)
+#define PIXELS_BLACK PIXELS_RGBA(0, 0, 0, 255)
+
+typedef struct {
+    uint32_t* data;     // width * height texels, row major
+    size_t width;       // texels per row, the board height
+    size_t height;      // rows, the board width
+    uint32_t alive;
+    uint32_t dead;
+} pixel_buffer;
+
+#define PIXELS_OK 0
+#define PIXELS_MALLOC_ERROR -2
+
+/*  Allocate the image for a board_width x board_height board, all dead
+
+    Returns:
+        PIXELS_OK on success
+        PIXELS_MALLOC_ERROR if the buffer could not be allocated
+*/
+int pixels_init(pixel_buffer* p, size_t board_width, size_t board_height, uint32_t alive, uint32_t dead);
+
+void pixels_destroy(pixel_buffer* p);
+
+/*  Fill image row i from board column i: cell j is the bool at
+    first + j * stride bytes, so a column of cell structs works as well as a
+    plain bool array (stride 1, expanded 16 cells at a time with SSE2).
+*/
+void pixels_row_from_bools(pixel_buffer* p, size_t row, const void* first, size_t stride);
+
+/*  Fill the whole image from a packed board, texel k from bit k of bits
+    (bits[k / 64] >> k % 64, the frontier's cell index order). Expanded a
+    byte at a time with SSE2.
+*/
+void pixels_from_bits(pixel_buffer* p, const uint64_t* bits);
+
+/* Same as pixels_row_from_bools for texels col .. col + count - 1 of the row */
+void pixels_span_from_bools(pixel_buffer* p, size_t row, size_t col, size_t count, const void* first, size_t stride);
+
+/* Same as pixels_from_bits for texels col .. col + count - 1 of the row */
+void pixels_span_from_bits(pixel_buffer* p, size_t row, size_t col, size_t count, const uint64_t* bits);
+
+static inline uint32_t* pixels_row(const pixel_buffer* p, size_t row) {
+    return p->data + row * p->width;
+}
+
+// Which square tiles of the image changed since the last upload, one bit per
+// tile. The step marks the cells it flips, dirty_collect turns the marked
+// tiles into a few rectangles: runs of tiles along a row, stacked when the
+// next row has a run with the same columns.
+typedef struct {
+    uint64_t* bits;     // tiles_y rows of row_words words
+    size_t row_words;
+    size_t tiles_x;     // tiles along an image row
+    size_t tiles_y;
+    unsigned shift;     // tile side is 1 << shift texels
+    size_t width;       // image size, the last tiles are clipped to it
+    size_t height;
+    size_t* open;       // scratch for dirty_collect, rects still growing down
+} dirty_tiles;
+
+typedef struct {
+    size_t x;           // first texel column
+    size_t y;           // first texel row
+    size_t width;
+    size_t height;
+} dirty_rect;
+
+/*  Tiles of (1 << shift) texels square over a width x height image, all dirty
+
+    Returns:
+        PIXELS_OK on success
+        PIXELS_MALLOC_ERROR if the bitmap could not be allocated
+*/
+int dirty_init(dirty_tiles* d, size_t width, size_t height, unsigned shift);
+
+void dirty_destroy(dirty_tiles* d);
+
+void dirty_mark_all(dirty_tiles* d);
+
+/*  Write the dirty area as rectangles to rects (room for dirty_max_rects)
+    and clear every mark. Returns the number of rectangles.
+*/
+size_t dirty_collect(dirty_tiles* d, dirty_rect* rects);
+
+static inline size_t dirty_max_rects(const dirty_tiles* d) {
+    return d->tiles_y * ((d->tiles_x + 1) / 2);
+}
+
+/* Mark the tile holding texel (row, col), safe to call from several threads */
+static inline void dirty_mark(dirty_tiles* d, size_t row, size_t col) {
+    size_t tx = col >> d->shift;
+    uint64_t* word = &d->bits[(row >> d->shift) * d->row_words + tx / 64];
+    uint64_t mask = (uint64_t) 1 << (tx % 64);
+    // most changed cells land in a tile that is already marked
+    if(!(__atomic_load_n(word, __ATOMIC_RELAXED) & mask))
+        __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -3,7 +3,7 @@
 int main()
 {
     Queue q;
-    initializeQueue(&q);
+    initializeQueue(&q, 0);
 
     // Enqueue elements
     enqueue(&q, 10);
@@ -16,14 +16,14 @@ int main()
     printQueue(&q);
 
     // Peek front element
-    printf("Front element: %d\n", peek(&q));
+    printf("Front element: %" PRIu64 "\n", peek(&q));
 
     // Dequeue an element
     dequeue(&q);
     printQueue(&q);
 
     // Peek front element after dequeue
-    printf("Front element after dequeue: %d\n", peek(&q));
+    printf("Front element after dequeue: %" PRIu64 "\n", peek(&q));
 
     return 0;
 }
\ No newline at end of file
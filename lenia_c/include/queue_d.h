@@ -1,113 +1,151 @@
-#ifndef QUEUE_H
-#define QUEUE_H
+#ifndef QUEUE_D_H
+#define QUEUE_D_H
 
-// C Program to demonstrate how to Implement a queue
+// Growable circular queue of uint64_t. The capacity is a power of two so
+// positions wrap with a mask, it doubles when full, and reset just forgets
+// the contents. Everything is static inline so several translation units can
+// include it.
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 
+#define QUEUE_MIN_SIZE 16
+
 // Defining the Queue structure
 typedef struct {
     uint64_t* items;
-    int front;
-    int rear;
-    size_t size;
+    size_t front;   // index of the oldest item
+    size_t count;
+    size_t size;    // capacity, 0 or a power of two
 } Queue;
 
-// Function to initialize the queue
-void initializeQueue(Queue* q, size_t size) {
-    q->front = -1;  // -1 means the queue is empty
-    q->rear = -1;
-    
-    q->size = 0;
+// Grow to hold at least need items, keeping their order
+static inline bool __queueReserve(Queue* q, size_t need) {
+    if(need <= q->size)
+        return true;
+
+    size_t size = q->size ? q->size : QUEUE_MIN_SIZE;
+    while(size < need)
+        size <<= 1;
+
+    uint64_t* items = (uint64_t*) malloc(sizeof(uint64_t) * size);
+    if(!items)
+        return false;
 
-    if(size > 0) {
-        if(q->size == size)
-            return;
-        
-        q->size = size;
-        q->items = (uint64_t*) malloc(sizeof(uint64_t) * size);
+    // unwrap the old contents to the start of the new buffer
+    if(q->count) {
+        size_t first = q->size - q->front < q->count ? q->size - q->front : q->count;
+        memcpy(items, q->items + q->front, first * sizeof(uint64_t));
+        memcpy(items + first, q->items, (q->count - first) * sizeof(uint64_t));
     }
 
+    free(q->items);
+    q->items = items;
+    q->front = 0;
+    q->size = size;
+    return true;
+}
+
+// Function to initialize the queue, size is only the initial capacity
+static inline void initializeQueue(Queue* q, size_t size) {
+    q->items = NULL;
+    q->front = 0;
+    q->count = 0;
+    q->size = 0;
+
+    if(size > 0)
+        __queueReserve(q, size);
 }
 
 // Function to clear queue items (optional)
-void destroyItems(Queue* q) {
+static inline void destroyItems(Queue* q) {
     if(q->items)
-        memset(q->items, 0, q->size);
+        memset(q->items, 0, q->size * sizeof(uint64_t));
 }
 
-// Function to reset the queue
-void resetQueue(Queue* q) {
-    destroyItems(q);
-    q->front = -1;
-    q->rear = -1;
-    //initializeQueue(q, q->size);
+// Function to reset the queue, keeps the buffer
+static inline void resetQueue(Queue* q) {
+    q->front = 0;
+    q->count = 0;
 }
 
-void freeQueue(Queue* q) {
-    if(q->items)
-        free(q->items);
-    q->size = 0;
-    q->items = NULL;
+static inline void freeQueue(Queue* q) {
+    free(q->items);
     initializeQueue(q, 0);
 }
 
 // Function to check if the queue is empty
-bool isEmpty(Queue* q) { return q->front == -1; }
+static inline bool isEmpty(Queue* q) { return q->count == 0; }
+
+// Function to check if the queue is full (the next enqueue grows it)
+static inline bool isFull(Queue* q) { return q->count == q->size; }
 
-// Function to check if the queue is full
-bool isFull(Queue* q) { return (q->rear + 1) % q->size == (size_t) q->front; }
+static inline size_t queueLength(Queue* q) { return q->count; }
 
 // Function to add an element to the queue (Enqueue
 // operation)
-void enqueue(Queue* q, uint64_t value)
-{
-if (isFull(q)) {
+static inline void enqueue(Queue* q, uint64_t value) {
+    if(isFull(q) && !__queueReserve(q, q->count + 1)) {
         printf("Queue is full\n");
         return;
     }
-    
-    // If the queue is empty, set `front` to 0
-    if (isEmpty(q)) {
-        q->front = 0;
+
+    q->items[(q->front + q->count) & (q->size - 1)] = value;
+    q->count++;
+}
+
+// Add n elements in order, at most two memcpys
+static inline void enqueue_n(Queue* q, const uint64_t* values, size_t n) {
+    if(n == 0)
+        return;
+
+    if(!__queueReserve(q, q->count + n)) {
+        printf("Queue is full\n");
+        return;
     }
-    
-    // Move `rear` to the next position in a circular manner
-    q->rear = (q->rear + 1) % q->size;
-    q->items[q->rear] = value;
+
+    size_t rear = (q->front + q->count) & (q->size - 1);
+    size_t first = q->size - rear < n ? q->size - rear : n;
+    memcpy(q->items + rear, values, first * sizeof(uint64_t));
+    memcpy(q->items, values + first, (n - first) * sizeof(uint64_t));
+    q->count += n;
 }
 
 // Function to remove an element from the queue (Dequeue
 // operation)
-void dequeue(Queue* q)
-{
-    if (isEmpty(q)) {
+static inline void dequeue(Queue* q) {
+    if(isEmpty(q)) {
         printf("Queue is empty\n");
         return;
     }
 
-    if(!q->items) {
-        printf("Queue hasn't been initialized! (no memory allocated)\n");
-        return;
-    }
+    q->front = (q->front + 1) & (q->size - 1);
+    q->count--;
+}
 
-    // If `front` and `rear` are the same, the queue will be empty after this dequeue
-    if (q->front == q->rear) {
-        q->front = -1;
-        q->rear = -1;
-    } else {
-        // Move `front` to the next position in a circular manner
-        q->front = (q->front + 1) % q->size;
-    }
+// Remove up to n elements into values, returns how many were taken
+static inline size_t dequeue_n(Queue* q, uint64_t* values, size_t n) {
+    if(n > q->count)
+        n = q->count;
+    if(n == 0)
+        return 0;
+
+    size_t first = q->size - q->front < n ? q->size - q->front : n;
+    memcpy(values, q->items + q->front, first * sizeof(uint64_t));
+    memcpy(values + first, q->items, (n - first) * sizeof(uint64_t));
+
+    q->front = (q->front + n) & (q->size - 1);
+    q->count -= n;
+    return n;
 }
 
 // Function to get the element at the front of the queue
 // (Peek operation)
-uint64_t peek(Queue* q) {
-    if (isEmpty(q)) {
+static inline uint64_t peek(Queue* q) {
+    if(isEmpty(q)) {
         printf("Queue is empty\n");
         return -1;  // Or some other error code or indicator
     }
@@ -116,19 +154,18 @@ uint64_t peek(Queue* q) {
 
 
 // Function to print the current queue
-void printQueue(Queue* q)
-{
-    if (isEmpty(q)) {
+static inline void printQueue(Queue* q) {
+    if(isEmpty(q)) {
         printf("Queue is empty\n");
         return;
     }
 
     printf("Current Queue: ");
-    for (int i = q->front + 1; i < q->rear; i++) {
-        printf("%04lx ", q->items[i]);
+    for(size_t i = 0; i < q->count; i++) {
+        printf("%04" PRIx64 " ", q->items[(q->front + i) & (q->size - 1)]);
     }
     printf("\n");
 }
 
 
-#endif
\ No newline at end of file
+#endif
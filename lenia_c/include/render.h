@@ -0,0 +1,160 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+// The board as one persistent texture: fill the pixel buffer (pixels.h),
+// upload it and draw it as one scaled quad, instead of a DrawRectangle per
+// cell. The texture is stored in board order (texel row = board column), the
+// quad's texture coordinates swap the axes back so cell (i, j) lands at
+// screen (x + i * scale, y + j * scale).
+//
+// Uploads can be partial: the step marks the cells it flips in t.dirty
+// (dirty_mark(&t.dirty, i, j)), render_collect turns the marked tiles into
+// rectangles, the caller refills just those and render_upload_rects sends
+// them with UpdateTextureRec.
+//
+//     board_texture t;
+//     render_init(&t, board_width, board_height);
+//     size_t n = render_collect(&t);
+//     ...refill t.rects[0 .. n) of t.pixels...
+//     render_upload_rects(&t, n);
+//     render_draw(&t, 0, 0, cell_width_px / 2.0f);
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+#include "rlgl.h"
+#include "pixels.h"
+
+#define RENDER_TILE_SHIFT 5         /* 32x32 texel dirty tiles */
+
+typedef struct {
+    pixel_buffer pixels;
+    dirty_tiles dirty;
+    dirty_rect* rects;          // filled by render_collect
+    uint32_t* staging;          // a rect packed tight for UpdateTextureRec
+    size_t staging_size;        // texels
+    Texture2D texture;
+    uint64_t bytes_uploaded;    // by the last upload
+    uint64_t bytes_total;
+} board_texture;
+
+/* Needs the window (GL context) to exist, PIXELS_MALLOC_ERROR on failure */
+static inline int render_init(board_texture* t, size_t board_width, size_t board_height) {
+    int res = pixels_init(&t->pixels, board_width, board_height, PIXELS_WHITE, PIXELS_BLACK);
+    if(res != PIXELS_OK)
+        return res;
+
+    // starts all dirty so the first upload is a full one
+    res = dirty_init(&t->dirty, t->pixels.width, t->pixels.height, RENDER_TILE_SHIFT);
+    t->rects = malloc(dirty_max_rects(&t->dirty) * sizeof(dirty_rect) + 1);
+    if(res != PIXELS_OK || t->rects == NULL) {
+        free(t->rects);
+        dirty_destroy(&t->dirty);
+        pixels_destroy(&t->pixels);
+        return PIXELS_MALLOC_ERROR;
+    }
+    t->staging = NULL;
+    t->staging_size = 0;
+    t->bytes_uploaded = 0;
+    t->bytes_total = 0;
+
+    Image image = {
+        .data = t->pixels.data,
+        .width = (int) t->pixels.width,
+        .height = (int) t->pixels.height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+    t->texture = LoadTextureFromImage(image);
+    SetTextureFilter(t->texture, TEXTURE_FILTER_POINT);
+    return PIXELS_OK;
+}
+
+static inline void render_unload(board_texture* t) {
+    UnloadTexture(t->texture);
+    free(t->staging);
+    free(t->rects);
+    dirty_destroy(&t->dirty);
+    pixels_destroy(&t->pixels);
+}
+
+/* Send the whole pixel buffer to the GPU */
+static inline void render_upload(board_texture* t) {
+    UpdateTexture(t->texture, t->pixels.data);
+    t->bytes_uploaded = t->pixels.width * t->pixels.height * sizeof(uint32_t);
+    t->bytes_total += t->bytes_uploaded;
+}
+
+/* Rectangles of the image marked since the last call into t->rects, clears the marks */
+static inline size_t render_collect(board_texture* t) {
+    return dirty_collect(&t->dirty, t->rects);
+}
+
+/*  Upload t->rects[0 .. n). Falls back to one full upload once the rects
+    cover half the image, the per call overhead then costs more than the
+    bytes saved.
+*/
+static inline void render_upload_rects(board_texture* t, size_t n) {
+    size_t area = 0, largest = 0;
+    for(size_t k = 0; k < n; k++) {
+        size_t texels = t->rects[k].width * t->rects[k].height;
+        area += texels;
+        if(texels > largest && t->rects[k].width != t->pixels.width)
+            largest = texels;
+    }
+
+    if(area * 2 > t->pixels.width * t->pixels.height) {
+        render_upload(t);
+        return;
+    }
+
+    if(largest > t->staging_size) {
+        uint32_t* staging = realloc(t->staging, largest * sizeof(uint32_t));
+        if(staging == NULL) {
+            render_upload(t);
+            return;
+        }
+        t->staging = staging;
+        t->staging_size = largest;
+    }
+
+    t->bytes_uploaded = 0;
+    for(size_t k = 0; k < n; k++) {
+        dirty_rect r = t->rects[k];
+        const uint32_t* src = pixels_row(&t->pixels, r.y) + r.x;
+        // full width rows are already contiguous, anything else is packed first
+        if(r.width != t->pixels.width) {
+            for(size_t y = 0; y < r.height; y++)
+                memcpy(t->staging + y * r.width, pixels_row(&t->pixels, r.y + y) + r.x, r.width * sizeof(uint32_t));
+            src = t->staging;
+        }
+        UpdateTextureRec(t->texture, (Rectangle) { r.x, r.y, r.width, r.height }, src);
+        t->bytes_uploaded += r.width * r.height * sizeof(uint32_t);
+    }
+    t->bytes_total += t->bytes_uploaded;
+}
+
+/* One quad, call between BeginDrawing and EndDrawing */
+static inline void render_draw(board_texture* t, float x, float y, float scale) {
+    // screen x runs along texel rows (v), screen y along texel columns (u)
+    float x1 = x + t->pixels.height * scale;
+    float y1 = y + t->pixels.width * scale;
+
+    rlSetTexture(t->texture.id);
+    rlBegin(RL_QUADS);
+        rlColor4ub(255, 255, 255, 255);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        rlTexCoord2f(0.0f, 0.0f);
+        rlVertex2f(x, y);
+        rlTexCoord2f(1.0f, 0.0f);
+        rlVertex2f(x, y1);
+        rlTexCoord2f(1.0f, 1.0f);
+        rlVertex2f(x1, y1);
+        rlTexCoord2f(0.0f, 1.0f);
+        rlVertex2f(x1, y);
+    rlEnd();
+    rlSetTexture(0);
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef RING_H
+#define RING_H
+
+// Bounded multi-producer / multi-consumer ring of uint64_t for building a
+// frontier from several threads. Capacity is a power of two and positions are
+// free running 64 bit counters masked into the buffer, so there is no modulo
+// and no wraparound case. Each side keeps a head (reserved) and a tail
+// (committed): a batch is claimed with one CAS on the head, filled or read in
+// place, then published by advancing the tail once the batches claimed before
+// it are done. Producer and consumer counters sit on their own cache lines.
+//
+//     uint64_t start, n = ring_reserve_push(r, want, &start);
+//     for(uint64_t k = 0; k < n; k++)
+//         *ring_slot(r, start + k) = values[k];
+//     ring_commit_push(r, start, n);
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sched.h>
+
+#define RING_CACHE_LINE 64
+#define RING_SPINS 64          /* pauses before a committer yields to a preempted predecessor */
+
+#define RING_OK 0
+#define RING_MALLOC_ERROR -2
+
+typedef struct {
+    _Alignas(RING_CACHE_LINE) uint64_t prod_head;
+    uint64_t prod_tail;
+    _Alignas(RING_CACHE_LINE) uint64_t cons_head;
+    uint64_t cons_tail;
+    _Alignas(RING_CACHE_LINE) uint64_t* items;
+    uint64_t mask;
+    uint64_t capacity;
+} Ring;
+
+// wait until the batches claimed before ours on this side are committed; the
+// acquire carries their writes along to whoever acquires our tail after us
+static inline void __ring_wait(uint64_t* tail, uint64_t start) {
+    for(unsigned spins = 0; __atomic_load_n(tail, __ATOMIC_ACQUIRE) != start; spins++) {
+        if(spins < RING_SPINS) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+/* Capacity is rounded up to a power of two */
+static inline int ring_init(Ring* r, uint64_t capacity) {
+    uint64_t cap = 1;
+    while(cap < capacity)
+        cap <<= 1;
+
+    r->items = (uint64_t*) malloc(cap * sizeof(uint64_t));
+    if(r->items == NULL)
+        return RING_MALLOC_ERROR;
+
+    r->mask = cap - 1;
+    r->capacity = cap;
+    r->prod_head = r->prod_tail = 0;
+    r->cons_head = r->cons_tail = 0;
+    return RING_OK;
+}
+
+static inline void ring_destroy(Ring* r) {
+    free(r->items);
+    r->items = NULL;
+    r->capacity = 0;
+}
+
+static inline uint64_t* ring_slot(Ring* r, uint64_t pos) {
+    return &r->items[pos & r->mask];
+}
+
+/*  Claim up to n free slots starting at *start
+
+    Returns the number claimed, 0 if the ring is full. Every claim must be
+    followed by ring_commit_push with the same start and count.
+*/
+static inline uint64_t ring_reserve_push(Ring* r, uint64_t n, uint64_t* start) {
+    uint64_t head = __atomic_load_n(&r->prod_head, __ATOMIC_RELAXED);
+    uint64_t m;
+    do {
+        uint64_t used = head - __atomic_load_n(&r->cons_tail, __ATOMIC_ACQUIRE);
+        m = r->capacity - used < n ? r->capacity - used : n;
+        if(m == 0)
+            return 0;
+    } while(!__atomic_compare_exchange_n(&r->prod_head, &head, head + m, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    *start = head;
+    return m;
+}
+
+/* Publish a filled batch, in claim order with respect to other producers */
+static inline void ring_commit_push(Ring* r, uint64_t start, uint64_t n) {
+    __ring_wait(&r->prod_tail, start);
+    __atomic_store_n(&r->prod_tail, start + n, __ATOMIC_RELEASE);
+}
+
+/* Claim up to n published items starting at *start, 0 if the ring is empty */
+static inline uint64_t ring_reserve_pop(Ring* r, uint64_t n, uint64_t* start) {
+    uint64_t head = __atomic_load_n(&r->cons_head, __ATOMIC_RELAXED);
+    uint64_t m;
+    do {
+        uint64_t avail = __atomic_load_n(&r->prod_tail, __ATOMIC_ACQUIRE) - head;
+        m = avail < n ? avail : n;
+        if(m == 0)
+            return 0;
+    } while(!__atomic_compare_exchange_n(&r->cons_head, &head, head + m, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    *start = head;
+    return m;
+}
+
+/* Hand a consumed batch's slots back to the producers */
+static inline void ring_commit_pop(Ring* r, uint64_t start, uint64_t n) {
+    __ring_wait(&r->cons_tail, start);
+    __atomic_store_n(&r->cons_tail, start + n, __ATOMIC_RELEASE);
+}
+
+/* Push up to n values, returns how many fit */
+static inline uint64_t ring_push_n(Ring* r, const uint64_t* values, uint64_t n) {
+    uint64_t start, m = ring_reserve_push(r, n, &start);
+    for(uint64_t k = 0; k < m; k++)
+        *ring_slot(r, start + k) = values[k];
+    if(m)
+        ring_commit_push(r, start, m);
+    return m;
+}
+
+/* Pop up to n values, returns how many were taken */
+static inline uint64_t ring_pop_n(Ring* r, uint64_t* values, uint64_t n) {
+    uint64_t start, m = ring_reserve_pop(r, n, &start);
+    for(uint64_t k = 0; k < m; k++)
+        values[k] = *ring_slot(r, start + k);
+    if(m)
+        ring_commit_pop(r, start, m);
+    return m;
+}
+
+static inline bool ring_push(Ring* r, uint64_t value) {
+    return ring_push_n(r, &value, 1) == 1;
+}
+
+static inline bool ring_pop(Ring* r, uint64_t* value) {
+    return ring_pop_n(r, value, 1) == 1;
+}
+
+/* Committed items not yet claimed by a consumer, a snapshot under concurrency */
+static inline uint64_t ring_size(Ring* r) {
+    uint64_t head = __atomic_load_n(&r->cons_head, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&r->prod_tail, __ATOMIC_ACQUIRE) - head;
+}
+
+#endif
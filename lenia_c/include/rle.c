@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "rle.h"
+
+#define RLE_HEADER_MAX 256
+#define RLE_COUNT_MAX (1ull << 40)     /* no board is this wide, a bigger count is a broken file */
+
+/* PRIVATE FUNCTIONS */
+static bool __fill(rle_reader* r);
+static int __peek(rle_reader* r);
+static int __parse_header(rle_reader* r, char* line);
+static bool __flush(rle_reader* r, rle_run_fn run, void* ctx, uint64_t* run_x, uint64_t y, uint64_t* run_length);
+static void __emit(FILE* fp, size_t* line_length, uint64_t count, char tag);
+static uint64_t __next_bit(const uint64_t* bits, uint64_t width, uint64_t from, bool set);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int rle_open(rle_reader* r, const char* path) {
+    memset(r, 0, sizeof(rle_reader));
+    r->fp = fopen(path, "rb");
+    if(r->fp == NULL)
+        return RLE_FILE_ERROR;
+    r->buffer = malloc(RLE_BUFFER);
+    if(r->buffer == NULL) {
+        rle_close(r);
+        return RLE_MALLOC_ERROR;
+    }
+
+    int c;
+    while((c = __peek(r)) != EOF) {
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            r->pos++;
+        } else if(c == '#') {
+            while((c = __peek(r)) != EOF && c != '\n')
+                r->pos++;
+        } else if(c == 'x') {
+            // the header is one line, anything past RLE_HEADER_MAX is dropped
+            char line[RLE_HEADER_MAX];
+            size_t n = 0;
+            while((c = __peek(r)) != EOF && c != '\n') {
+                if(n < RLE_HEADER_MAX - 1)
+                    line[n++] = (char) c;
+                r->pos++;
+            }
+            line[n] = '\0';
+            int status = __parse_header(r, line);
+            if(status != RLE_OK)
+                rle_close(r);
+            return status;
+        } else {
+            break;  // no header, the rows start here
+        }
+    }
+    if(ferror(r->fp)) {
+        rle_close(r);
+        return RLE_FILE_ERROR;
+    }
+    return RLE_OK;
+}
+
+int rle_read_runs(rle_reader* r, rle_run_fn run, void* ctx) {
+    uint64_t count = 0, x = 0, y = 0;
+    uint64_t run_x = 0, run_length = 0;
+
+    while(r->pos < r->length || __fill(r)) {
+        const char* p = r->buffer + r->pos;
+        const char* end = r->buffer + r->length;
+        r->pos = r->length;
+
+        for(; p < end; p++) {
+            char c = *p;
+            if(c >= '0' && c <= '9') {
+                count = count * 10 + (uint64_t) (c - '0');
+                if(count > RLE_COUNT_MAX)
+                    return RLE_FORMAT_ERROR;
+                continue;
+            }
+            // whitespace and the prefixes of multi-state cells keep the count
+            if(c == ' ' || c == '\t' || c == '\r' || c == '\n' || (c >= 'p' && c <= 'y'))
+                continue;
+
+            uint64_t n = count ? count : 1;
+            count = 0;
+            if(c == 'b' || c == '.') {
+                x += n;
+            } else if(c == '$') {
+                if(!__flush(r, run, ctx, &run_x, y, &run_length))
+                    return RLE_STOPPED;
+                y += n;
+                x = 0;
+            } else if(c == '!') {
+                if(!__flush(r, run, ctx, &run_x, y, &run_length))
+                    return RLE_STOPPED;
+                return RLE_OK;
+            } else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                if(run_length == 0 || run_x + run_length != x) {
+                    if(!__flush(r, run, ctx, &run_x, y, &run_length))
+                        return RLE_STOPPED;
+                    run_x = x;
+                }
+                run_length += n;
+                x += n;
+            } else {
+                return RLE_FORMAT_ERROR;
+            }
+        }
+    }
+    if(ferror(r->fp))
+        return RLE_FILE_ERROR;
+    // a file cut off before the ! still gives the rows it has
+    return __flush(r, run, ctx, &run_x, y, &run_length) ? RLE_OK : RLE_STOPPED;
+}
+
+void rle_close(rle_reader* r) {
+    if(r->fp)
+        fclose(r->fp);
+    free(r->buffer);
+    r->fp = NULL;
+    r->buffer = NULL;
+    r->length = 0;
+    r->pos = 0;
+}
+
+int rle_write(const char* path, uint64_t width, uint64_t height, const char* rule, rle_row_fn row, void* ctx) {
+    uint64_t words = (width + 63) / 64;
+    uint64_t* bits = malloc((words ? words : 1) * sizeof(uint64_t));
+    if(bits == NULL)
+        return RLE_MALLOC_ERROR;
+    FILE* fp = fopen(path, "wb");
+    if(fp == NULL) {
+        free(bits);
+        return RLE_FILE_ERROR;
+    }
+    setvbuf(fp, NULL, _IOFBF, RLE_BUFFER);
+
+    fprintf(fp, "x = %llu, y = %llu, rule = %s\n", (unsigned long long) width, (unsigned long long) height,
+        rule ? rule : "B3/S23");
+
+    int status = RLE_OK;
+    size_t line_length = 0;
+    uint64_t pending_rows = 0;  // row ends not written yet, empty rows cost one $ between them
+    for(uint64_t y = 0; y < height; y++) {
+        memset(bits, 0, (words ? words : 1) * sizeof(uint64_t));
+        if(!row(ctx, y, bits)) {
+            status = RLE_STOPPED;
+            break;
+        }
+
+        uint64_t x = 0;
+        while(x < width) {
+            uint64_t start = __next_bit(bits, width, x, true);
+            if(start == width)
+                break;  // the rest of the row is dead, $ says so
+            if(pending_rows) {
+                __emit(fp, &line_length, pending_rows, '$');
+                pending_rows = 0;
+            }
+            if(start > x)
+                __emit(fp, &line_length, start - x, 'b');
+            x = __next_bit(bits, width, start, false);
+            __emit(fp, &line_length, x - start, 'o');
+        }
+        pending_rows++;
+    }
+    __emit(fp, &line_length, 1, '!');
+    fputc('\n', fp);
+
+    free(bits);
+    if(ferror(fp) && status == RLE_OK)
+        status = RLE_FILE_ERROR;
+    if(fclose(fp) != 0 && status == RLE_OK)
+        status = RLE_FILE_ERROR;
+    if(status != RLE_OK)
+        remove(path);
+    return status;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+static bool __fill(rle_reader* r) {
+    r->length = fread(r->buffer, 1, RLE_BUFFER, r->fp);
+    r->pos = 0;
+    return r->length > 0;
+}
+
+static int __peek(rle_reader* r) {
+    if(r->pos == r->length && !__fill(r))
+        return EOF;
+    return (unsigned char) r->buffer[r->pos];
+}
+
+// x = 36, y = 9, rule = B3/S23 with any spacing, fields in any order
+static int __parse_header(rle_reader* r, char* line) {
+    bool has_x = false, has_y = false;
+    char* save = NULL;
+
+    for(char* field = strtok_r(line, ",", &save); field; field = strtok_r(NULL, ",", &save)) {
+        char* equals = strchr(field, '=');
+        if(equals == NULL)
+            return RLE_FORMAT_ERROR;
+        *equals = '\0';
+
+        char* key = field;
+        while(*key == ' ' || *key == '\t')
+            key++;
+        size_t key_length = strcspn(key, " \t");
+        char* value = equals + 1;
+        while(*value == ' ' || *value == '\t')
+            value++;
+        size_t value_length = strcspn(value, " \t\r");
+
+        if(key_length == 1 && (key[0] == 'x' || key[0] == 'y')) {
+            char* digits_end;
+            uint64_t v = strtoull(value, &digits_end, 10);
+            if(digits_end == value)
+                return RLE_FORMAT_ERROR;
+            if(key[0] == 'x') {
+                r->width = v;
+                has_x = true;
+            } else {
+                r->height = v;
+                has_y = true;
+            }
+        } else if(key_length == 4 && strncmp(key, "rule", 4) == 0) {
+            if(value_length >= RLE_RULE_MAX)
+                value_length = RLE_RULE_MAX - 1;
+            memcpy(r->rule, value, value_length);
+            r->rule[value_length] = '\0';
+        }
+    }
+    return has_x && has_y ? RLE_OK : RLE_FORMAT_ERROR;
+}
+
+// the pending run goes out when something other than a live cell follows it
+static bool __flush(rle_reader* r, rle_run_fn run, void* ctx, uint64_t* run_x, uint64_t y, uint64_t* run_length) {
+    if(*run_length == 0)
+        return true;
+    r->cells += *run_length;
+    bool more = run(ctx, *run_x, y, *run_length);
+    *run_length = 0;
+    return more;
+}
+
+// one run, on the next line if it doesn't fit on this one
+static void __emit(FILE* fp, size_t* line_length, uint64_t count, char tag) {
+    char token[24];
+    int length = count > 1 ? snprintf(token, sizeof(token), "%llu%c", (unsigned long long) count, tag)
+                           : snprintf(token, sizeof(token), "%c", tag);
+    if(*line_length + length > RLE_LINE_MAX) {
+        fputc('\n', fp);
+        *line_length = 0;
+    }
+    fwrite(token, 1, length, fp);
+    *line_length += length;
+}
+
+// first x >= from whose bit is set (or clear), width if none
+static uint64_t __next_bit(const uint64_t* bits, uint64_t width, uint64_t from, bool set) {
+    if(from >= width)
+        return width;
+    uint64_t flip = set ? 0 : ~(uint64_t) 0;
+    uint64_t word = from / 64;
+    uint64_t w = (bits[word] ^ flip) & (~(uint64_t) 0 << (from % 64));
+    while(w == 0) {
+        if(++word * 64 >= width)
+            return width;
+        w = bits[word] ^ flip;
+    }
+    uint64_t x = word * 64 + (uint64_t) __builtin_ctzll(w);
+    return x < width ? x : width;
+}
@@ -0,0 +1,91 @@
+#ifndef RLE_H
+#define RLE_H
+
+// Life RLE pattern files, read and written a buffer at a time so a pattern
+// of any size costs a fixed amount of memory to stream. The reader hands
+// out runs of live cells: a dead run or a row skip costs nothing per cell,
+// and the caller gets one call per run to place it however its board is
+// laid out. The writer takes rows as packed bits and finds the runs a word
+// at a time.
+//
+//     rle_reader r;
+//     if(rle_open(&r, "gun.rle") == RLE_OK) {
+//         ...r.width, r.height and r.rule from the x = , y = , rule = header...
+//         rle_read_runs(&r, place_run, ctx);          // place_run(ctx, x, y, count)
+//         rle_close(&r);
+//     }
+//     rle_write("board.rle", width, height, "B3/S23", board_row, ctx);
+//
+// x counts columns left to right and y rows top to bottom. Any state other
+// than b or . is read as alive, so multi-state files load as their support.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RLE_BUFFER (64 * 1024)
+#define RLE_RULE_MAX 64
+#define RLE_LINE_MAX 70     /* longest line the writer emits, as the format asks */
+
+#define RLE_OK 0
+#define RLE_FILE_ERROR -1
+#define RLE_MALLOC_ERROR -2
+#define RLE_FORMAT_ERROR -3
+#define RLE_STOPPED -4
+
+/* A run of count live cells from (x, y) to the right, false stops reading */
+typedef bool (*rle_run_fn)(void* ctx, uint64_t x, uint64_t y, uint64_t count);
+
+/* Fill row y, (width + 63) / 64 words with cell x at bit x % 64 of word x / 64 */
+typedef bool (*rle_row_fn)(void* ctx, uint64_t y, uint64_t* bits);
+
+typedef struct {
+    FILE* fp;
+    char* buffer;
+    size_t length;          // bytes in buffer
+    size_t pos;             // next byte to read
+    uint64_t width;         // from the header, 0 if the file had none
+    uint64_t height;
+    char rule[RLE_RULE_MAX];    // as written in the header, empty if none
+    uint64_t cells;         // live cells read so far
+} rle_reader;
+
+/*  Open path and read up to the first row: # lines are skipped and the
+    header, if there is one, fills width, height and rule
+
+    Returns:
+        RLE_OK on success
+        RLE_FILE_ERROR if the file could not be opened
+        RLE_MALLOC_ERROR if the buffer could not be allocated
+        RLE_FORMAT_ERROR if the header could not be parsed
+*/
+int rle_open(rle_reader* r, const char* path);
+
+/*  Read the rows up to ! or the end of the file, calling run for each run
+    of live cells. Runs that touch are joined, so "2o3o" is one run of five.
+
+    Returns:
+        RLE_OK on success
+        RLE_FILE_ERROR if reading failed
+        RLE_FORMAT_ERROR on a character that has no place in a row
+        RLE_STOPPED if run returned false
+*/
+int rle_read_runs(rle_reader* r, rle_run_fn run, void* ctx);
+
+/* Close the file and free the buffer */
+void rle_close(rle_reader* r);
+
+/*  Write a width x height pattern to path, row by row from row. Trailing
+    dead cells and empty rows at the end are left out. On failure the file
+    is removed.
+
+    Returns:
+        RLE_OK on success
+        RLE_FILE_ERROR if the file could not be written
+        RLE_MALLOC_ERROR if a row could not be allocated
+        RLE_STOPPED if row returned false
+*/
+int rle_write(const char* path, uint64_t width, uint64_t height, const char* rule, rle_row_fn row, void* ctx);
+
+#endif
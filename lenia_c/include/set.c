@@ -42,11 +42,24 @@ int set_init_alt(SimpleSet *set, uint64_t num_els, set_hash_function hash) {
     }
     set->used_nodes = 0;
     set->hash_function = (hash == NULL) ? &__default_hash : hash;
+    set->arena = NULL;
     return SET_TRUE;
 }
 
+int set_init_arena(SimpleSet *set, uint64_t num_els, set_hash_function hash, set_arena *arena) {
+    int res = set_init_alt(set, num_els, hash);
+    if (res == SET_TRUE)
+        set->arena = arena;
+    return res;
+}
+
 int set_clear(SimpleSet *set) {
     uint64_t i;
+    if (set->arena != NULL) { // nodes belong to the arena
+        memset(set->nodes, 0, set->number_nodes * sizeof(simple_set_node*));
+        set->used_nodes = 0;
+        return SET_TRUE;
+    }
     for(i = 0; i < set->number_nodes; ++i) {
         if (set->nodes[i] != NULL) {
             __free_index(set, i);
@@ -62,6 +75,7 @@ int set_destroy(SimpleSet *set) {
     set->number_nodes = 0;
     set->used_nodes = 0;
     set->hash_function = NULL;
+    set->arena = NULL;
     return SET_TRUE;
 }
 
@@ -266,7 +280,8 @@ static int __set_add(SimpleSet *set, const char *key, uint64_t hash) {
     // add element in
     int res = __get_index(set, key, hash, &index);
     if (res == SET_FALSE) { // this is the first open slot
-        __assign_node(set, key, hash, index);
+        if (__assign_node(set, key, hash, index) != SET_TRUE)
+            return SET_MALLOC_ERROR;
         ++set->used_nodes;
         return SET_TRUE;
     }
@@ -296,30 +311,57 @@ static int __get_index(SimpleSet *set, const char *key, uint64_t hash, uint64_t
 
 static int __assign_node(SimpleSet *set, const char *key, uint64_t hash, uint64_t index) {
     size_t len = strlen(key);
-    set->nodes[index] = (simple_set_node*)malloc(sizeof(simple_set_node));
-    set->nodes[index]->_key = (char*)calloc(len + 1, sizeof(char));
+    if (set->arena != NULL) { // node and key in one bump
+        simple_set_node *node = (simple_set_node*)set_arena_alloc(set->arena, sizeof(simple_set_node) + len + 1);
+        if (node == NULL)
+            return SET_MALLOC_ERROR;
+        node->_key = (char*)(node + 1);
+        set->nodes[index] = node;
+    } else {
+        set->nodes[index] = (simple_set_node*)malloc(sizeof(simple_set_node));
+        if (set->nodes[index] == NULL)
+            return SET_MALLOC_ERROR;
+        set->nodes[index]->_key = (char*)calloc(len + 1, sizeof(char));
+        if (set->nodes[index]->_key == NULL) {
+            free(set->nodes[index]);
+            set->nodes[index] = NULL;
+            return SET_MALLOC_ERROR;
+        }
+    }
     memcpy(set->nodes[index]->_key, key, len);
+    set->nodes[index]->_key[len] = '\0';
     set->nodes[index]->_hash = hash;
     return SET_TRUE;
 }
 
 static void __free_index(SimpleSet *set, uint64_t index) {
-    free(set->nodes[index]->_key);
-    free(set->nodes[index]);
+    if (set->arena == NULL) {
+        free(set->nodes[index]->_key);
+        free(set->nodes[index]);
+    }
     set->nodes[index] = NULL;
 }
 
 static void __relayout_nodes(SimpleSet *set, uint64_t start, short end_on_null) {
     uint64_t index = 0, i;
+    if (end_on_null == 0) {
+        // after a removal: re-place the rest of the probe run, which can wrap past the end
+        for (i = (start + 1) % set->number_nodes; set->nodes[i] != NULL; i = (i + 1) % set->number_nodes) {
+            __get_index(set, set->nodes[i]->_key, set->nodes[i]->_hash, &index);
+            if (i != index) {
+                set->nodes[index] = set->nodes[i];
+                set->nodes[i] = NULL;
+            }
+        }
+        return;
+    }
     for (i = start; i < set->number_nodes; ++i) {
         if(set->nodes[i] != NULL) {
             __get_index(set, set->nodes[i]->_key, set->nodes[i]->_hash, &index);
-            if (i != index) { // we are moving this node
-                __assign_node(set, set->nodes[i]->_key, set->nodes[i]->_hash, index);
-                __free_index(set, i);
+            if (i != index) { // we are moving this node, hand over the pointer
+                set->nodes[index] = set->nodes[i];
+                set->nodes[i] = NULL;
             }
-        } else if (end_on_null == 0 && i != start) {
-            break;
         }
     }
-}
\ No newline at end of file
+}
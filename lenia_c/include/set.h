@@ -34,12 +34,53 @@ typedef struct  {
     uint64_t _hash;
 } SimpleSetNode, simple_set_node;
 
+/*  Optional bump allocator for nodes and keys: they are carved out of large
+    blocks and only given back all at once by set_arena_reset, which keeps the
+    blocks for reuse. One arena can back several sets. */
+typedef struct set_arena_block {
+    struct set_arena_block *next;
+    uint64_t size;
+    uint64_t used;
+} set_arena_block;
+
+typedef struct {
+    set_arena_block *head;
+    set_arena_block *current;
+    uint64_t block_size;
+} SetArena, set_arena;
+
+#ifndef SET_SWISS
 typedef struct  {
     simple_set_node **nodes;
     uint64_t number_nodes;
     uint64_t used_nodes;
     set_hash_function hash_function;
+    set_arena *arena;           /* NULL: nodes are malloc'd one by one */
 } SimpleSet, simple_set;
+#else
+/*  Swiss table layout (set_swiss.c, build with -DSET_SWISS): one control byte
+    per slot, 0x80 when empty or the top 7 hash bits when full, scanned 16 at
+    a time. Keys shorter than SET_SWISS_INLINE bytes live in the slot. */
+#define SET_SWISS_INLINE 16
+
+typedef struct {
+    uint64_t _hash;
+    uint64_t _len;
+    union {
+        char _small[SET_SWISS_INLINE];
+        char *_big;
+    } _key;
+} SwissSetSlot, swiss_set_slot;
+
+typedef struct  {
+    uint8_t *ctrl;              /* number_nodes + 16, the tail mirrors the head */
+    swiss_set_slot *slots;
+    uint64_t number_nodes;      /* power of two, at least 16 */
+    uint64_t used_nodes;
+    set_hash_function hash_function;
+    set_arena *arena;           /* NULL: long keys are malloc'd */
+} SimpleSet, simple_set;
+#endif
 
 
 
@@ -55,6 +96,29 @@ static __inline__ int set_init(SimpleSet *set) {
     return set_init_alt(set, 1024, NULL);
 }
 
+/*  Same as set_init_alt but nodes and keys come from arena. Clearing,
+    removing or destroying then never frees them, set_arena_reset does
+    (only once no set using the arena still holds keys).
+*/
+int set_init_arena(SimpleSet *set, uint64_t num_els, set_hash_function hash, set_arena *arena);
+
+/*  Set up an arena handing out blocks of block_size bytes (0 for 64 KiB)
+
+    Returns:
+        SET_MALLOC_ERROR: If the first block could not be allocated
+        SET_TRUE: On success
+*/
+int set_arena_init(set_arena *arena, uint64_t block_size);
+
+/* bytes (rounded up to 8) from the arena, NULL if a new block can't be had */
+void* set_arena_alloc(set_arena *arena, uint64_t bytes);
+
+/* Forget everything carved from the arena in O(1), its blocks are kept */
+void set_arena_reset(set_arena *arena);
+
+/* Free every block of the arena */
+void set_arena_destroy(set_arena *arena);
+
 /* Utility function to clear out the set */
 int set_clear(SimpleSet *set);
 
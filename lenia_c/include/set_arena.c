@@ -0,0 +1,68 @@
+#include <stdlib.h>
+
+#include "set.h"
+
+#define SET_ARENA_BLOCK_SIZE 65536      /* default bytes per arena block */
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int set_arena_init(set_arena *arena, uint64_t block_size) {
+    arena->block_size = (block_size == 0) ? SET_ARENA_BLOCK_SIZE : block_size;
+    arena->head = (set_arena_block*) malloc(sizeof(set_arena_block) + arena->block_size);
+    if (arena->head == NULL) {
+        arena->current = NULL;
+        return SET_MALLOC_ERROR;
+    }
+    arena->head->next = NULL;
+    arena->head->size = arena->block_size;
+    arena->head->used = 0;
+    arena->current = arena->head;
+    return SET_TRUE;
+}
+
+void set_arena_reset(set_arena *arena) {
+    // later blocks are rewound as set_arena_alloc moves into them again
+    arena->current = arena->head;
+    if (arena->head != NULL)
+        arena->head->used = 0;
+}
+
+void set_arena_destroy(set_arena *arena) {
+    set_arena_block *block = arena->head;
+    while (block != NULL) {
+        set_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+void* set_arena_alloc(set_arena *arena, uint64_t bytes) {
+    bytes = (bytes + 7) & ~(uint64_t)7; // keep nodes 8 byte aligned
+    while (arena->current != NULL && arena->current->used + bytes > arena->current->size) {
+        if (arena->current->next == NULL)
+            break;
+        arena->current = arena->current->next;
+        arena->current->used = 0;
+    }
+    if (arena->current == NULL || arena->current->used + bytes > arena->current->size) {
+        uint64_t size = bytes > arena->block_size ? bytes : arena->block_size;
+        set_arena_block *block = (set_arena_block*)malloc(sizeof(set_arena_block) + size);
+        if (block == NULL)
+            return NULL;
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+        if (arena->current != NULL)
+            arena->current->next = block;
+        else
+            arena->head = block;
+        arena->current = block;
+    }
+    void *p = (char*)(arena->current + 1) + arena->current->used;
+    arena->current->used += bytes;
+    return p;
+}
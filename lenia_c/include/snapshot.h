@@ -0,0 +1,213 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Lock-free triple buffer of packed boards, one writer (the simulation
+// thread) and one reader (the render loop). Each side owns one of the three
+// slots, the third is the last one published. Publishing swaps the writer's
+// slot with it and sets SNAPSHOT_FRESH, acquiring swaps it with the reader's
+// slot only when it is fresh, so neither side ever waits and the reader
+// always gets the newest finished generation. Bit k of a slot is cell
+// k / row_cells, k % row_cells, the same order as pixels_from_bits.
+//
+// Nothing scales with the board per publish: the writer marks the cells it
+// changes, the board is cut in square tiles and a slot only gets the tiles
+// it is behind on copied in. Every snapshot also lists the tiles that differ
+// from the one the reader took before it, tiles of snapshots the reader
+// skipped included, so the reader can follow along tile by tile too.
+//
+//     snapshot_mark(&s, i, j);                       // writer, per changed cell
+//     snapshot_publish(&s, board_bits, generation);
+//
+//     bool fresh;                                    // reader
+//     const board_snapshot* shown = snapshot_acquire(&s, &fresh);
+//     ...if fresh, the tiles set in shown->changed moved...
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SNAPSHOT_CACHE_LINE 64
+#define SNAPSHOT_FRESH 4u           /* above the slot index 0 .. 2 */
+
+#define SNAPSHOT_OK 0
+#define SNAPSHOT_MALLOC_ERROR -2
+
+typedef struct {
+    uint64_t* bits;
+    uint64_t* changed;      // tile bitmap, tiles that moved since the reader's previous snapshot
+    uint64_t generation;
+} board_snapshot;
+
+typedef struct {
+    board_snapshot slots[3];
+    uint64_t words;         // of a slot's bits
+    uint64_t rows;          // rows of row_cells cells
+    uint64_t row_cells;
+    unsigned shift;         // tiles are 1 << shift cells square
+    uint64_t tiles_x;       // tiles along a row
+    uint64_t tiles_y;
+    uint64_t row_words;     // words per row of tiles in a tile bitmap
+    uint64_t tile_words;    // words of a tile bitmap
+
+    // the writer's own
+    uint64_t* pending;      // tiles changed since the last publish
+    uint64_t* stale[3];     // tiles each slot's bits are behind the board in
+    uint64_t* unseen;       // tiles changed since the last publish the reader is known to have taken
+
+    _Alignas(SNAPSHOT_CACHE_LINE) unsigned back;      // the writer's
+    _Alignas(SNAPSHOT_CACHE_LINE) unsigned middle;    // last published, | SNAPSHOT_FRESH until taken
+    _Alignas(SNAPSHOT_CACHE_LINE) unsigned front;     // the reader's
+} snapshot_buffer;
+
+static inline void snapshot_destroy(snapshot_buffer* s) {
+    for(int k = 0; k < 3; k++) {
+        free(s->slots[k].bits);
+        free(s->slots[k].changed);
+        free(s->stale[k]);
+        s->slots[k].bits = NULL;
+        s->slots[k].changed = NULL;
+        s->stale[k] = NULL;
+    }
+    free(s->pending);
+    free(s->unseen);
+    s->pending = NULL;
+    s->unseen = NULL;
+}
+
+/* Every tile of a tile bitmap */
+static inline void __snapshot_fill_tiles(const snapshot_buffer* s, uint64_t* tiles) {
+    for(uint64_t ty = 0; ty < s->tiles_y; ty++) {
+        for(uint64_t w = 0; w < s->row_words; w++) {
+            uint64_t left = s->tiles_x - w * 64;
+            tiles[ty * s->row_words + w] = left >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << left) - 1;
+        }
+    }
+}
+
+/* Three all dead rows x row_cells boards, cut in tiles of 1 << shift cells */
+static inline int snapshot_init(snapshot_buffer* s, uint64_t rows, uint64_t row_cells, unsigned shift) {
+    s->rows = rows;
+    s->row_cells = row_cells;
+    s->words = (rows * row_cells + 63) / 64;
+    s->shift = shift;
+    s->tiles_x = (row_cells + ((uint64_t) 1 << shift) - 1) >> shift;
+    s->tiles_y = (rows + ((uint64_t) 1 << shift) - 1) >> shift;
+    s->row_words = (s->tiles_x + 63) / 64;
+    s->tile_words = s->tiles_y * s->row_words;
+
+    bool failed = false;
+    for(int k = 0; k < 3; k++) {
+        s->slots[k].bits = (uint64_t*) calloc(s->words + 1, sizeof(uint64_t));
+        s->slots[k].changed = (uint64_t*) calloc(s->tile_words + 1, sizeof(uint64_t));
+        s->slots[k].generation = 0;
+        s->stale[k] = (uint64_t*) calloc(s->tile_words + 1, sizeof(uint64_t));
+        failed |= s->slots[k].bits == NULL || s->slots[k].changed == NULL || s->stale[k] == NULL;
+    }
+    s->pending = (uint64_t*) calloc(s->tile_words + 1, sizeof(uint64_t));
+    s->unseen = (uint64_t*) calloc(s->tile_words + 1, sizeof(uint64_t));
+    if(failed || s->pending == NULL || s->unseen == NULL) {
+        snapshot_destroy(s);
+        return SNAPSHOT_MALLOC_ERROR;
+    }
+
+    // all slots match an all dead board already, the first snapshot moves everything
+    __snapshot_fill_tiles(s, s->pending);
+    s->back = 0;
+    s->middle = 1;
+    s->front = 2;
+    return SNAPSHOT_OK;
+}
+
+/* Cell (i, j) changed, safe to call from several writer threads at once */
+static inline void snapshot_mark(snapshot_buffer* s, uint64_t i, uint64_t j) {
+    uint64_t tx = j >> s->shift;
+    uint64_t* word = &s->pending[(i >> s->shift) * s->row_words + tx / 64];
+    uint64_t mask = (uint64_t) 1 << (tx % 64);
+    if(!(__atomic_load_n(word, __ATOMIC_RELAXED) & mask))
+        __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+}
+
+/* The whole board changed */
+static inline void snapshot_mark_all(snapshot_buffer* s) {
+    __snapshot_fill_tiles(s, s->pending);
+}
+
+// bits k0 .. k0 + n - 1 of src into dst
+static inline void __snapshot_copy_span(uint64_t* dst, const uint64_t* src, uint64_t k0, uint64_t n) {
+    while(n) {
+        uint64_t w = k0 / 64, off = k0 % 64;
+        uint64_t take = 64 - off < n ? 64 - off : n;
+        uint64_t mask = (take == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << take) - 1) << off;
+        dst[w] = (dst[w] & ~mask) | (src[w] & mask);
+        k0 += take;
+        n -= take;
+    }
+}
+
+/*  Bring the back slot up to board (the writer's packed board, same layout)
+    and hand it to the reader. Only the tiles marked since the slot was last
+    written are copied. A slot the reader hasn't used becomes the back.
+
+    The writer can't know which snapshot the reader holds, only that it took
+    the previous one when that is no longer fresh here. So changed lists
+    everything since the last publish known to be taken, a superset at
+    worst, never short.
+*/
+static inline void snapshot_publish(snapshot_buffer* s, const uint64_t* board, uint64_t generation) {
+    board_snapshot* back = &s->slots[s->back];
+    uint64_t* stale = s->stale[s->back];
+    const uint64_t tile = (uint64_t) 1 << s->shift;
+
+    for(uint64_t w = 0; w < s->tile_words; w++) {
+        uint64_t marked = s->pending[w];
+        s->stale[0][w] |= marked;
+        s->stale[1][w] |= marked;
+        s->stale[2][w] |= marked;
+        s->unseen[w] |= marked;
+        back->changed[w] = s->unseen[w];
+    }
+
+    for(uint64_t ty = 0; ty < s->tiles_y; ty++) {
+        for(uint64_t w = 0; w < s->row_words; w++) {
+            for(uint64_t bits = stale[ty * s->row_words + w]; bits; bits &= bits - 1) {
+                uint64_t tx = w * 64 + __builtin_ctzll(bits);
+                uint64_t i1 = (ty + 1) * tile < s->rows ? (ty + 1) * tile : s->rows;
+                uint64_t j0 = tx * tile;
+                uint64_t n = j0 + tile < s->row_cells ? tile : s->row_cells - j0;
+                for(uint64_t i = ty * tile; i < i1; i++)
+                    __snapshot_copy_span(back->bits, board, i * s->row_cells + j0, n);
+            }
+            stale[ty * s->row_words + w] = 0;
+        }
+    }
+    back->generation = generation;
+
+    unsigned old = __atomic_exchange_n(&s->middle, s->back | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+    s->back = old & ~SNAPSHOT_FRESH;
+
+    // the previous publish was taken, the reader is behind by this one's changes at most
+    bool taken = !(old & SNAPSHOT_FRESH);
+    for(uint64_t w = 0; w < s->tile_words; w++) {
+        if(taken)
+            s->unseen[w] = s->pending[w];
+        s->pending[w] = 0;
+    }
+}
+
+/*  The newest published snapshot, *fresh tells whether it changed since the
+    last call. Stays valid until the next call, never blocks.
+*/
+static inline const board_snapshot* snapshot_acquire(snapshot_buffer* s, bool* fresh) {
+    *fresh = __atomic_load_n(&s->middle, __ATOMIC_RELAXED) & SNAPSHOT_FRESH;
+    if(*fresh) {
+        unsigned old = __atomic_exchange_n(&s->middle, s->front, __ATOMIC_ACQ_REL);
+        s->front = old & ~SNAPSHOT_FRESH;
+    }
+    return &s->slots[s->front];
+}
+
+static inline bool snapshot_tile_changed(const snapshot_buffer* s, const board_snapshot* shot, uint64_t ty, uint64_t tx) {
+    return shot->changed[ty * s->row_words + tx / 64] >> (tx % 64) & 1;
+}
+
+#endif
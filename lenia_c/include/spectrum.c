@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "fft.h"
+#include "spectrum.h"
+
+typedef struct spectrum_entry {
+    kernel_desc desc;
+    size_t width;
+    size_t height;
+    size_t depth;
+    size_t refs;
+    float* data;
+    struct spectrum_entry* next;
+} spectrum_entry;
+
+static spectrum_entry* cache = NULL;
+
+/* PRIVATE FUNCTIONS */
+static float* __build(const kernel_desc* k, size_t width, size_t height, size_t depth);
+static float __wrapped_dist(size_t i, size_t n);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+const float* spectrum_acquire(const kernel_desc* k, size_t width, size_t height) {
+    return spectrum_acquire3d(k, width, height, 1);
+}
+
+const float* spectrum_acquire3d(const kernel_desc* k, size_t width, size_t height, size_t depth) {
+    for(spectrum_entry* e = cache; e != NULL; e = e->next) {
+        if(e->width == width && e->height == height && e->depth == depth && e->desc.shape == k->shape
+            && e->desc.r_outer == k->r_outer && e->desc.r_inner == k->r_inner) {
+            e->refs++;
+            return e->data;
+        }
+    }
+
+    spectrum_entry* e = malloc(sizeof(spectrum_entry));
+    if(e == NULL)
+        return NULL;
+
+    e->data = __build(k, width, height, depth);
+    if(e->data == NULL) {
+        free(e);
+        return NULL;
+    }
+
+    e->desc = *k;
+    e->width = width;
+    e->height = height;
+    e->depth = depth;
+    e->refs = 1;
+    e->next = cache;
+    cache = e;
+    return e->data;
+}
+
+void spectrum_release(const float* spectrum) {
+    for(spectrum_entry** p = &cache; *p != NULL; p = &(*p)->next) {
+        spectrum_entry* e = *p;
+        if(e->data != spectrum)
+            continue;
+
+        if(--e->refs == 0) {
+            *p = e->next;
+            free(e->data);
+            free(e);
+        }
+        return;
+    }
+}
+
+size_t spectrum_cached(void) {
+    size_t n = 0;
+    for(spectrum_entry* e = cache; e != NULL; e = e->next)
+        n++;
+    return n;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static float __wrapped_dist(size_t i, size_t n) {
+    return (float) (i <= n / 2 ? i : n - i);
+}
+
+static float* __build(const kernel_desc* k, size_t width, size_t height, size_t depth) {
+    const size_t n = width * height * depth;
+    fft3d f;
+    float complex* data = malloc(n * sizeof(float complex));
+    float* real = malloc(n * sizeof(float));
+    if(data == NULL || real == NULL || fft3d_init(&f, width, height, depth) != FFT_OK) {
+        free(data);
+        free(real);
+        return NULL;
+    }
+
+    double total = 0.0;
+    for(size_t z = 0; z < depth; z++) {
+        float dz = __wrapped_dist(z, depth);
+        for(size_t y = 0; y < height; y++) {
+            float dy = __wrapped_dist(y, height);
+            for(size_t x = 0; x < width; x++) {
+                float dx = __wrapped_dist(x, width);
+                float w = kernel_weight(k, sqrtf(dx * dx + dy * dy + dz * dz));
+                data[(z * height + y) * width + x] = w;
+                total += w;
+            }
+        }
+    }
+
+    if(total > 0.0) {
+        float scale = (float) (1.0 / total);
+        for(size_t i = 0; i < n; i++)
+            data[i] *= scale;
+    }
+
+    // symmetric kernel, the imaginary part is only rounding noise
+    fft3d_forward(&f, data);
+    for(size_t i = 0; i < n; i++)
+        real[i] = crealf(data[i]);
+
+    fft3d_destroy(&f);
+    free(data);
+    return real;
+}
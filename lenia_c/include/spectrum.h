@@ -0,0 +1,30 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+// Cache of kernel spectra. Every engine that convolves through the FFT asks
+// here for the transform of its (normalized) kernel on a given board size, so
+// Lenia and SmoothLife runs side by side only build each spectrum once.
+// All kernels are radially symmetric, so their spectra are real and only the
+// real part is kept (half the memory of a complex spectrum).
+
+#include <stddef.h>
+
+#include "kernels.h"
+
+/*  Get the width x height spectrum of kernel k, normalized to sum 1 and
+    centered on cell (0, 0) with wrap around. Reference counted, pair every
+    acquire with a release.
+
+    Returns NULL if memory could not be allocated
+*/
+const float* spectrum_acquire(const kernel_desc* k, size_t width, size_t height);
+
+/* Same for a width x height x depth volume (distance measured in 3D) */
+const float* spectrum_acquire3d(const kernel_desc* k, size_t width, size_t height, size_t depth);
+
+void spectrum_release(const float* spectrum);
+
+/* Number of spectra currently held */
+size_t spectrum_cached(void);
+
+#endif
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "kernels.h"
+#include "spectrum.h"
+#include "volume.h"
+
+/* PRIVATE FUNCTIONS */
+static uint64_t __next_rand(uint64_t* state);
+static size_t __wrap(ptrdiff_t v, size_t n);
+static uint32_t __parse_list(const char** p);
+static uint64_t __count_equals(const uint64_t c[5], unsigned int n);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int life3d_init(life3d* v, size_t width, size_t height, size_t depth) {
+    memset(v, 0, sizeof(life3d));
+    if(width == 0 || width % 64 != 0 || height == 0 || depth == 0)
+        return VOLUME_INVALID;
+
+    v->width = width;
+    v->height = height;
+    v->depth = depth;
+    v->words = width / 64;
+    v->rng = 0x9E3779B97F4A7C15ULL;
+    v->cells = calloc(v->words * height * depth, sizeof(uint64_t));
+    v->next = calloc(v->words * height * depth, sizeof(uint64_t));
+    if(v->cells == NULL || v->next == NULL) {
+        life3d_destroy(v);
+        return VOLUME_MALLOC_ERROR;
+    }
+
+    return life3d_set_rule(v, "4555");
+}
+
+void life3d_destroy(life3d* v) {
+    free(v->cells);
+    free(v->next);
+    v->cells = v->next = NULL;
+}
+
+int life3d_set_rule(life3d* v, const char* rule) {
+    uint32_t survive = 0, birth = 0;
+    size_t len = strlen(rule);
+
+    if(len == 4 && isdigit((unsigned char) rule[0]) && isdigit((unsigned char) rule[1])
+        && isdigit((unsigned char) rule[2]) && isdigit((unsigned char) rule[3])) {
+        for(int n = rule[0] - '0'; n <= rule[1] - '0'; n++)
+            survive |= 1u << n;
+        for(int n = rule[2] - '0'; n <= rule[3] - '0'; n++)
+            birth |= 1u << n;
+    } else {
+        const char* p = rule;
+        while(*p) {
+            char c = (char) toupper((unsigned char) *p++);
+            if(c == 'B')
+                birth = __parse_list(&p);
+            else if(c == 'S')
+                survive = __parse_list(&p);
+            else if(c != '/')
+                return VOLUME_INVALID;
+        }
+    }
+
+    if(((survive | birth) >> 27) != 0)
+        return VOLUME_INVALID;
+
+    v->survive = survive;
+    v->birth = birth;
+    return VOLUME_OK;
+}
+
+void life3d_seed(life3d* v, uint64_t seed, float coverage) {
+    const uint64_t threshold = (uint64_t) (coverage * 4294967296.0f);
+
+    v->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    memset(v->cells, 0, v->words * v->height * v->depth * sizeof(uint64_t));
+
+    for(size_t z = v->depth / 4; z < v->depth - v->depth / 4; z++)
+        for(size_t y = v->height / 4; y < v->height - v->height / 4; y++)
+            for(size_t x = v->width / 4; x < v->width - v->width / 4; x++)
+                if((__next_rand(&v->rng) >> 32) < threshold)
+                    v->cells[(z * v->height + y) * v->words + x / 64] |= (uint64_t) 1 << (x % 64);
+}
+
+void life3d_step(life3d* v) {
+    const size_t words = v->words, h = v->height, d = v->depth;
+    const uint32_t survive = v->survive, birth = v->birth;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for(size_t z = 0; z < d; z++) {
+        for(size_t y = 0; y < h; y++) {
+            const uint64_t* rows[9];
+            size_t k = 0;
+            for(ptrdiff_t dz = -1; dz <= 1; dz++)
+                for(ptrdiff_t dy = -1; dy <= 1; dy++)
+                    rows[k++] = v->cells + (__wrap((ptrdiff_t) z + dz, d) * h + __wrap((ptrdiff_t) y + dy, h)) * words;
+
+            const uint64_t* self = rows[4];
+            uint64_t* out = v->next + (z * h + y) * words;
+
+            for(size_t w = 0; w < words; w++) {
+                const size_t wl = w ? w - 1 : words - 1, wr = w + 1 < words ? w + 1 : 0;
+                // bit sliced count of all 27 cells, c[0] is the lowest bit
+                uint64_t c[5] = { 0, 0, 0, 0, 0 };
+
+                for(k = 0; k < 9; k++) {
+                    const uint64_t* r = rows[k];
+                    uint64_t mid = r[w];
+                    uint64_t left = (mid << 1) | (r[wl] >> 63);
+                    uint64_t right = (mid >> 1) | (r[wr] << 63);
+
+                    // full adder across the x neighbors: 2 bit sum (s1 s0)
+                    uint64_t s0 = left ^ mid ^ right;
+                    uint64_t s1 = (left & mid) | (right & (left ^ mid));
+
+                    uint64_t k0 = c[0] & s0;
+                    c[0] ^= s0;
+                    uint64_t k1 = (c[1] & s1) | (k0 & (c[1] ^ s1));
+                    c[1] ^= s1 ^ k0;
+                    uint64_t k2 = c[2] & k1;
+                    c[2] ^= k1;
+                    uint64_t k3 = c[3] & k2;
+                    c[3] ^= k2;
+                    c[4] ^= k3;
+                }
+
+                // the count includes the voxel itself: survivors see n + 1
+                uint64_t alive = self[w], next = 0;
+                for(unsigned int n = 0; n <= 26; n++) {
+                    if(survive & (1u << n))
+                        next |= alive & __count_equals(c, n + 1);
+                    if(birth & (1u << n))
+                        next |= ~alive & __count_equals(c, n);
+                }
+                out[w] = next;
+            }
+        }
+    }
+
+    uint64_t* tmp = v->cells;
+    v->cells = v->next;
+    v->next = tmp;
+    v->generation++;
+}
+
+uint64_t life3d_population(const life3d* v) {
+    const size_t n = v->words * v->height * v->depth;
+    uint64_t pop = 0;
+
+    #pragma omp parallel for reduction(+:pop) schedule(static)
+    for(size_t i = 0; i < n; i++)
+        pop += (uint64_t) __builtin_popcountll(v->cells[i]);
+
+    return pop;
+}
+
+void life3d_slice(const life3d* v, size_t z, uint8_t* out) {
+    for(size_t y = 0; y < v->height; y++) {
+        const uint64_t* row = v->cells + (z * v->height + y) * v->words;
+        for(size_t x = 0; x < v->width; x++)
+            out[y * v->width + x] = (row[x / 64] >> (x % 64)) & 1 ? 255 : 0;
+    }
+}
+
+int life3d_write_raw(const life3d* v, const char* path) {
+    uint8_t* slice = malloc(v->width * v->height);
+    FILE* fp = fopen(path, "wb");
+    int res = VOLUME_OK;
+
+    if(slice == NULL || fp == NULL) {
+        res = slice == NULL ? VOLUME_MALLOC_ERROR : VOLUME_IO_ERROR;
+    } else {
+        for(size_t z = 0; z < v->depth && res == VOLUME_OK; z++) {
+            life3d_slice(v, z, slice);
+            if(fwrite(slice, 1, v->width * v->height, fp) != v->width * v->height)
+                res = VOLUME_IO_ERROR;
+        }
+    }
+
+    if(fp && fclose(fp) != 0)
+        res = VOLUME_IO_ERROR;
+    free(slice);
+    return res;
+}
+
+int lenia3d_init(lenia3d* v, size_t width, size_t height, size_t depth, field_storage storage, lenia_params params) {
+    memset(v, 0, sizeof(lenia3d));
+    v->depth = depth;
+    v->params = params;
+    v->rng = 0x9E3779B97F4A7C15ULL;
+
+    kernel_desc shell = { KERNEL_LENIA, (float) params.radius, 0.0f };
+
+    if(field_init(&v->state, width, height * depth, storage) != FIELD_OK
+        || field_init(&v->next, width, height * depth, storage) != FIELD_OK
+        || fft3d_init(&v->fft, width, height, depth) != FFT_OK
+        || (v->buf = malloc(width * height * depth * sizeof(float complex))) == NULL
+        || (v->spectrum = spectrum_acquire3d(&shell, width, height, depth)) == NULL) {
+        lenia3d_destroy(v);
+        return VOLUME_MALLOC_ERROR;
+    }
+
+    return VOLUME_OK;
+}
+
+void lenia3d_destroy(lenia3d* v) {
+    if(v->spectrum)
+        spectrum_release(v->spectrum);
+    v->spectrum = NULL;
+    free(v->buf);
+    v->buf = NULL;
+    fft3d_destroy(&v->fft);
+    field_destroy(&v->state);
+    field_destroy(&v->next);
+}
+
+void lenia3d_seed(lenia3d* v, uint64_t seed, float coverage) {
+    const size_t w = v->state.width, h = v->state.height / v->depth, d = v->depth;
+    size_t side = 2 * v->params.radius;
+    if(side > w)
+        side = w;
+    if(side > h)
+        side = h;
+    if(side > d)
+        side = d;
+
+    v->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    field_clear(&v->state);
+
+    size_t cubes = (size_t) (coverage * (float) (w * h * d) / (float) (side * side * side)) + 1;
+    for(size_t c = 0; c < cubes; c++) {
+        size_t x0 = __next_rand(&v->rng) % w;
+        size_t y0 = __next_rand(&v->rng) % h;
+        size_t z0 = __next_rand(&v->rng) % d;
+
+        for(size_t k = 0; k < side; k++)
+            for(size_t j = 0; j < side; j++)
+                for(size_t i = 0; i < side; i++) {
+                    float val = (float) (__next_rand(&v->rng) >> 40) / (float) (1 << 24);
+                    field_set(&v->state, (x0 + i) % w, ((z0 + k) % d) * h + (y0 + j) % h, val);
+                }
+    }
+}
+
+void lenia3d_step(lenia3d* v) {
+    const size_t w = v->state.width, rows = v->state.height, n = w * rows;
+    const float mu = v->params.mu, sigma = v->params.sigma, dt = v->params.dt;
+    float complex* buf = v->buf;
+
+    #pragma omp parallel
+    {
+        float* row = malloc(w * sizeof(float));
+
+        #pragma omp for schedule(static)
+        for(size_t y = 0; y < rows; y++) {
+            if(row == NULL)
+                continue;
+            field_load_row(&v->state, y, row);
+            for(size_t x = 0; x < w; x++)
+                buf[y * w + x] = row[x];
+        }
+
+        free(row);
+    }
+
+    fft3d_forward(&v->fft, buf);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < n; i++)
+        buf[i] *= v->spectrum[i];
+
+    fft3d_inverse(&v->fft, buf);
+
+    #pragma omp parallel
+    {
+        float* row = malloc(w * sizeof(float));
+
+        #pragma omp for schedule(static)
+        for(size_t y = 0; y < rows; y++) {
+            if(row == NULL)
+                continue;
+            field_load_row(&v->state, y, row);
+            for(size_t x = 0; x < w; x++)
+                row[x] = clampf(row[x] + dt * lenia_growth(crealf(buf[y * w + x]), mu, sigma), 0.0f, 1.0f);
+            field_store_row(&v->next, y, row);
+        }
+
+        free(row);
+    }
+
+    field_t tmp = v->state;
+    v->state = v->next;
+    v->next = tmp;
+    v->generation++;
+}
+
+double lenia3d_mass(const lenia3d* v) {
+    float* row = malloc(v->state.width * sizeof(float));
+    double sum = 0.0;
+    if(row == NULL)
+        return 0.0;
+
+    for(size_t y = 0; y < v->state.height; y++) {
+        field_load_row(&v->state, y, row);
+        for(size_t x = 0; x < v->state.width; x++)
+            sum += row[x];
+    }
+
+    free(row);
+    return sum;
+}
+
+void lenia3d_slice(const lenia3d* v, size_t z, uint8_t* out) {
+    const size_t w = v->state.width, h = v->state.height / v->depth;
+    float* row = malloc(w * sizeof(float));
+    if(row == NULL)
+        return;
+
+    for(size_t y = 0; y < h; y++) {
+        field_load_row(&v->state, z * h + y, row);
+        for(size_t x = 0; x < w; x++)
+            out[y * w + x] = (uint8_t) (clampf(row[x], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    free(row);
+}
+
+int lenia3d_write_raw(const lenia3d* v, const char* path) {
+    const size_t w = v->state.width, h = v->state.height / v->depth;
+    uint8_t* slice = malloc(w * h);
+    FILE* fp = fopen(path, "wb");
+    int res = VOLUME_OK;
+
+    if(slice == NULL || fp == NULL) {
+        res = slice == NULL ? VOLUME_MALLOC_ERROR : VOLUME_IO_ERROR;
+    } else {
+        for(size_t z = 0; z < v->depth && res == VOLUME_OK; z++) {
+            lenia3d_slice(v, z, slice);
+            if(fwrite(slice, 1, w * h, fp) != w * h)
+                res = VOLUME_IO_ERROR;
+        }
+    }
+
+    if(fp && fclose(fp) != 0)
+        res = VOLUME_IO_ERROR;
+    free(slice);
+    return res;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static uint64_t __next_rand(uint64_t* state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static size_t __wrap(ptrdiff_t v, size_t n) {
+    ptrdiff_t m = v % (ptrdiff_t) n;
+    return (size_t) (m < 0 ? m + (ptrdiff_t) n : m);
+}
+
+// "4,5,6" up to the next '/' or end, returns the set as a bit mask
+static uint32_t __parse_list(const char** p) {
+    uint32_t mask = 0;
+    while(isdigit((unsigned char) **p)) {
+        unsigned int n = 0;
+        while(isdigit((unsigned char) **p))
+            n = n * 10 + (unsigned int) (*(*p)++ - '0');
+        if(n < 32)
+            mask |= 1u << n;
+        if(**p == ',')
+            (*p)++;
+    }
+    return mask;
+}
+
+// Bits where the 5 bit sliced counter c equals n
+static uint64_t __count_equals(const uint64_t c[5], unsigned int n) {
+    uint64_t m = ~(uint64_t) 0;
+    for(unsigned int b = 0; b < 5; b++)
+        m &= (n >> b) & 1 ? c[b] : ~c[b];
+    return m;
+}
@@ -0,0 +1,102 @@
+#ifndef VOLUME_H
+#define VOLUME_H
+
+// 3D engines on a 3-torus, x fastest then y then z.
+//
+// life3d: outer totalistic Life on the 26 cell Moore neighborhood. Voxels are
+// bit packed along x (64 per word) and the step counts all 27 cells of a word
+// at once with a bit sliced adder, so 512^3 is 16 MB per buffer.
+//
+// lenia3d: Lenia through a 3D FFT, state kept in a field_t (width x height*depth)
+// so the reduced precision storage modes apply here too.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <complex.h>
+
+#include "field.h"
+#include "fft.h"
+#include "lenia_sim.h"
+
+typedef struct {
+    size_t width;       // multiple of 64
+    size_t height;
+    size_t depth;
+    size_t words;       // words per x row
+    uint64_t* cells;
+    uint64_t* next;
+    uint32_t survive;   // bit n set: a live voxel with n neighbors lives on
+    uint32_t birth;     // bit n set: a dead voxel with n neighbors is born
+    uint64_t generation;
+    uint64_t rng;
+} life3d;
+
+typedef struct {
+    field_t state;
+    field_t next;
+    size_t depth;
+    lenia_params params;
+    fft3d fft;
+    float complex* buf;
+    const float* spectrum;
+    uint64_t generation;
+    uint64_t rng;
+} lenia3d;
+
+#define VOLUME_OK 0
+#define VOLUME_INVALID -1
+#define VOLUME_MALLOC_ERROR -2
+#define VOLUME_IO_ERROR -3
+
+/*  Allocate an empty volume with the 4555 rule
+
+    Returns:
+        VOLUME_OK on success
+        VOLUME_INVALID if width is not a multiple of 64
+        VOLUME_MALLOC_ERROR if the buffers could not be allocated
+*/
+int life3d_init(life3d* v, size_t width, size_t height, size_t depth);
+void life3d_destroy(life3d* v);
+
+/*  Set the rule, either Bays' "ElEuFlFu" (e.g. "4555": survive on 4..5,
+    born on 5..5) or "B5/S4,5" with comma separated neighbor counts
+
+    Returns:
+        VOLUME_OK on success
+        VOLUME_INVALID if the rule could not be parsed
+*/
+int life3d_set_rule(life3d* v, const char* rule);
+
+/* Fill the central half of the volume at random with the given density */
+void life3d_seed(life3d* v, uint64_t seed, float coverage);
+
+void life3d_step(life3d* v);
+
+uint64_t life3d_population(const life3d* v);
+
+/* One z slice as bytes (0 / 255), out holds width * height */
+void life3d_slice(const life3d* v, size_t z, uint8_t* out);
+
+int lenia3d_init(lenia3d* v, size_t width, size_t height, size_t depth, field_storage storage, lenia_params params);
+void lenia3d_destroy(lenia3d* v);
+
+/* Scatter random cubes (side 2R) over coverage of the volume */
+void lenia3d_seed(lenia3d* v, uint64_t seed, float coverage);
+
+void lenia3d_step(lenia3d* v);
+
+double lenia3d_mass(const lenia3d* v);
+
+/* One z slice quantized to bytes, out holds width * height */
+void lenia3d_slice(const lenia3d* v, size_t z, uint8_t* out);
+
+/*  Write the whole volume as raw bytes (x fastest), one slice at a time
+
+    Returns:
+        VOLUME_OK on success
+        VOLUME_MALLOC_ERROR / VOLUME_IO_ERROR on failure
+*/
+int life3d_write_raw(const life3d* v, const char* path);
+int lenia3d_write_raw(const lenia3d* v, const char* path);
+
+#endif
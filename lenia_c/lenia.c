@@ -5,6 +5,7 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 
 //#define OMP
 
@@ -28,9 +29,15 @@
 
 #include "raylib.h"
 #include "queue_d.h"
-#include "set.h"
-
-#define WAIT
+#include "frontier.h"
+#include "render.h"
+#include "ring.h"
+#include "snapshot.h"
+#include "density.h"
+#include "heat.h"
+#include "rle.h"
+#include "macrocell.h"
+#include "checkpoint.h"
 
 
 //#define CELL_WIDTH_PX 30
@@ -45,6 +52,26 @@
 #define GLIDER_I_0 12
 #define GLIDER_J_0 4
 
+#define SIM_COMMANDS 256            /* queued keys and clicks before new ones are dropped */
+#define SIM_IDLE_US 1000            /* poll interval of the paused simulation thread */
+
+#define FRAME_RATE 60               /* render frames per second, also the simulation's time slice */
+#define SNAPSHOT_TILE_SHIFT 5       /* 32x32 cell tiles, what snapshots copy and the view redraws */
+
+#define VIEW_MAX_PX 1024            /* largest window side, bigger boards start zoomed out */
+#define VIEW_MAX_ZOOM 5             /* 32 pixels per cell */
+#define VIEW_PAN_STEPS 32           /* arrow keys move the window by 1 / VIEW_PAN_STEPS per frame */
+#define VIEW_OUTSIDE PIXELS_RGBA(130, 130, 130, 255)    /* past the board edge, raylib's GRAY */
+#define HEAT_YOUNG PIXELS_RGBA(255, 220, 70, 255)       /* H colors by age: born yellow, white when old */
+#define HEAT_OLD PIXELS_WHITE
+#define HEAT_DIED PIXELS_RGBA(200, 40, 20, 255)         /* and trails that fade from red to black */
+#define HEAT_FADED PIXELS_BLACK
+#define SIM_DEFAULT_RATE 30         /* generations per second to start at */
+#define SIM_MAX_RATE (1u << 20)     /* doubling past this means as many as the frame budget fits */
+#define PATTERN_SAVE_PATH "board.rle"   /* where S writes the board */
+#define MACROCELL_SAVE_PATH "board.mc"  /* and M as a Macrocell quadtree */
+#define CHECKPOINT_PATH "board.ckpt"    /* F5 and quitting write it, F9 goes back to it */
+
 typedef enum {
     paused = 0,
     running = 1
@@ -55,12 +82,36 @@ enum {
     alive = true
 };
 
+// what the render loop asks of the simulation thread, a click carries its
+// cell above COMMAND_BITS: i in the next COMMAND_CELL_BITS, j above that
+typedef enum {
+    command_quit = 0,
+    command_toggle_run = 1,
+    command_randomize = 2,
+    command_clear = 3,
+    command_glider = 4,
+    command_click = 5,
+    command_rate = 6,           // generations per second above COMMAND_BITS, 0 for unlimited
+    command_pattern = 7,        // the board cleared to the pattern file, centered
+    command_save = 8,           // the board written out as PATTERN_SAVE_PATH
+    command_save_macrocell = 9, // and as MACROCELL_SAVE_PATH
+    command_checkpoint = 10,    // the whole run written to checkpoint_path
+    command_restore = 11        // and read back from it
+} Command;
+
+#define COMMAND_BITS 8
+#define COMMAND_CELL_BITS 28
+#define COMMAND_CELL_MASK ((1ull << COMMAND_CELL_BITS) - 1)
+
 GameMode mode = paused;
 
 // TODO: dynamically allocate cells depending on size specified at runtime
 size_t board_width = 50; // default
 size_t board_height = 50; // default
 unsigned int cell_width_px = 1; // default
+const char* pattern_path = NULL; // RLE or .mc file given after the cell size, L reloads it
+const char* checkpoint_path = CHECKPOINT_PATH; // or a .ckpt given there, the run starts from it
+uint64_t board_rng = 0x9E3779B97F4A7C15ULL; // xorshift64* state, so a checkpoint can carry it
 
 typedef struct {
     bool alive;
@@ -74,12 +125,17 @@ typedef struct {
     cell** cells;
     size_t board_width;
     size_t board_height;
+    Frontier frontier;  // cells next to a live one, what the next generation has to visit
+    uint64_t* active;   // the frontier updateBoard is stepping, frontier is rebuilt meanwhile
+    uint64_t* bits;     // alive packed as bit i * board_height + j, what snapshots copy
+    snapshot_buffer* snapshots; // told about every cell that changes, NULL when not drawn
     // TODO: dynamically allocate cells depending on size specified at runtime
 
     //unsigned int cn_cells[BOARD_WIDTH][BOARD_HEIGHT];
 } cell_board;
 
-void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, size_t j_0);
+void setEnqueuedNCells(cell_board* board, Queue* q, Frontier* s, size_t i_0, size_t j_0);
+void free_board(cell_board* board);
 
 void setCellBQ(cell_board* board, Queue* q, unsigned int i, unsigned int j, bool status) {
     board->cells[i][j].alive = status;
@@ -105,8 +161,28 @@ cell_board* init_board(size_t width, size_t height) {
         return NULL;
     }
 
+    int threads = 1;
+    #ifdef OMP
+    threads = omp_get_max_threads();
+    #endif
+
+    if(frontier_init(&board->frontier, (uint64_t) width * height) != SET_TRUE) {
+        free(board);
+        return NULL;
+    }
+
+    board->active = malloc(width * height * sizeof(uint64_t));
+    if(board->active == NULL || frontier_init_local(&board->frontier, threads) != SET_TRUE) {
+        free(board->active);
+        frontier_destroy(&board->frontier);
+        free(board);
+        return NULL;
+    }
+
     board->cells = malloc(width * sizeof(cell*));
     if(board->cells == NULL) {
+        free(board->active);
+        frontier_destroy(&board->frontier);
         free(board);
         return NULL;
     }
@@ -116,9 +192,11 @@ cell_board* init_board(size_t width, size_t height) {
 
     board->board_width = width;
     board->board_height = height;
+    board->bits = calloc((width * height + 63) / 64 + 1, sizeof(uint64_t));
+    board->snapshots = NULL;
 
-    if(board->cells == NULL) {
-        free(board);
+    if(board->cells == NULL || board->bits == NULL) {
+        free_board(board);
         return NULL;
     }
 
@@ -141,11 +219,22 @@ void free_board(cell_board* board) {
         free(board->cells);
     }
     if(board) {
+        free(board->bits);
+        free(board->active);
+        frontier_destroy(&board->frontier);
         free(board);
     }
 }
 
 
+// i_0 + d on a torus of size n for d in -1..1, without the division % costs
+static inline size_t wrapIndex(size_t i_0, int d, size_t n) {
+    size_t k = i_0 + d;
+    if(k >= n)
+        k = d < 0 ? n - 1 : 0;
+    return k;
+}
+
 size_t calculateNeighbors(cell_board* board, size_t i_0, size_t j_0) {
     size_t sum = 0;
     for(int i = -1; i <= 1; i++) {
@@ -153,18 +242,12 @@ size_t calculateNeighbors(cell_board* board, size_t i_0, size_t j_0) {
             if(i == 0 && j == 0) {
                 continue;
             }
-            
-            #ifdef OMP
-            #pragma omp critical
-            #endif
-            {
-            size_t neighbor_i = (i_0 + i + board_width) % board_width;
-            size_t neighbor_j = (j_0 + j + board_height) % board_height;
+
+            size_t neighbor_i = wrapIndex(i_0, i, board_width);
+            size_t neighbor_j = wrapIndex(j_0, j, board_height);
             
             //printf("Neighbor at (%u, %u): %u", (unsigned int) used_i, (unsigned int) used_j, (unsigned int) board->cells[used_i][used_j]);
             sum += (unsigned int) board->cells[neighbor_i][neighbor_j].alive;
-            }
-
         }
     }
 
@@ -195,59 +278,24 @@ void updateEnqueuedNeighbors(cell_board* board, Queue* q) {
 
 }
 
-void updateEnqueuedNeighborsFor(cell_board* board, Queue* q) {
-    //printf("Getting enqueued neighbors");
-    cell** active_cells = calloc(q->size, sizeof(cell*));
-
-    size_t ctr = 0;
-    while(!isEmpty(q)) {
-        cell* c = (cell*) peek(q);
-        if(c)
-            active_cells[ctr++] = c;
-
-        dequeue(q);
-    }
-
-    assert(ctr != 0 && isEmpty(q));
-    
-    #ifdef OMP
-    #pragma omp parallel for
-    #endif
-    for(size_t i = 0; i < ctr; i++) {
-        cell* c = active_cells[i];
-        if(c) {
-            c->neighbors = calculateNeighbors(board, c->i, c->j);
-        }
-    }
-
-    free(active_cells);
-
-}
-
-void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, size_t j_0) {
+void setEnqueuedNCells(cell_board* board, Queue* q, Frontier* s, size_t i_0, size_t j_0) {
 
     for(int i = -1; i <= 1; i++) {
         for(int j = -1; j <= 1; j++) {
             //fprintf(stderr, "Getting neighboring cell dims\n");
 
-            size_t neighbor_i = (i_0 + i + board_width) % board_width;
-            size_t neighbor_j = (j_0 + j + board_height) % board_height;
+            size_t neighbor_i = wrapIndex(i_0, i, board_width);
+            size_t neighbor_j = wrapIndex(j_0, j, board_height);
 
             //fprintf(stderr, "Setting neighboring cells\n");
             //printf("Neighbor at (%u, %u): %u", (unsigned int) used_i, (unsigned int) used_j, (unsigned int) board->cells[used_i][used_j]);
-            uint64_t key_addr = (uint64_t) ( (neighbor_i << ((unsigned int) log2(board_width) + 1)) ) + neighbor_j;
-            char key[8];
+            uint64_t key = (uint64_t) neighbor_i * board_height + neighbor_j;
 
-            for (int i = 0; i < 8; i++)
-                key[i] = (key_addr >> (i * 8)) & 0xFF;
-            
-            //printf(key);
-            
             if(!s) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
-            else if(set_add(s, (const char*) key) == SET_TRUE) {
+            else if(frontier_add(s, key) == SET_TRUE) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
@@ -258,58 +306,295 @@ void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, si
     
 }
 
+// Like setEnqueuedNCells but from inside the parallel step: the cell goes to
+// this thread's own frontier buffer, merged once the generation is done
+void setFrontierNCells(cell_board* board, int thread, size_t i_0, size_t j_0) {
+    for(int i = -1; i <= 1; i++) {
+        for(int j = -1; j <= 1; j++) {
+            size_t neighbor_i = wrapIndex(i_0, i, board_width);
+            size_t neighbor_j = wrapIndex(j_0, j, board_height);
+            uint64_t key = (uint64_t) neighbor_i * board_height + neighbor_j;
+
+            // only the thread that claims the cell writes to it
+            if(frontier_add_local(&board->frontier, thread, key) == SET_TRUE)
+                board->cells[neighbor_i][neighbor_j].enqueued = true;
+        }
+    }
+}
+
+// two cells of a word can flip from different threads
+static inline void flipBit(cell_board* board, size_t i, size_t j) {
+    uint64_t k = i * board_height + j;
+    __atomic_fetch_xor(&board->bits[k / 64], (uint64_t) 1 << (k % 64), __ATOMIC_RELAXED);
+    if(board->snapshots)
+        snapshot_mark(board->snapshots, i, j);
+}
+
+/* Rebuild the packed copy after the UI rewrote the board */
+void packBoard(cell_board* board) {
+    memset(board->bits, 0, (board_width * board_height + 63) / 64 * sizeof(uint64_t));
+    if(board->snapshots)
+        snapshot_mark_all(board->snapshots);
+    for(size_t i = 0; i < board_width; i++)
+        for(size_t j = 0; j < board_height; j++)
+            if(board->cells[i][j].alive)
+                board->bits[(i * board_height + j) / 64] |= (uint64_t) 1 << (i * board_height + j) % 64;
+}
+
 void updateBoard(cell_board* board, Queue* q) {
-    updateEnqueuedNeighbors(board, q);
-    //updateEnqueuedNeighborsFor(board, q);
-    //updateAllNeighbors(board);
-    resetQueue(q);
+    Frontier* s = &board->frontier;
 
-    //printf("Calculating neighbors");
+    // cells toggled or seeded from the UI since the last generation
+    while(!isEmpty(q)) {
+        cell* c = (cell*) peek(q);
+        if(c)
+            frontier_add(s, (uint64_t) c->i * board_height + c->j);
+        dequeue(q);
+    }
 
-    SimpleSet s;
-    set_init(&s);
+    // only the frontier can change; step over a copy of it while the
+    // next one is built from this generation's live cells
+    const size_t n_active = frontier_length(s);
+    memcpy(board->active, s->list, n_active * sizeof(uint64_t));
+    frontier_clear(s);
 
-    //printf("Calculating neighbors");
-    
+    #ifdef OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for(size_t k = 0; k < n_active; k++) {
+        cell* c = &board->cells[board->active[k] / board_height][board->active[k] % board_height];
+        c->neighbors = calculateNeighbors(board, c->i, c->j);
+    }
 
-    for(size_t i = 0; i < board_width; i++) {
+    #ifdef OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for(size_t k = 0; k < n_active; k++) {
+        int thread = 0;
         #ifdef OMP
-        #pragma omp parallel for
+        thread = omp_get_thread_num();
         #endif
-        for(size_t j = 0; j < board_height; j++) {
-            bool cell = board->cells[i][j].alive;
-            unsigned int neighbors = board->cells[i][j].neighbors;
-            
-            if(cell && (neighbors == NEIGHBOR_THRESHOLD || neighbors == NEIGHBOR_THRESHOLD - 1)) {
-                setCellB(board, i, j, alive);
-                
-                setEnqueuedNCells(board, q, &s, i, j);
-            } else if(!cell && neighbors == NEIGHBOR_THRESHOLD) {
-                setCellB(board, i, j, alive);
 
-                setEnqueuedNCells(board, q, &s, i, j);
+        size_t i = board->active[k] / board_height;
+        size_t j = board->active[k] % board_height;
+        bool cell = board->cells[i][j].alive;
+        unsigned int neighbors = board->cells[i][j].neighbors;
+
+        bool next = neighbors == NEIGHBOR_THRESHOLD || (cell && neighbors == NEIGHBOR_THRESHOLD - 1);
+        if(next != cell)
+            flipBit(board, i, j);
+
+        if(next) {
+            setCellB(board, i, j, alive);
+            setFrontierNCells(board, thread, i, j);
+        } else {
+            setCellB(board, i, j, dead);
+        }
+    }
+
+    frontier_merge(s);
+}
+
+// The window shows the board through a camera: a power of two zoom and the
+// cell under the middle of the window. Zoomed in a pixel is part of one cell,
+// zoomed out it is one block of density level -zoom, so a frame never reads
+// more than a window's worth of cells or blocks. The window is one texture
+// (texel row x is screen column x) redrawn where the camera or the tiles a
+// snapshot changed say so. With heat on, zoomed in cells are colored by age
+// and trails instead, which also redraws the tiles whose colors still move.
+typedef struct {
+    int64_t center_i;       // board cell under the middle of the window
+    int64_t center_j;
+    int zoom;               // log2 of pixels per cell, below 0 2^-zoom cells per pixel
+    size_t width;           // window pixels
+    size_t height;
+    board_texture texture;
+    density_pyramid density;
+    heat_plane heat;        // allocated the first time heat is turned on
+    bool heat_on;
+    bool heat_synced;       // heat is following the snapshots, false until the next frame resets it
+    uint32_t* heat_row;     // one row of a rect's cell colors
+} viewport;
+
+// x / 2^shift rounded towards minus infinity
+static inline int64_t floorShift(int64_t x, int shift) {
+    return x >= 0 ? x >> shift : -((-x + ((int64_t) 1 << shift) - 1) >> shift);
+}
+
+/* First cell along an axis of pixels pixels, the start of a density block when zoomed out */
+int64_t viewOrigin(const viewport* v, int64_t center, size_t pixels) {
+    if(v->zoom >= 0)
+        return center - (int64_t) (pixels / 2 >> v->zoom);
+    return floorShift(center - ((int64_t) (pixels / 2) << -v->zoom), -v->zoom) << -v->zoom;
+}
+
+static inline int64_t viewCell(const viewport* v, int64_t origin, size_t pixel) {
+    return v->zoom >= 0 ? origin + (int64_t) (pixel >> v->zoom) : origin + ((int64_t) pixel << -v->zoom);
+}
+
+static inline int64_t viewPixel(const viewport* v, int64_t origin, int64_t cell) {
+    return v->zoom >= 0 ? (cell - origin) << v->zoom : floorShift(cell - origin, -v->zoom);
+}
+
+/* Redraw texels of rect r: screen columns r.y .. r.y + r.height - 1, rows r.x .. r.x + r.width - 1 */
+void fillView(viewport* v, const board_snapshot* shown, dirty_rect r) {
+    pixel_buffer* p = &v->texture.pixels;
+    const uint64_t* bits = shown->bits;
+    const int64_t i0 = viewOrigin(v, v->center_i, v->width);
+    const int64_t j0 = viewOrigin(v, v->center_j, v->height);
+    const int level = -v->zoom;
+
+    for(size_t x = r.y; x < r.y + r.height; x++) {
+        uint32_t* out = pixels_row(p, x);
+        int64_t i = viewCell(v, i0, x);
+
+        // the row's cells colored in one span, then stretched over the pixels
+        if(v->heat_on && v->zoom >= 0 && i >= 0 && i < (int64_t) board_width) {
+            int64_t ja = viewCell(v, j0, r.x), jb = viewCell(v, j0, r.x + r.width - 1) + 1;
+            ja = ja < 0 ? 0 : ja;
+            jb = jb > (int64_t) board_height ? (int64_t) board_height : jb;
+            if(ja < jb)
+                heat_span(&v->heat, v->heat_row, i, ja, jb - ja, (uint32_t) shown->generation);
+            for(size_t y = r.x; y < r.x + r.width; y++) {
+                int64_t j = viewCell(v, j0, y);
+                out[y] = j < 0 || j >= (int64_t) board_height ? VIEW_OUTSIDE : v->heat_row[j - ja];
+            }
+            continue;
+        }
+
+        for(size_t y = r.x; y < r.x + r.width; y++) {
+            int64_t j = viewCell(v, j0, y);
+            if(i < 0 || j < 0 || i >= (int64_t) board_width || j >= (int64_t) board_height) {
+                out[y] = VIEW_OUTSIDE;
+            } else if(v->zoom >= 0) {
+                uint64_t k = (uint64_t) i * board_height + j;
+                out[y] = (bits[k / 64] >> (k % 64)) & 1 ? p->alive : p->dead;
             } else {
-                setCellB(board, i, j, dead);
+                uint8_t d = density_at(&v->density, level, i >> level, j >> level);
+                out[y] = PIXELS_RGBA(d, d, d, 255);
             }
         }
     }
+}
 
-    set_destroy(&s);
+/* Cells [i0, i1) x [j0, j1) changed, mark the window tiles showing them */
+void markViewCells(viewport* v, int64_t i0, int64_t i1, int64_t j0, int64_t j1) {
+    const int64_t oi = viewOrigin(v, v->center_i, v->width);
+    const int64_t oj = viewOrigin(v, v->center_j, v->height);
+    const int64_t last = v->zoom > 0 ? ((int64_t) 1 << v->zoom) - 1 : 0;
+    int64_t x0 = viewPixel(v, oi, i0), x1 = viewPixel(v, oi, i1 - 1) + last;
+    int64_t y0 = viewPixel(v, oj, j0), y1 = viewPixel(v, oj, j1 - 1) + last;
+
+    if(x1 < 0 || y1 < 0 || x0 >= (int64_t) v->width || y0 >= (int64_t) v->height)
+        return;
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 >= (int64_t) v->width ? (int64_t) v->width - 1 : x1;
+    y1 = y1 >= (int64_t) v->height ? (int64_t) v->height - 1 : y1;
+
+    for(int64_t tx = x0 >> RENDER_TILE_SHIFT; tx <= x1 >> RENDER_TILE_SHIFT; tx++)
+        for(int64_t ty = y0 >> RENDER_TILE_SHIFT; ty <= y1 >> RENDER_TILE_SHIFT; ty++)
+            dirty_mark(&v->texture.dirty, tx << RENDER_TILE_SHIFT, ty << RENDER_TILE_SHIFT);
 }
 
-void drawBoard(cell_board* board) {
-    BeginDrawing();
-    ClearBackground(GRAY);
-    for(size_t i = 0; i < board_width; i++) {
-        for(size_t j = 0; j < board_height; j++) {
-            bool cell = board->cells[i][j].alive;
-            Color color = BLACK;
-            if(cell)
-                color = WHITE;
+/* Bring the density pyramid and the window up to a new snapshot, tile by changed tile */
+void applySnapshot(viewport* v, const snapshot_buffer* snapshots, const board_snapshot* latest) {
+    const uint64_t tile = (uint64_t) 1 << snapshots->shift;
+    for(uint64_t ty = 0; ty < snapshots->tiles_y; ty++) {
+        for(uint64_t w = 0; w < snapshots->row_words; w++) {
+            for(uint64_t bits = latest->changed[ty * snapshots->row_words + w]; bits; bits &= bits - 1) {
+                uint64_t tx = w * 64 + __builtin_ctzll(bits);
+                uint64_t i0 = ty * tile, i1 = i0 + tile < board_width ? i0 + tile : board_width;
+                uint64_t j0 = tx * tile, j1 = j0 + tile < board_height ? j0 + tile : board_height;
+                density_update_block(&v->density, latest->bits, i0, i1, j0, j1);
+                if(v->heat_on)
+                    heat_update_block(&v->heat, latest->bits, i0, i1, j0, j1, (uint32_t) latest->generation);
+                markViewCells(v, i0, i1, j0, j1);
+            }
+        }
+    }
 
-            DrawRectangle(i * cell_width_px / 2, j * cell_width_px / 2, cell_width_px, cell_width_px, color);
+    // a new generation moves the colors of every tile that changed lately,
+    // the ones this redraw shows at the end of their ramps are done
+    if(v->heat_on) {
+        const uint64_t heat_tile = (uint64_t) 1 << v->heat.shift;
+        for(size_t k = 0; k < v->heat.warm_count; k++) {
+            uint64_t i0 = v->heat.warm[k] / v->heat.tiles_x * heat_tile;
+            uint64_t j0 = v->heat.warm[k] % v->heat.tiles_x * heat_tile;
+            markViewCells(v, i0, i0 + heat_tile < board_width ? i0 + heat_tile : board_width,
+                j0, j0 + heat_tile < board_height ? j0 + heat_tile : board_height);
         }
+        heat_cool(&v->heat, (uint32_t) latest->generation);
+    }
+}
+
+/* Turn age coloring on or off, the plane is only allocated once it is first wanted */
+bool toggleHeat(viewport* v) {
+    if(!v->heat_on && v->heat.stamps == NULL) {
+        heat_palette palette = { HEAT_YOUNG, HEAT_OLD, HEAT_DIED, HEAT_FADED };
+        if(heat_init(&v->heat, board_width, board_height, SNAPSHOT_TILE_SHIFT, palette) != HEAT_OK)
+            return false;
+        v->heat_row = malloc((v->height + 1) * sizeof(uint32_t));
+        if(v->heat_row == NULL) {
+            heat_destroy(&v->heat);
+            return false;
+        }
+    }
+    v->heat_on = !v->heat_on;
+    v->heat_synced = false;
+    dirty_mark_all(&v->texture.dirty);
+    return true;
+}
+
+/* Zoom by steps (in is positive) and pan by whole cells, then redraw the window */
+void moveView(viewport* v, int zoom_steps, int64_t di, int64_t dj) {
+    int zoom = v->zoom + zoom_steps;
+    zoom = zoom > VIEW_MAX_ZOOM ? VIEW_MAX_ZOOM : zoom;
+    zoom = zoom < -(int) v->density.count ? -(int) v->density.count : zoom;
+
+    int64_t ci = v->center_i + di, cj = v->center_j + dj;
+    ci = ci < 0 ? 0 : ci >= (int64_t) board_width ? (int64_t) board_width - 1 : ci;
+    cj = cj < 0 ? 0 : cj >= (int64_t) board_height ? (int64_t) board_height - 1 : cj;
+
+    if(zoom != v->zoom || ci != v->center_i || cj != v->center_j) {
+        v->zoom = zoom;
+        v->center_i = ci;
+        v->center_j = cj;
+        dirty_mark_all(&v->texture.dirty);
+    }
+}
+
+/* Cells the arrow keys move per frame at the current zoom */
+int64_t panStep(const viewport* v, size_t pixels) {
+    int64_t step = (int64_t) (pixels / VIEW_PAN_STEPS);
+    step = v->zoom >= 0 ? step >> v->zoom : step << -v->zoom;
+    return step > 0 ? step : 1;
+}
+
+/* Draw the newest generation the simulation thread finished, never waits for it */
+void drawBoard(viewport* v, snapshot_buffer* snapshots, uint64_t rate) {
+    bool fresh;
+    const board_snapshot* latest = snapshot_acquire(snapshots, &fresh);
+    // heat starts from whatever is on the board when it is turned on
+    if(v->heat_on && !v->heat_synced) {
+        heat_reset(&v->heat, latest->bits, (uint32_t) latest->generation);
+        v->heat_synced = true;
     }
+    if(fresh)
+        applySnapshot(v, snapshots, latest);
+
+    size_t n = render_collect(&v->texture);
+    for(size_t k = 0; k < n; k++)
+        fillView(v, latest, v->texture.rects[k]);
+    render_upload_rects(&v->texture, n);
+
+    BeginDrawing();
+    ClearBackground(GRAY);
+    render_draw(&v->texture, 0, 0, 1.0f);
+    DrawText(TextFormat("gen %lu, %s gen/s, zoom %s%d, upload %.1f KiB%s", (unsigned long) latest->generation,
+        rate ? TextFormat("%lu", (unsigned long) rate) : "max", v->zoom >= 0 ? "x" : "1/",
+        1 << (v->zoom >= 0 ? v->zoom : -v->zoom), v->texture.bytes_uploaded / 1024.0,
+        v->heat_on ? TextFormat(", heat %lu warm tiles", (unsigned long) v->heat.warm_count) : ""), 10, 10, 10, RED);
     EndDrawing();
 }
 
@@ -339,30 +624,39 @@ void printNeighbors(cell_board* board) {
     }
 }
 
+uint64_t nextRand(uint64_t* state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
 void randomizeBoard(cell_board* board, Queue* q) {
     const float coverage = COVERAGE;
     fprintf(stderr, "Randomizing board\n");
     resetQueue(q);
 
-    SimpleSet s;
-    set_init(&s);
+    Frontier* s = &board->frontier;
+    frontier_clear(s);
 
     fprintf(stderr, "Gotten board set\n");
 
     for(size_t i = 0; i < board_width; i++) {
         for(size_t j = 0; j < board_height; j++) {
-            if((float) rand()/RAND_MAX > (1 - coverage)) {
+            if((float) (nextRand(&board_rng) >> 40) / (float) (1 << 24) > (1 - coverage)) {
                 //fprintf(stderr, "Setting single cell\n");
                 setCellB(board, i, j, alive);
                 //fprintf(stderr, "Setting neighboring cells to queue\n");
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             }
             else
                 setCellB(board, i, j, dead);
         }
     }
     //printQueue(q);
-    set_destroy(&s);
 }
 
 
@@ -375,32 +669,26 @@ void clearBoard(cell_board* board) {
             //board->cells[i][j].j = j;
         }
     }
+    memset(board->bits, 0, (board_width * board_height + 63) / 64 * sizeof(uint64_t));
+    if(board->snapshots)
+        snapshot_mark_all(board->snapshots);
 }
 
-void drawTile(cell_board* board, Queue* q, unsigned int mouse_x, unsigned int mouse_y) {
-    size_t cell_i = round((float) board_width * (float) mouse_x / (board_width * cell_width_px) * 2);
-    size_t cell_j = round((float) board_height * (float) mouse_y / (board_height * cell_width_px) * 2);
-
-    if(cell_i > board_width || cell_j > board_height) {
+void drawTile(cell_board* board, Queue* q, size_t cell_i, size_t cell_j) {
+    if(cell_i >= board_width || cell_j >= board_height) {
         return;
     }
     
     //printf("Drawing clicked tile at %zu, %zu ", cell_x, cell_y); 
-    //printf("Mouse coords were %u, %u ", mouse_x, mouse_y);
     bool* status = &board->cells[cell_i][cell_j].alive;
 
     *status = !*status;
+    flipBit(board, cell_i, cell_j);
 
     if(board->cells[cell_i][cell_j].alive)
         setEnqueuedNCells(board, q, NULL, cell_i, cell_j);
 }
 
-void drawClickedTile(cell_board* board, Queue* q) {
-    //printf("Drawing clicked tile"); 
-    
-    drawTile(board, q, GetMouseX(), GetMouseY());
-}
-
 
 void setBoardGlider(cell_board* board, Queue* q, size_t i_0, size_t j_0) {
     bool glider[3][3] = { {dead, alive, dead}, {dead, dead, alive}, {alive, alive, alive} };
@@ -413,6 +701,537 @@ void setBoardGlider(cell_board* board, Queue* q, size_t i_0, size_t j_0) {
 
 }
 
+// Where a pattern's cells land: x along i, y along j, pattern cell
+// (x_0, y_0) on board cell (i_0, j_0). RLE patterns start at (0, 0).
+typedef struct {
+    cell_board* board;
+    size_t i_0;
+    size_t j_0;
+    uint64_t x_0;
+    uint64_t y_0;
+} pattern_target;
+
+/*  One run of live cells. The cells and bits are written in one pass down
+    the run, and the frontier gets the run's 3 x (count + 2) neighbourhood
+    as three strided runs rather than nine adds per cell. Cells past the
+    board's edge are dropped, so a pattern never wraps onto itself.
+*/
+bool placeRun(void* ctx, uint64_t x, uint64_t y, uint64_t count) {
+    pattern_target* target = (pattern_target*) ctx;
+    cell_board* board = target->board;
+    if(x >= board_width || y >= board_height)
+        return true;
+    if(count > board_width - x)
+        count = board_width - x;
+
+    size_t i = (target->i_0 + x) % board_width;
+    size_t j = (target->j_0 + y) % board_height;
+    size_t i_first = i;
+    uint64_t k = (uint64_t) i * board_height + j;
+    for(uint64_t n = 0; n < count; n++) {
+        board->cells[i][j].alive = alive;
+        board->bits[k / 64] |= (uint64_t) 1 << (k % 64);
+        if(++i == board_width) {
+            i = 0;
+            k = j;
+        } else {
+            k += board_height;
+        }
+    }
+
+    uint64_t span = count + 2 < board_width ? count + 2 : board_width;
+    for(int dj = -1; dj <= 1; dj++)
+        frontier_add_run(&board->frontier, (uint64_t) wrapIndex(i_first, -1, board_width) * board_height
+            + wrapIndex(j, dj, board_height), span, board_height);
+    return true;
+}
+
+/*  Clear the board to the RLE file at path, its top left corner at
+    (i_0, j_0), or centered when center is set. The rule in the file is
+    only reported, the board runs B3/S23 whatever it says.
+*/
+bool loadPattern(cell_board* board, Queue* q, const char* path, size_t i_0, size_t j_0, bool center) {
+    rle_reader reader;
+    int status = rle_open(&reader, path);
+    if(status != RLE_OK) {
+        fprintf(stderr, "could not read pattern %s (%d)\n", path, status);
+        return false;
+    }
+    if(reader.rule[0] && strcasecmp(reader.rule, "B3/S23") != 0 && strcmp(reader.rule, "23/3") != 0)
+        fprintf(stderr, "pattern %s is for rule %s, running it as B3/S23\n", path, reader.rule);
+    if(reader.width > board_width || reader.height > board_height)
+        fprintf(stderr, "pattern %s is %llux%llu, cut to the board\n", path,
+            (unsigned long long) reader.width, (unsigned long long) reader.height);
+
+    if(center) {
+        i_0 = reader.width < board_width ? (board_width - reader.width) / 2 : 0;
+        j_0 = reader.height < board_height ? (board_height - reader.height) / 2 : 0;
+    }
+
+    clearBoard(board);
+    resetQueue(q);
+    frontier_clear(&board->frontier);
+    pattern_target target = { .board = board, .i_0 = i_0, .j_0 = j_0 };
+    status = rle_read_runs(&reader, placeRun, &target);
+    if(status != RLE_OK)
+        fprintf(stderr, "pattern %s is broken past %llu cells (%d)\n", path, (unsigned long long) reader.cells, status);
+    else
+        fprintf(stderr, "loaded %s: %llu cells\n", path, (unsigned long long) reader.cells);
+    rle_close(&reader);
+    return status == RLE_OK;
+}
+
+/*  Columns i - 1 .. i + 1, rows j + low - 1 .. j + high + 1 into the
+    frontier: the neighbourhood of live cells from j + low to j + high of
+    column i. Three runs of neighbouring bits, cell by cell only where the
+    rows wrap past an edge.
+*/
+void addFrontierColumns(cell_board* board, size_t i, size_t j, int low, int high) {
+    Frontier* s = &board->frontier;
+    if(j + high + 1 < board_height && j + low >= 1) {
+        for(int di = -1; di <= 1; di++)
+            frontier_add_run(s, (uint64_t) wrapIndex(i, di, board_width) * board_height + j + low - 1,
+                high - low + 3, 1);
+    } else {
+        for(int di = -1; di <= 1; di++)
+            for(int dj = low - 1; dj <= high + 1; dj++)
+                frontier_add(s, (uint64_t) wrapIndex(i, di, board_width) * board_height
+                    + (j + board_height + dj) % board_height);
+    }
+}
+
+/*  One 8x8 leaf of a Macrocell tree. A leaf column is 8 cells of one board
+    column, which are neighbouring bits: it goes into the packed bits as one
+    shifted byte and its neighbourhood into the frontier as three runs,
+    cell by cell only where it wraps past the bottom edge.
+*/
+void placeLeaf(void* ctx, uint64_t x, uint64_t y, uint64_t leaf) {
+    pattern_target* target = (pattern_target*) ctx;
+    cell_board* board = target->board;
+
+    for(uint64_t dx = 0; dx < 8; dx++) {
+        uint64_t column = leaf >> (8 * dx) & 0xff;
+        if(column == 0 || x + dx < target->x_0 || x + dx - target->x_0 >= board_width)
+            continue;
+        // row 0 of the column is pattern row py
+        uint64_t py = y;
+        if(y < target->y_0) {
+            column = target->y_0 - y < 8 ? column >> (target->y_0 - y) : 0;
+            py = target->y_0;
+        }
+        py -= target->y_0;
+        if(py >= board_height)
+            continue;
+        if(board_height - py < 8)
+            column &= (1u << (board_height - py)) - 1;
+        if(column == 0)
+            continue;
+
+        size_t i = (target->i_0 + x + dx - target->x_0) % board_width;
+        size_t j = (target->j_0 + py) % board_height;
+        for(uint64_t live = column; live; live &= live - 1) {
+            size_t cell_j = j + (size_t) __builtin_ctzll(live);
+            board->cells[i][cell_j < board_height ? cell_j : cell_j - board_height].alive = alive;
+        }
+
+        if(j + 8 <= board_height) {
+            uint64_t k = (uint64_t) i * board_height + j;
+            board->bits[k / 64] |= column << (k % 64);
+            if(k % 64 > 56)
+                board->bits[k / 64 + 1] |= column >> (64 - k % 64);
+        } else {
+            for(uint64_t live = column; live; live &= live - 1) {
+                size_t cell_j = (j + (size_t) __builtin_ctzll(live)) % board_height;
+                uint64_t k = (uint64_t) i * board_height + cell_j;
+                board->bits[k / 64] |= (uint64_t) 1 << (k % 64);
+            }
+        }
+        addFrontierColumns(board, i, j, __builtin_ctzll(column), 63 - __builtin_clzll(column));
+    }
+}
+
+/*  Clear the board to the Macrocell file at path, like loadPattern. The
+    tree is never flattened: only the leaves under the part of the pattern
+    that fits on the board are visited, and its bounding box comes from the
+    distinct nodes, not from every copy of them.
+*/
+bool loadMacrocell(cell_board* board, Queue* q, const char* path, size_t i_0, size_t j_0, bool center) {
+    mc_tree tree;
+    if(mc_init(&tree) != MC_OK)
+        return false;
+    int status = mc_read(&tree, path);
+    if(status != MC_OK) {
+        fprintf(stderr, "could not read pattern %s (%d)\n", path, status);
+        mc_destroy(&tree);
+        return false;
+    }
+    if(strcasecmp(tree.rule, "B3/S23") != 0)
+        fprintf(stderr, "pattern %s is for rule %s, running it as B3/S23\n", path, tree.rule);
+
+    uint64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    mc_bounds(&tree, &x0, &y0, &x1, &y1);
+    if(x1 - x0 > board_width || y1 - y0 > board_height)
+        fprintf(stderr, "pattern %s is %llux%llu, cut to the board\n", path,
+            (unsigned long long) (x1 - x0), (unsigned long long) (y1 - y0));
+    if(center) {
+        i_0 = x1 - x0 < board_width ? (board_width - (x1 - x0)) / 2 : 0;
+        j_0 = y1 - y0 < board_height ? (board_height - (y1 - y0)) / 2 : 0;
+    }
+
+    clearBoard(board);
+    resetQueue(q);
+    frontier_clear(&board->frontier);
+    pattern_target target = { .board = board, .i_0 = i_0, .j_0 = j_0, .x_0 = x0, .y_0 = y0 };
+    mc_for_each_leaf(&tree, x0, y0, board_width, board_height, placeLeaf, &target);
+    fprintf(stderr, "loaded %s: %lu nodes, %llu cells\n", path, (unsigned long) tree.count - 1,
+        (unsigned long long) tree.nodes[tree.root].population);
+    mc_destroy(&tree);
+    return true;
+}
+
+// The live cells' bounding box, rows of it gathered from the packed bits
+typedef struct {
+    const cell_board* board;
+    size_t i_0;
+    size_t j_0;
+    size_t width;
+} pattern_source;
+
+bool patternRow(void* ctx, uint64_t y, uint64_t* bits) {
+    const pattern_source* source = (const pattern_source*) ctx;
+    const uint64_t* board_bits = source->board->bits;
+    uint64_t k = (uint64_t) source->i_0 * board_height + source->j_0 + y;
+    for(size_t x = 0; x < source->width; x++, k += board_height)
+        bits[x / 64] |= (board_bits[k / 64] >> (k % 64) & 1) << (x % 64);
+    return true;
+}
+
+/* Write the live part of the board to path as RLE */
+bool savePattern(const cell_board* board, const char* path) {
+    const size_t words = (board_width * board_height + 63) / 64;
+    size_t i_min = board_width, i_max = 0, j_min = board_height, j_max = 0;
+    for(size_t w = 0; w < words; w++)
+        for(uint64_t live = board->bits[w]; live; live &= live - 1) {
+            uint64_t k = w * 64 + (uint64_t) __builtin_ctzll(live);
+            size_t i = k / board_height, j = k % board_height;
+            i_min = i < i_min ? i : i_min;
+            i_max = i > i_max ? i : i_max;
+            j_min = j < j_min ? j : j_min;
+            j_max = j > j_max ? j : j_max;
+        }
+
+    pattern_source source = { .board = board, .i_0 = i_min, .j_0 = j_min, .width = 0 };
+    size_t height = 0;
+    if(i_min <= i_max) {
+        source.width = i_max - i_min + 1;
+        height = j_max - j_min + 1;
+    }
+    int status = rle_write(path, source.width, height, "B3/S23", patternRow, &source);
+    if(status != RLE_OK)
+        fprintf(stderr, "could not write %s (%d)\n", path, status);
+    else
+        fprintf(stderr, "saved the board to %s\n", path);
+    return status == RLE_OK;
+}
+
+// Tiles of the board for mc_build, counting the ones that aren't empty
+typedef struct {
+    const cell_board* board;
+    uint64_t tiles;
+} macrocell_source;
+
+/* The 8x8 tile at (x, y): each column is one byte of the packed bits */
+uint64_t boardTile(void* ctx, uint64_t x, uint64_t y) {
+    macrocell_source* source = (macrocell_source*) ctx;
+    const uint64_t* bits = source->board->bits;
+    uint64_t rows = board_height - y < 8 ? (1u << (board_height - y)) - 1 : 0xff;
+    uint64_t tile = 0;
+    for(uint64_t dx = 0; dx < 8 && x + dx < board_width; dx++) {
+        uint64_t k = (x + dx) * board_height + y;
+        uint64_t column = bits[k / 64] >> (k % 64);
+        if(k % 64 > 56)
+            column |= bits[k / 64 + 1] << (64 - k % 64);
+        tile |= (column & rows) << (8 * dx);
+    }
+    source->tiles += tile != 0;
+    return tile;
+}
+
+/* Write the board to path as a Macrocell file, every repeated tile and subtree once */
+bool saveMacrocell(const cell_board* board, const char* path, uint64_t generation) {
+    mc_tree tree;
+    if(mc_init(&tree) != MC_OK)
+        return false;
+    macrocell_source source = { .board = board, .tiles = 0 };
+    int status = MC_MALLOC_ERROR;
+    if(mc_build(&tree, board_width, board_height, boardTile, &source) != UINT32_MAX) {
+        tree.generation = generation;
+        status = mc_write(&tree, path);
+    }
+    if(status != MC_OK)
+        fprintf(stderr, "could not write %s (%d)\n", path, status);
+    else
+        fprintf(stderr, "saved the board to %s: %llu tiles, %lu distinct nodes\n", path,
+            (unsigned long long) source.tiles, (unsigned long) tree.count - 1);
+    mc_destroy(&tree);
+    return status == MC_OK;
+}
+
+bool hasExtension(const char* path, const char* extension) {
+    size_t length = strlen(path), ext_length = strlen(extension);
+    return length > ext_length && strcmp(path + length - ext_length, extension) == 0;
+}
+
+/* The board's packed bits with its generation and RNG state, see checkpoint.h */
+bool checkpointBoard(const cell_board* board, const char* path, uint64_t generation) {
+    checkpoint_header h;
+    checkpoint_describe(&h, "life", "B3/S23");
+    h.width = board_width;
+    h.height = board_height;
+    h.generation = generation;
+    h.rng = board_rng;
+    h.cell_bits = 1;
+    h.state_bytes = (board_width * board_height + 63) / 64 * sizeof(uint64_t);
+
+    int status = checkpoint_write(path, &h, board->bits);
+    if(status != CHECKPOINT_OK)
+        fprintf(stderr, "could not write checkpoint %s (%d)\n", path, status);
+    else
+        fprintf(stderr, "checkpoint %s at generation %llu\n", path, (unsigned long long) generation);
+    return status == CHECKPOINT_OK;
+}
+
+/*  Put the board back as the checkpoint at path left it. The packed bits
+    are copied straight out of the mapped file, the cells and the frontier
+    are rebuilt from them a word at a time: each column's live cells in a
+    word mark their neighbourhood with one addFrontierColumns.
+*/
+bool restoreBoard(cell_board* board, Queue* q, const char* path, uint64_t* generation) {
+    checkpoint_map m;
+    int status = checkpoint_open(&m, path);
+    if(status != CHECKPOINT_OK) {
+        fprintf(stderr, "could not read checkpoint %s (%d)\n", path, status);
+        return false;
+    }
+    const checkpoint_header* h = m.header;
+    const size_t words = (board_width * board_height + 63) / 64;
+    if(strcmp(h->engine, "life") != 0 || h->width != board_width || h->height != board_height
+       || h->cell_bits != 1 || h->state_bytes != words * sizeof(uint64_t)) {
+        fprintf(stderr, "checkpoint %s is a %s board of %llux%llu, not this one\n", path, h->engine,
+            (unsigned long long) h->width, (unsigned long long) h->height);
+        checkpoint_close(&m);
+        return false;
+    }
+
+    clearBoard(board);
+    resetQueue(q);
+    frontier_clear(&board->frontier);
+    memcpy(board->bits, m.state, h->state_bytes);
+    // bits past the last cell would be taken for cells of a bigger board
+    if((board_width * board_height) % 64)
+        board->bits[words - 1] &= ((uint64_t) 1 << (board_width * board_height) % 64) - 1;
+
+    for(size_t w = 0; w < words; w++) {
+        uint64_t live = board->bits[w];
+        while(live) {
+            uint64_t k = w * 64 + (uint64_t) __builtin_ctzll(live);
+            size_t i = k / board_height, j = k % board_height;
+            // the live bits of this word that are still in column i
+            uint64_t column_end = (uint64_t) (i + 1) * board_height - w * 64;
+            uint64_t column = column_end >= 64 ? live : live & (((uint64_t) 1 << column_end) - 1);
+            live &= ~column;
+
+            int high = 63 - __builtin_clzll(column);
+            for(; column; column &= column - 1)
+                board->cells[i][j + __builtin_ctzll(column) - (k - w * 64)].alive = alive;
+            addFrontierColumns(board, i, j, 0, (int) (w * 64 + high - k));
+        }
+    }
+
+    *generation = h->generation;
+    board_rng = h->rng;
+    fprintf(stderr, "restored %s at generation %llu\n", path, (unsigned long long) h->generation);
+    checkpoint_close(&m);
+    return true;
+}
+
+// The board belongs to the simulation thread: it steps it, applies the
+// commands the render loop queues and publishes every finished generation as
+// a packed snapshot the render loop draws whenever it gets to it.
+// How many generations the next frame gets: rate times the time since the
+// last frame, fractions carried over, cut short when the measured cost of a
+// generation says the next one would overrun the frame.
+typedef struct {
+    uint64_t rate;          // target generations per second, 0 runs as many as fit
+    double owed;            // generations due and not run yet
+    double gen_ns;          // moving average of one generation
+    uint64_t last_ns;       // start of the previous frame
+} scheduler;
+
+typedef struct {
+    cell_board* board;
+    Queue* queue;
+    Ring commands;              // render loop -> simulation, Command values
+    snapshot_buffer snapshots;  // simulation -> render loop
+    uint64_t generation;
+    scheduler pace;
+} simulation;
+
+uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void simSleep(unsigned int us) {
+#ifdef __linux__
+    usleep((__useconds_t) us);
+#elif _WIN32
+    Sleep((DWORD) (us + 999) / 1000);
+#elif __APPLE__
+    usleep((useconds_t) us);
+#endif
+}
+
+void publishBoard(simulation* sim) {
+    snapshot_publish(&sim->snapshots, sim->board->bits, sim->generation);
+}
+
+/* Commands are dropped when the queue is full, only quit waits for room */
+bool sendCommand(simulation* sim, uint64_t command) {
+    return ring_push(&sim->commands, command);
+}
+
+/*  One frame's worth of generations, then sleep out the rest of the frame.
+    Only the last generation is published, the render loop can't show more
+    than one per frame anyway.
+*/
+void runFrame(simulation* sim) {
+    const uint64_t frame_ns = 1000000000ull / FRAME_RATE;
+    scheduler* pace = &sim->pace;
+    uint64_t start = nowNs(), now = start;
+    uint64_t gens = 0;
+
+    // don't bank more than two frames' worth, a slow stretch or a pause
+    // shouldn't be made up in a burst
+    double per_frame = (double) pace->rate / FRAME_RATE;
+    double due = (double) pace->rate * (start - pace->last_ns) / 1e9;
+    pace->owed = pace->rate ? fmin(pace->owed + due, fmax(2 * per_frame, 1.0)) : INFINITY;
+    pace->last_ns = start;
+
+    // always at least one, however slow a generation is
+    while(pace->owed >= 1.0 && (gens == 0 || now - start + pace->gen_ns < frame_ns)) {
+        updateBoard(sim->board, sim->queue);
+        sim->generation++;
+        pace->owed -= 1.0;
+        gens++;
+
+        uint64_t after = nowNs();
+        pace->gen_ns = pace->gen_ns * 0.875 + (after - now) * 0.125;
+        now = after;
+    }
+
+    if(gens)
+        publishBoard(sim);
+    if(now - start < frame_ns)
+        simSleep((frame_ns - (now - start)) / 1000);
+}
+
+void* simulate(void* arg) {
+    simulation* sim = (simulation*) arg;
+    cell_board* board = sim->board;
+    Queue* queue = sim->queue;
+    GameMode sim_mode = paused;
+
+    while(true) {
+        uint64_t command;
+        bool changed = false;
+
+        while(ring_pop(&sim->commands, &command)) {
+            switch(command & ((1u << COMMAND_BITS) - 1)) {
+                case command_quit:
+                    // a run that never stepped has nothing worth keeping, don't clobber an older one
+                    if(sim->generation)
+                        checkpointBoard(board, checkpoint_path, sim->generation);
+                    return NULL;
+
+                case command_toggle_run:
+                    sim_mode = sim_mode == paused ? running : paused;
+                    break;
+
+                case command_randomize:
+                    clearBoard(board);
+                    randomizeBoard(board, queue);
+                    packBoard(board);
+                    changed = true;
+                    break;
+
+                case command_clear:
+                    clearBoard(board);
+                    fprintf(stderr, "cleared board\n");
+
+                    resetQueue(queue);
+                    fprintf(stderr, "reset queue\n");
+                    changed = true;
+                    break;
+
+                case command_glider:
+                    clearBoard(board);
+                    resetQueue(queue);
+                    setBoardGlider(board, queue, GLIDER_I_0, GLIDER_J_0);
+                    packBoard(board);
+                    changed = true;
+                    break;
+
+                case command_click:
+                    drawTile(board, queue, command >> COMMAND_BITS & COMMAND_CELL_MASK,
+                        command >> (COMMAND_BITS + COMMAND_CELL_BITS));
+                    changed = true;
+                    break;
+
+                case command_rate:
+                    sim->pace.rate = command >> COMMAND_BITS;
+                    sim->pace.owed = 0;
+                    break;
+
+                case command_pattern:
+                    if(pattern_path) {
+                        if(hasExtension(pattern_path, ".mc"))
+                            loadMacrocell(board, queue, pattern_path, 0, 0, true);
+                        else
+                            loadPattern(board, queue, pattern_path, 0, 0, true);
+                        changed = true;
+                    }
+                    break;
+
+                case command_save:
+                    savePattern(board, PATTERN_SAVE_PATH);
+                    break;
+
+                case command_save_macrocell:
+                    saveMacrocell(board, MACROCELL_SAVE_PATH, sim->generation);
+                    break;
+
+                case command_checkpoint:
+                    checkpointBoard(board, checkpoint_path, sim->generation);
+                    break;
+
+                case command_restore:
+                    changed = restoreBoard(board, queue, checkpoint_path, &sim->generation) || changed;
+                    break;
+            }
+        }
+
+        if(sim_mode == running) {
+            runFrame(sim);
+        } else if(changed) {
+            publishBoard(sim);
+        } else {
+            simSleep(SIM_IDLE_US);
+        }
+    }
+}
+
 unsigned long safe_atoi(const char *str) {
     unsigned long value;
     if (sscanf(str, "%zu", &value) == 1) {
@@ -425,7 +1244,8 @@ unsigned long safe_atoi(const char *str) {
 }
 
 int main(int argc, char** argv) {
-    srand(time(NULL));
+    board_rng ^= (uint64_t) time(NULL) * 0xBF58476D1CE4E5B9ULL;
+    bool restoring = false;
 
 
     //fprintf(stderr, "Num args: %i", argc);
@@ -440,6 +1260,26 @@ int main(int argc, char** argv) {
         if(argc >= 4) {
             cell_width_px = (unsigned) safe_atoi(argv[3]);
         }
+
+        if(argc >= 5 && hasExtension(argv[4], ".ckpt")) {
+            checkpoint_path = argv[4];
+            restoring = true;
+        } else if(argc >= 5) {
+            pattern_path = argv[4];
+        }
+    }
+
+    // a checkpoint brings its own board size
+    if(restoring) {
+        checkpoint_map restore;
+        if(checkpoint_open(&restore, checkpoint_path) != CHECKPOINT_OK || restore.header->width == 0
+           || restore.header->height == 0) {
+            fprintf(stderr, "could not read checkpoint %s\n", checkpoint_path);
+            return 1;
+        }
+        board_width = restore.header->width;
+        board_height = restore.header->height;
+        checkpoint_close(&restore);
     }
 
 
@@ -449,7 +1289,6 @@ int main(int argc, char** argv) {
     cell_board* board = init_board(board_width, board_height);
     
     Queue* queue = malloc(sizeof(Queue));
-    initializeQueue(queue, board->board_width * board->board_height);
 
     if (board == NULL) {
         return 1;  // Return 1 to indicate memory allocation failure
@@ -457,12 +1296,76 @@ int main(int argc, char** argv) {
     if (queue == NULL) {
         return 1;  // Return 1 to indicate memory allocation failure
     }
+    // the queue doubles on demand, no need to reserve the whole board up front
+    initializeQueue(queue, QUEUE_MIN_SIZE);
 
     fprintf(stderr, "Gotten board\n");
     
-    InitWindow(board_width * cell_width_px / 2, board_height * cell_width_px / 2, "GoL (rip Conway)");
+    // the window no longer has to fit the board, only to not exceed VIEW_MAX_PX
+    viewport view = { .center_i = board_width / 2, .center_j = board_height / 2 };
+    view.width = board_width * cell_width_px / 2;
+    view.height = board_height * cell_width_px / 2;
+    view.width = view.width < 1 ? 1 : view.width > VIEW_MAX_PX ? VIEW_MAX_PX : view.width;
+    view.height = view.height < 1 ? 1 : view.height > VIEW_MAX_PX ? VIEW_MAX_PX : view.height;
+
+    InitWindow(view.width, view.height, "GoL (rip Conway)");
+
+    SetTargetFPS(FRAME_RATE);
+
+    if(density_init(&view.density, board_width, board_height) != DENSITY_OK) {
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
+    board_texture* texture = &view.texture;
+    if(render_init(texture, view.width, view.height) != PIXELS_OK) {
+        density_destroy(&view.density);
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
+
+    // start at the closest zoom that shows the whole board
+    view.zoom = VIEW_MAX_ZOOM;
+    while(view.zoom > -(int) view.density.count
+          && ((view.zoom >= 0 ? board_width << view.zoom : board_width >> -view.zoom) > view.width
+              || (view.zoom >= 0 ? board_height << view.zoom : board_height >> -view.zoom) > view.height))
+        view.zoom--;
+
+    simulation sim = { .board = board, .queue = queue, .generation = 0, .pace = { .rate = SIM_DEFAULT_RATE } };
+    uint64_t rate = SIM_DEFAULT_RATE;
+    if(ring_init(&sim.commands, SIM_COMMANDS) != RING_OK) {
+        render_unload(texture);
+        density_destroy(&view.density);
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
+    if(snapshot_init(&sim.snapshots, board_width, board_height, SNAPSHOT_TILE_SHIFT) != SNAPSHOT_OK) {
+        ring_destroy(&sim.commands);
+        render_unload(texture);
+        density_destroy(&view.density);
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
+    board->snapshots = &sim.snapshots;
+
+    pthread_t sim_thread;
+    if(pthread_create(&sim_thread, NULL, simulate, &sim) != 0) {
+        snapshot_destroy(&sim.snapshots);
+        ring_destroy(&sim.commands);
+        render_unload(texture);
+        density_destroy(&view.density);
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
 
-    SetTargetFPS(120);
+    if(pattern_path)
+        sendCommand(&sim, command_pattern);
+    if(restoring)
+        sendCommand(&sim, command_restore);
 
     //randomizeBoard(board);
     //printBoard(board);
@@ -471,13 +1374,24 @@ int main(int argc, char** argv) {
         
         int key_pressed = GetKeyPressed();
 
-        if(key_pressed == KEY_KP_EQUAL) {
-            // TODO: resize screen
-        }
+        int zoom_steps = (key_pressed == KEY_KP_EQUAL) - (key_pressed == KEY_KP_SUBTRACT);
+        float wheel = GetMouseWheelMove();
+        zoom_steps += (wheel > 0) - (wheel < 0);
+        int64_t pan_i = panStep(&view, view.width), pan_j = panStep(&view, view.height);
+        moveView(&view, zoom_steps, (IsKeyDown(KEY_RIGHT) - IsKeyDown(KEY_LEFT)) * pan_i,
+            (IsKeyDown(KEY_DOWN) - IsKeyDown(KEY_UP)) * pan_j);
 
-        if(key_pressed == KEY_KP_SUBTRACT) {
-            // TODO: resize screen
-        }
+        if(key_pressed == KEY_H && !toggleHeat(&view))
+            fprintf(stderr, "not enough memory for the heat plane\n");
+
+        if(key_pressed == KEY_S)
+            sendCommand(&sim, command_save);
+
+        if(key_pressed == KEY_M)
+            sendCommand(&sim, command_save_macrocell);
+
+        if(key_pressed == KEY_F5)
+            sendCommand(&sim, command_checkpoint);
 
         switch(mode) {
 
@@ -485,71 +1399,60 @@ int main(int argc, char** argv) {
                 //DrawText(TextFormat("Paused"), 80, CELL_WIDTH_PX * BOARD_HEIGHT + 20, 20, RED);
 
                 if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-                    drawClickedTile(board, queue);
+                    int64_t cell_i = viewCell(&view, viewOrigin(&view, view.center_i, view.width), GetMouseX());
+                    int64_t cell_j = viewCell(&view, viewOrigin(&view, view.center_j, view.height), GetMouseY());
+                    if(cell_i >= 0 && cell_j >= 0 && cell_i < (int64_t) board_width && cell_j < (int64_t) board_height)
+                        sendCommand(&sim, command_click | (uint64_t) cell_i << COMMAND_BITS
+                            | (uint64_t) cell_j << (COMMAND_BITS + COMMAND_CELL_BITS));
                 }
 
                 if(key_pressed == KEY_R) {
-                    clearBoard(board);
-                    randomizeBoard(board, queue);
+                    sendCommand(&sim, command_randomize);
                 }
 
                 if(key_pressed == KEY_C) {
-                    clearBoard(board);
-                    fprintf(stderr, "cleared board\n");
-                    
-                    resetQueue(queue);
-                    fprintf(stderr, "reset queue\n");
+                    sendCommand(&sim, command_clear);
                 }
 
                 if(key_pressed == KEY_G) {
-                    clearBoard(board);
-                    fprintf(stderr, "cleared board\n");
-                    
-                    resetQueue(queue);
-                    fprintf(stderr, "reset queue\n");
+                    sendCommand(&sim, command_glider);
+                }
 
-                    setBoardGlider(board, queue, GLIDER_I_0, GLIDER_J_0);
+                if(key_pressed == KEY_L) {
+                    sendCommand(&sim, command_pattern);
+                }
+
+                if(key_pressed == KEY_F9) {
+                    sendCommand(&sim, command_restore);
                 }
                 
-                if(key_pressed == KEY_SPACE) {
+                if(key_pressed == KEY_SPACE && sendCommand(&sim, command_toggle_run)) {
                     mode = running;
-                    SetTargetFPS(30);
                     SetWindowTitle("GoL (rip Conway) : (running)");
-                    continue;
                 }
 
                 break;
 
             case running:
                 //DrawText(TextFormat("Running"), 80, CELL_WIDTH_PX * BOARD_HEIGHT + 20, 20, RED);
-#ifdef WAIT
-
-#ifdef __linux__
-                usleep((__useconds_t) 100);
-#elif _WIN32
-                Sleep((DWORD) 1);
-#elif __APPLE__
-                usleep((useconds_t) 100);
-#endif
-
-#endif
-                if(key_pressed == KEY_SPACE) {
+                if(key_pressed == KEY_SPACE && sendCommand(&sim, command_toggle_run)) {
                     mode = paused;
-                    SetTargetFPS(120);
                     SetWindowTitle("GoL (rip Conway) : (paused)");
-                    continue;
                 }
 
-                if(key_pressed == KEY_EQUAL) {
-
+                // turbo: double the generation rate, past SIM_MAX_RATE run unthrottled
+                if(key_pressed == KEY_EQUAL && rate != 0) {
+                    uint64_t faster = rate * 2 > SIM_MAX_RATE ? 0 : rate * 2;
+                    if(sendCommand(&sim, command_rate | faster << COMMAND_BITS))
+                        rate = faster;
                 }
 
-                if(key_pressed == KEY_MINUS) {
-                    
+                if(key_pressed == KEY_MINUS && rate != 1) {
+                    uint64_t slower = rate == 0 ? SIM_MAX_RATE : rate / 2;
+                    if(sendCommand(&sim, command_rate | slower << COMMAND_BITS))
+                        rate = slower;
                 }
 
-                updateBoard(board, queue);
-
                 break;
 
             default:
@@ -558,13 +1461,22 @@ int main(int argc, char** argv) {
                 break;
         }
 
-        //updateBoard(board);
-        drawBoard(board);
+        drawBoard(&view, &sim.snapshots, rate);
     }
-    
+
+    while(!sendCommand(&sim, command_quit))
+        simSleep(SIM_IDLE_US);
+    pthread_join(sim_thread, NULL);
+
+    snapshot_destroy(&sim.snapshots);
+    ring_destroy(&sim.commands);
+    render_unload(texture);
+    density_destroy(&view.density);
+    heat_destroy(&view.heat);
+    free(view.heat_row);
     CloseWindow();
     //printf("%zu", sizeof(cell_board));
     free_board(board);
     freeQueue(queue);
     return 0;
-}
\ No newline at end of file
+}
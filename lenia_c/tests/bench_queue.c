@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "queue_d.h"
+
+// Queue throughput for single and batched enqueue / dequeue and peek, plus
+// per-op latency percentiles for a queue held at a steady depth (a dequeue
+// for every enqueue, like the frontier between two generations). Latency is
+// timed over blocks of LATENCY_BLOCK ops so the clock read doesn't dominate.
+// One key=value line per run like the headless driver.
+
+#define ITEMS (1u << 22)
+#define LATENCY_BLOCK 64
+#define LATENCY_SAMPLES 65536
+
+double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int cmp_double(const void* a, const void* b) {
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+void report(const char* op, uint64_t batch, uint64_t items, double ns, uint64_t checksum) {
+    printf("struct=queue op=%s batch=%lu items=%lu ms=%.2f mops=%.2f checksum=%lu\n", op, (unsigned long) batch,
+        (unsigned long) items, ns / 1e6, items / ns * 1e3, (unsigned long) checksum);
+}
+
+void throughput(uint64_t batch) {
+    Queue q;
+    uint64_t values[256], checksum = 0;
+    initializeQueue(&q, 0);
+    for(uint64_t k = 0; k < batch; k++)
+        values[k] = k;
+
+    // the first fill pays for growing the buffer, the second reuses it
+    for(int pass = 0; pass < 2; pass++) {
+        double t0 = now_ns();
+        if(batch == 1) {
+            for(uint64_t k = 0; k < ITEMS; k++)
+                enqueue(&q, k);
+        } else {
+            for(uint64_t k = 0; k < ITEMS; k += batch)
+                enqueue_n(&q, values, batch);
+        }
+        double t1 = now_ns();
+        report(pass ? "enqueue" : "enqueue_grow", batch, ITEMS, t1 - t0, queueLength(&q));
+
+        if(pass == 1 && batch == 1) {
+            Queue* volatile front = &q;     // reload every time, or the loop folds into one peek
+            t0 = now_ns();
+            for(uint64_t k = 0; k < ITEMS; k++)
+                checksum += peek(front);
+            t1 = now_ns();
+            report("peek", 1, ITEMS, t1 - t0, checksum);
+        }
+
+        t0 = now_ns();
+        if(batch == 1) {
+            for(uint64_t k = 0; k < ITEMS; k++) {
+                checksum += peek(&q);
+                dequeue(&q);
+            }
+        } else {
+            for(uint64_t k = 0; k < ITEMS; k += batch)
+                checksum += dequeue_n(&q, values, batch);
+        }
+        t1 = now_ns();
+        report(batch == 1 ? "peek_dequeue" : "dequeue", batch, ITEMS, t1 - t0, checksum);
+        resetQueue(&q);
+    }
+    freeQueue(&q);
+}
+
+void latency(uint64_t depth) {
+    Queue q;
+    static double samples[LATENCY_SAMPLES];
+    uint64_t checksum = 0;
+    initializeQueue(&q, 0);
+    for(uint64_t k = 0; k < depth; k++)
+        enqueue(&q, k);
+
+    for(uint64_t s = 0; s < LATENCY_SAMPLES; s++) {
+        double t0 = now_ns();
+        for(uint64_t k = 0; k < LATENCY_BLOCK; k++) {
+            enqueue(&q, k);
+            checksum += peek(&q);
+            dequeue(&q);
+        }
+        samples[s] = (now_ns() - t0) / LATENCY_BLOCK;
+    }
+    qsort(samples, LATENCY_SAMPLES, sizeof(double), cmp_double);
+
+    printf("struct=queue op=steady depth=%lu ops=%lu p50_ns=%.1f p90_ns=%.1f p99_ns=%.1f p999_ns=%.1f max_ns=%.1f checksum=%lu\n",
+        (unsigned long) depth, (unsigned long) LATENCY_SAMPLES * LATENCY_BLOCK,
+        samples[LATENCY_SAMPLES / 2], samples[LATENCY_SAMPLES * 9 / 10], samples[LATENCY_SAMPLES * 99 / 100],
+        samples[LATENCY_SAMPLES * 999 / 1000], samples[LATENCY_SAMPLES - 1], (unsigned long) checksum);
+    freeQueue(&q);
+}
+
+int main(void) {
+    uint64_t batches[] = { 1, 16, 256 };
+    uint64_t depths[] = { 16, 4096, 1u << 20 };
+
+    for(size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+        throughput(batches[b]);
+    for(size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+        latency(depths[d]);
+
+    return 0;
+}
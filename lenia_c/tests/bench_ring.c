@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "ring.h"
+
+// Throughput of the ring with N producers and N consumers at a few batch
+// sizes, one key=value line per run like the headless driver.
+
+#define ITEMS (1u << 22)
+#define CAPACITY 4096
+
+typedef struct {
+    Ring* ring;
+    uint64_t items;
+    uint64_t batch;
+} worker;
+
+double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void* produce(void* arg) {
+    worker* w = arg;
+    uint64_t values[256];
+    for(uint64_t k = 0; k < w->batch; k++)
+        values[k] = k;
+
+    for(uint64_t done = 0; done < w->items; ) {
+        uint64_t want = w->items - done < w->batch ? w->items - done : w->batch;
+        uint64_t n = ring_push_n(w->ring, values, want);
+        if(n == 0)
+            sched_yield();
+        done += n;
+    }
+    return NULL;
+}
+
+void* consume(void* arg) {
+    worker* w = arg;
+    uint64_t values[256];
+
+    for(uint64_t done = 0; done < w->items; ) {
+        uint64_t want = w->items - done < w->batch ? w->items - done : w->batch;
+        uint64_t n = ring_pop_n(w->ring, values, want);
+        if(n == 0)
+            sched_yield();
+        done += n;
+    }
+    return NULL;
+}
+
+void run(int threads, uint64_t batch) {
+    Ring ring;
+    pthread_t producers[threads], consumers[threads];
+    worker w = { &ring, ITEMS / threads, batch };
+
+    ring_init(&ring, CAPACITY);
+
+    double t0 = now_ms();
+    for(int i = 0; i < threads; i++) {
+        pthread_create(&consumers[i], NULL, consume, &w);
+        pthread_create(&producers[i], NULL, produce, &w);
+    }
+    for(int i = 0; i < threads; i++) {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+    }
+    double ms = now_ms() - t0;
+
+    printf("threads=%d batch=%lu items=%lu ms=%.1f mops=%.2f\n", threads, (unsigned long) batch,
+        (unsigned long) (w.items * threads), ms, w.items * threads / ms / 1e3);
+    ring_destroy(&ring);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 4;
+    uint64_t batches[] = { 1, 16, 256 };
+
+    for(int threads = 1; threads <= max_threads; threads *= 2)
+        for(size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+            run(threads, batches[b]);
+
+    return 0;
+}
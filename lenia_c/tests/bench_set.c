@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "set.h"
+
+// SimpleSet insert / contains (hits and misses) / remove over table sizes,
+// load factors and key distributions. The table is sized so the keys fill it
+// to the target load; set.c grows past 25% so above that it reports the load
+// it actually ended at. Built once against set.c and once against
+// set_swiss.c (-DSET_SWISS), one key=value line per run.
+
+#ifdef SET_SWISS
+#define IMPL "swiss"
+#else
+#define IMPL "simple"
+#endif
+
+#define KEY_LEN 24
+
+double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+typedef enum { DENSE, SCATTERED, LONG } distribution;
+const char* distribution_names[] = { "dense", "scattered", "long" };
+
+// cell keys the way the game code spells them, "i,j": a solid square patch,
+// cells spread over a 4096x4096 board, or longer names that don't fit inline
+char* make_keys(distribution dist, uint64_t n, uint64_t offset) {
+    char* keys = malloc(n * KEY_LEN);
+    uint64_t side = 1;
+    while(side * side < 2 * n)
+        side <<= 1;
+    for(uint64_t k = 0; k < n; k++) {
+        uint64_t cell = (k + offset) * 2654435761u;
+        char* key = keys + k * KEY_LEN;
+        if(dist == DENSE)
+            snprintf(key, KEY_LEN, "%lu,%lu", (unsigned long) ((k + offset) / side), (unsigned long) ((k + offset) % side));
+        else if(dist == SCATTERED)
+            snprintf(key, KEY_LEN, "%lu,%lu", (unsigned long) (cell % 4096), (unsigned long) (cell / 4096 % 4096));
+        else
+            snprintf(key, KEY_LEN, "cell-%07lu-%07lu", (unsigned long) (cell % 4096), (unsigned long) (cell / 4096 % 4096));
+    }
+    return keys;
+}
+
+void run(distribution dist, uint64_t n, double load) {
+    SimpleSet s;
+    char* keys = make_keys(dist, n, 0);
+    char* misses = make_keys(dist, n, n);
+    uint64_t found = 0;
+
+    set_init_alt(&s, (uint64_t) (n / load), NULL);
+
+    double t0 = now_ms();
+    for(uint64_t k = 0; k < n; k++)
+        set_add(&s, keys + k * KEY_LEN);
+    double t1 = now_ms();
+    double final_load = (double) set_length(&s) / s.number_nodes;
+    // probe in a scrambled order so malloc'd nodes don't get streamed in insertion order
+    for(uint64_t k = 0; k < n; k++)
+        found += set_contains(&s, keys + (k * 40503 & (n - 1)) * KEY_LEN) == SET_TRUE;
+    double t2 = now_ms();
+    for(uint64_t k = 0; k < n; k++)
+        found += set_contains(&s, misses + k * KEY_LEN) == SET_TRUE;
+    double t3 = now_ms();
+    for(uint64_t k = 0; k < n; k++)
+        set_remove(&s, keys + (k * 40503 & (n - 1)) * KEY_LEN);
+    double t4 = now_ms();
+
+    printf("impl=%s dist=%s keys=%lu target_load=%.3f load=%.3f add_mops=%.2f hit_mops=%.2f miss_mops=%.2f remove_mops=%.2f found=%lu\n",
+        IMPL, distribution_names[dist], (unsigned long) n, load, final_load, n / (t1 - t0) / 1e3,
+        n / (t2 - t1) / 1e3, n / (t3 - t2) / 1e3, n / (t4 - t3) / 1e3, (unsigned long) found);
+
+    set_destroy(&s);
+    free(keys);
+    free(misses);
+}
+
+int main(int argc, char** argv) {
+    uint64_t max_keys = argc > 1 ? strtoull(argv[1], NULL, 10) : 1u << 20;
+    double loads[] = { 0.125, 0.25, 0.5, 0.75 };
+
+    for(uint64_t n = 1u << 12; n <= max_keys; n <<= 4)
+        for(int d = DENSE; d <= LONG; d++)
+            for(size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++)
+                run(d, n, loads[l]);
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+
+// A checkpoint has to map back with the header it was written with and the
+// state page aligned and byte for byte. A write that fails has to leave the
+// previous checkpoint as it was and no temp file behind. Files that are
+// cut short, aren't checkpoints or come from a newer version are refused.
+
+#define WORDS 100003
+
+static uint64_t state[WORDS];
+
+void write_bytes(const char* path, const void* data, size_t bytes) {
+    FILE* fp = fopen(path, "wb");
+    fwrite(data, 1, bytes, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    size_t wrong = 0;
+    checkpoint_header h;
+    checkpoint_map m;
+
+    for(size_t k = 0; k < WORDS; k++)
+        state[k] = k * 0x9E3779B97F4A7C15ULL;
+    checkpoint_describe(&h, "life3d", "4555");
+    h.width = 128;
+    h.height = 77;
+    h.depth = 3;
+    h.generation = 1ull << 40;
+    h.rng = 0x0123456789abcdefULL;
+    h.cell_bits = 1;
+    h.params[3] = 0.1f;
+    h.state_bytes = sizeof(state);
+    wrong += checkpoint_write("test_checkpoint.ckpt", &h, state) != CHECKPOINT_OK;
+    wrong += fopen("test_checkpoint.ckpt.tmp", "rb") != NULL;
+
+    wrong += checkpoint_open(&m, "test_checkpoint.ckpt") != CHECKPOINT_OK;
+    if(m.header) {
+        wrong += strcmp(m.header->engine, "life3d") != 0 || strcmp(m.header->rule, "4555") != 0;
+        wrong += m.header->version != CHECKPOINT_VERSION || m.header->width != 128 || m.header->height != 77;
+        wrong += m.header->depth != 3 || m.header->generation != 1ull << 40 || m.header->rng != h.rng;
+        wrong += m.header->params[3] != 0.1f || m.header->state_bytes != sizeof(state);
+        wrong += (uintptr_t) m.state % CHECKPOINT_ALIGN != 0 || memcmp(m.state, state, sizeof(state)) != 0;
+    }
+    checkpoint_close(&m);
+
+    // a directory that isn't there: nothing written, the old checkpoint untouched
+    wrong += checkpoint_write("no_such_dir/test_checkpoint.ckpt", &h, state) != CHECKPOINT_FILE_ERROR;
+    wrong += checkpoint_open(&m, "test_checkpoint.ckpt") != CHECKPOINT_OK || m.header->generation != 1ull << 40;
+    checkpoint_close(&m);
+
+    // the header promises more state than the file holds
+    FILE* fp = fopen("test_checkpoint.ckpt", "rb");
+    uint8_t* head = malloc(CHECKPOINT_ALIGN + 100);
+    size_t got = fread(head, 1, CHECKPOINT_ALIGN + 100, fp);
+    fclose(fp);
+    write_bytes("test_checkpoint_cut.ckpt", head, got);
+    wrong += checkpoint_open(&m, "test_checkpoint_cut.ckpt") != CHECKPOINT_FORMAT_ERROR;
+
+    ((checkpoint_header*) head)->version = CHECKPOINT_VERSION + 1;
+    write_bytes("test_checkpoint_cut.ckpt", head, got);
+    wrong += checkpoint_open(&m, "test_checkpoint_cut.ckpt") != CHECKPOINT_VERSION_ERROR;
+
+    memcpy(head, "NOTACKPT", 8);
+    write_bytes("test_checkpoint_cut.ckpt", head, got);
+    wrong += checkpoint_open(&m, "test_checkpoint_cut.ckpt") != CHECKPOINT_FORMAT_ERROR;
+    write_bytes("test_checkpoint_cut.ckpt", head, 100);
+    wrong += checkpoint_open(&m, "test_checkpoint_cut.ckpt") != CHECKPOINT_FORMAT_ERROR;
+    wrong += checkpoint_open(&m, "no_such_file.ckpt") != CHECKPOINT_FILE_ERROR;
+    free(head);
+
+    remove("test_checkpoint.ckpt");
+    remove("test_checkpoint_cut.ckpt");
+    printf("%zu byte state, %lu wrong\n", sizeof(state), (unsigned long) wrong);
+    return wrong != 0;
+}
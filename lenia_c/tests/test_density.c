@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "density.h"
+
+// A pyramid kept up to date block by block has to match one rebuilt from
+// scratch, and level 1 has to be the plain share of live cells per 2x2.
+
+#define ROWS 300
+#define COLS 213
+#define TILE 32
+#define ROUNDS 50
+
+uint64_t bits[(ROWS * COLS + 63) / 64];
+
+void flip(size_t i, size_t j) {
+    size_t k = i * COLS + j;
+    bits[k / 64] ^= (uint64_t) 1 << (k % 64);
+}
+
+int alive(size_t i, size_t j) {
+    size_t k = i * COLS + j;
+    return (bits[k / 64] >> (k % 64)) & 1;
+}
+
+int main(void) {
+    density_pyramid kept, fresh;
+    size_t wrong = 0;
+
+    if(density_init(&kept, ROWS, COLS) != DENSITY_OK)
+        return 1;
+
+    for(size_t i = 0; i < ROWS; i++)
+        for(size_t j = 0; j < COLS; j++)
+            if(rand() % 4 == 0)
+                flip(i, j);
+    density_update_block(&kept, bits, 0, ROWS, 0, COLS);
+
+    // flip a few cells per round, update only the tiles they are in
+    for(int round = 0; round < ROUNDS; round++) {
+        for(int f = 0; f < 20; f++) {
+            size_t i = rand() % ROWS, j = rand() % COLS;
+            flip(i, j);
+            size_t i0 = i / TILE * TILE, j0 = j / TILE * TILE;
+            density_update_block(&kept, bits, i0, i0 + TILE < ROWS ? i0 + TILE : ROWS, j0, j0 + TILE < COLS ? j0 + TILE : COLS);
+        }
+    }
+
+    density_init(&fresh, ROWS, COLS);
+    density_update_block(&fresh, bits, 0, ROWS, 0, COLS);
+    for(unsigned l = 1; l <= kept.count; l++)
+        wrong += memcmp(kept.levels[l], fresh.levels[l], kept.rows[l] * kept.cols[l]) != 0;
+
+    for(size_t r = 0; r < kept.rows[1]; r++) {
+        for(size_t c = 0; c < kept.cols[1]; c++) {
+            unsigned live = 0, cells = 0;
+            for(size_t i = 2 * r; i < 2 * r + 2 && i < ROWS; i++)
+                for(size_t j = 2 * c; j < 2 * c + 2 && j < COLS; j++, cells++)
+                    live += alive(i, j);
+            wrong += density_at(&kept, 1, r, c) != (live * 255 + cells / 2) / cells;
+        }
+    }
+
+    printf("%dx%d board, %u levels, top %u, %lu wrong\n", ROWS, COLS, kept.count,
+        density_at(&kept, kept.count, 0, 0), (unsigned long) wrong);
+    density_destroy(&kept);
+    density_destroy(&fresh);
+    return wrong != 0;
+}
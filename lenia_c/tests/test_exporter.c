@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "exporter.h"
+
+// Submitting never blocks without wait: a burst past the queue's capacity
+// is dropped and counted, never lost silently. With wait every image gets
+// written, and the files hold the rows that were submitted.
+
+#define WIDTH 300
+#define HEIGHT 200
+#define BURST 64
+
+uint8_t* grey_image(unsigned seed) {
+    uint8_t* data = malloc(WIDTH * HEIGHT);
+    for(size_t k = 0; k < WIDTH * HEIGHT; k++)
+        data[k] = (uint8_t) (k * 7 + seed);
+    return data;
+}
+
+int main(void) {
+    exporter e;
+    size_t wrong = 0, queued = 0;
+
+    if(exporter_start(&e, 2) != EXPORTER_OK)
+        return 1;
+    for(unsigned k = 0; k < BURST; k++) {
+        export_job job = { .data = grey_image(k), .width = WIDTH, .height = HEIGHT, .depth = 8 };
+        snprintf(job.path, EXPORTER_PATH_MAX, "test_exporter_%u.bmp", k % 4);
+        queued += exporter_submit(&e, &job, false) == EXPORTER_OK;
+    }
+    exporter_stop(&e);
+    wrong += e.written != queued || e.written + e.dropped != BURST || e.failed != 0;
+    uint64_t burst_dropped = e.dropped;
+
+    exporter_start(&e, 2);
+    for(unsigned k = 0; k < BURST; k++) {
+        export_job job = { .data = grey_image(k), .width = WIDTH, .height = HEIGHT, .depth = 8 };
+        snprintf(job.path, EXPORTER_PATH_MAX, "test_exporter_%u.bmp", k % 4);
+        wrong += exporter_submit(&e, &job, true) != EXPORTER_OK;
+    }
+    // a path that can't be opened counts as failed, not written
+    export_job bad = { .data = grey_image(0), .width = WIDTH, .height = HEIGHT, .depth = 8 };
+    snprintf(bad.path, EXPORTER_PATH_MAX, "no_such_dir/test_exporter.bmp");
+    exporter_submit(&e, &bad, true);
+    exporter_stop(&e);
+    wrong += e.written != BURST || e.dropped != 0 || e.failed != 1;
+
+    // written in order, so each file holds the last image queued for it
+    for(unsigned f = 0; f < 4; f++) {
+        char path[EXPORTER_PATH_MAX];
+        snprintf(path, sizeof(path), "test_exporter_%u.bmp", f);
+        FILE* fp = fopen(path, "rb");
+        uint8_t* expect = grey_image(BURST - 4 + f);
+        uint8_t row[WIDTH];
+        if(fp == NULL || fseek(fp, 54 + 1024 + (long) (HEIGHT - 1) * WIDTH, SEEK_SET) != 0
+           || fread(row, 1, WIDTH, fp) != WIDTH || memcmp(row, expect, WIDTH) != 0)
+            wrong++;
+        if(fp)
+            fclose(fp);
+        free(expect);
+        remove(path);
+    }
+
+    printf("burst of %d into a queue of 2: %lu dropped, %lu wrong\n", BURST, (unsigned long) burst_dropped,
+        (unsigned long) wrong);
+    return wrong != 0;
+}
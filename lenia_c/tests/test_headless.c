@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The driver's main, called in process
+#define main headless_main
+#include "../headless.c"
+#undef main
+
+// A run checkpointed halfway and restored has to end in the same checkpoint
+// as the run going straight through, for 3D Life and for a 2D Lenia run
+// with the largest radius its board takes. A checkpoint that can't be
+// restored, or a radius the board can't take, has to fail the process.
+
+#define ARGS(...) ((char*[]) { "headless", __VA_ARGS__, NULL })
+#define RUN(...) headless_main(sizeof(ARGS(__VA_ARGS__)) / sizeof(char*) - 1, ARGS(__VA_ARGS__))
+
+uint8_t* read_file(const char* path, size_t* bytes) {
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    *bytes = (size_t) ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t* data = malloc(*bytes);
+    *bytes = fread(data, 1, *bytes, fp);
+    fclose(fp);
+    return data;
+}
+
+size_t same_files(const char* a, const char* b) {
+    size_t na = 0, nb = 0;
+    uint8_t* da = read_file(a, &na);
+    uint8_t* db = read_file(b, &nb);
+    size_t same = da && db && na == nb && memcmp(da, db, na) == 0;
+    free(da);
+    free(db);
+    return same;
+}
+
+int main(void) {
+    size_t wrong = 0;
+
+    wrong += RUN("64", "16", "--engine", "life3d", "--depth", "16", "--seed", "7", "--steps", "6",
+        "--checkpoint", "0", "test_headless_a.ckpt") != 0;
+    wrong += RUN("64", "16", "--engine", "life3d", "--depth", "16", "--seed", "7", "--steps", "3",
+        "--checkpoint", "0", "test_headless_b.ckpt") != 0;
+    wrong += RUN("--restore", "test_headless_b.ckpt", "--steps", "3", "--checkpoint", "0", "test_headless_c.ckpt") != 0;
+    wrong += !same_files("test_headless_a.ckpt", "test_headless_c.ckpt");
+
+    // radius 20 is half of 40
+    wrong += RUN("64", "40", "--radius", "20", "--seed", "7", "--steps", "4", "--checkpoint", "0", "test_headless_a.ckpt") != 0;
+    wrong += RUN("64", "40", "--radius", "20", "--seed", "7", "--steps", "2", "--checkpoint", "0", "test_headless_b.ckpt") != 0;
+    wrong += RUN("--restore", "test_headless_b.ckpt", "--steps", "2", "--checkpoint", "0", "test_headless_c.ckpt") != 0;
+    wrong += !same_files("test_headless_a.ckpt", "test_headless_c.ckpt");
+
+    wrong += RUN("64", "40", "--radius", "21", "--steps", "1") == 0;
+    wrong += RUN("--restore", "no_such_file.ckpt") == 0;
+
+    // a radius that isn't a number in the header
+    checkpoint_map m;
+    checkpoint_header h;
+    wrong += checkpoint_open(&m, "test_headless_b.ckpt") != CHECKPOINT_OK;
+    h = *m.header;
+    h.params[0] = NAN;
+    wrong += checkpoint_write("test_headless_c.ckpt", &h, m.state) != CHECKPOINT_OK;
+    checkpoint_close(&m);
+    wrong += RUN("--restore", "test_headless_c.ckpt", "--steps", "1") == 0;
+
+    remove("test_headless_a.ckpt");
+    remove("test_headless_b.ckpt");
+    remove("test_headless_c.ckpt");
+    printf("checkpoint round trips and refusals, %lu wrong\n", (unsigned long) wrong);
+    return wrong != 0;
+}
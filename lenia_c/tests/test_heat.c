@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heat.h"
+
+// Stamps kept tile by tile have to match the generation each cell really
+// last flipped in, the warm list has to hold exactly the tiles that flipped
+// in the last HEAT_SPAN generations, and the SSE2 spans have to give the
+// same colors as the one cell path, from any start column.
+
+#define ROWS 300
+#define COLS 213
+#define TILE_SHIFT 5
+#define TILE (1 << TILE_SHIFT)
+#define TILES_X ((COLS + TILE - 1) / TILE)
+#define ROUNDS 300
+
+uint64_t bits[(ROWS * COLS + 63) / 64 + 1];
+uint32_t last_flip[ROWS * COLS];
+uint32_t tile_flip[(ROWS / TILE + 1) * TILES_X];
+uint32_t span[COLS];
+
+void flip(size_t i, size_t j) {
+    size_t k = i * COLS + j;
+    bits[k / 64] ^= (uint64_t) 1 << (k % 64);
+}
+
+int main(void) {
+    heat_plane h;
+    heat_palette palette = { 0xff46dcff, 0xffffffff, 0xff1428c8, 0xff000000 };
+    size_t wrong = 0;
+
+    if(heat_init(&h, ROWS, COLS, TILE_SHIFT, palette) != HEAT_OK)
+        return 1;
+
+    // start mid run, past the wrap of the 32 bit generations
+    uint32_t generation = 0xffffff00u;
+    for(size_t i = 0; i < ROWS; i++)
+        for(size_t j = 0; j < COLS; j++)
+            if(rand() % 4 == 0)
+                flip(i, j);
+    heat_reset(&h, bits, generation);
+    for(size_t k = 0; k < ROWS * COLS; k++)
+        last_flip[k] = generation - HEAT_SPAN;
+    for(size_t k = 0; k < sizeof(tile_flip) / sizeof(tile_flip[0]); k++)
+        tile_flip[k] = generation - HEAT_SPAN;
+
+    for(int round = 0; round < ROUNDS; round++) {
+        generation += 1 + rand() % 3;
+
+        // some cells flip twice and end where they started, those keep their stamp
+        size_t i = rand() % ROWS, j = rand() % COLS;
+        for(int f = 0; f < 30; f++) {
+            size_t di = rand() % 5, dj = rand() % 5;
+            if(i + di >= ROWS || j + dj >= COLS)
+                continue;
+            flip(i + di, j + dj);
+        }
+        for(size_t ti = i; ti < i + 5 && ti < ROWS; ti++)
+            for(size_t tj = j; tj < j + 5 && tj < COLS; tj++) {
+                size_t k = ti * COLS + tj;
+                if(((bits[k / 64] ^ h.bits[k / 64]) >> (k % 64)) & 1) {
+                    last_flip[k] = generation;
+                    tile_flip[(ti / TILE) * TILES_X + tj / TILE] = generation;
+                }
+            }
+
+        // update every tile the cells touched, whole tiles like the view does
+        for(size_t ty = i / TILE; ty <= (i + 4) / TILE && ty * TILE < ROWS; ty++)
+            for(size_t tx = j / TILE; tx <= (j + 4) / TILE && tx * TILE < COLS; tx++)
+                heat_update_block(&h, bits, ty * TILE, ty * TILE + TILE < ROWS ? ty * TILE + TILE : ROWS,
+                    tx * TILE, tx * TILE + TILE < COLS ? tx * TILE + TILE : COLS, generation);
+        heat_cool(&h, generation);
+
+        size_t warm = 0;
+        for(size_t t = 0; t < sizeof(tile_flip) / sizeof(tile_flip[0]); t++)
+            warm += generation - tile_flip[t] < HEAT_SPAN;
+        wrong += warm != h.warm_count;
+        for(size_t k = 0; k < h.warm_count; k++)
+            wrong += generation - tile_flip[h.warm[k]] >= HEAT_SPAN;
+
+        // a random span of a random row, from every alignment
+        size_t row = rand() % ROWS, col = rand() % COLS, count = rand() % (COLS - col + 1);
+        heat_span(&h, span, row, col, count, generation);
+        for(size_t n = 0; n < count; n++)
+            wrong += span[n] != heat_color(&h, row, col + n, generation);
+    }
+
+    wrong += memcmp(h.stamps, last_flip, sizeof(last_flip)) != 0;
+    wrong += memcmp(h.bits, bits, (ROWS * COLS + 63) / 64 * sizeof(uint64_t)) != 0;
+
+    // both ends of both ramps are the palette colors exactly
+    size_t k = 0;
+    while(!((bits[k / 64] >> (k % 64)) & 1))
+        k++;
+    h.stamps[k] = generation;
+    wrong += heat_color(&h, k / COLS, k % COLS, generation) != palette.young;
+    wrong += heat_color(&h, k / COLS, k % COLS, generation + HEAT_SPAN + 7) != palette.old;
+    while((bits[k / 64] >> (k % 64)) & 1)
+        k++;
+    h.stamps[k] = generation;
+    wrong += heat_color(&h, k / COLS, k % COLS, generation) != palette.died;
+    wrong += heat_color(&h, k / COLS, k % COLS, generation + HEAT_SPAN) != palette.faded;
+
+    printf("%dx%d board, %d rounds, %lu warm tiles at the end, %lu wrong\n", ROWS, COLS, ROUNDS,
+        (unsigned long) h.warm_count, (unsigned long) wrong);
+    heat_destroy(&h);
+    return wrong != 0;
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lenia_sim.h"
+
+// Skipping empty tiles has to give exactly the dense step. The board is not
+// a multiple of the tile in either direction, so the last tile column and
+// row are partial, and the seeds sit right against the torus seams where
+// the neighborhood wraps into them.
+
+#define WIDTH 336   /* 10.5 tiles */
+#define HEIGHT 90   /* 2.8 tiles */
+#define STEPS 8
+#define SIDE 12
+
+// one seed per run, so no other seed's activity covers for a missed tile
+const size_t corners[4][2] = {
+    { 0, 40 },                      // against the left seam
+    { WIDTH - SIDE, 10 },           // the right seam, in the partial tile column
+    { 150, 0 },                     // the top seam
+    { 200, HEIGHT - SIDE }          // the bottom seam, in the partial tile row
+};
+
+void seed(lenia_sim* sim, size_t k) {
+    field_clear(&sim->state);
+    for(size_t y = 0; y < SIDE; y++)
+        for(size_t x = 0; x < SIDE; x++)
+            field_set(&sim->state, corners[k][0] + x, corners[k][1] + y, 1.0f);
+    lenia_refresh_tiles(sim);
+}
+
+int main(void) {
+    size_t wrong = 0;
+    lenia_params params = { 31, 0.05f, 0.03f, 0.1f };
+    lenia_sim tiled, dense;
+
+    if(lenia_init(&tiled, WIDTH, HEIGHT, FIELD_F32, params) != LENIA_OK
+        || lenia_init(&dense, WIDTH, HEIGHT, FIELD_F32, params) != LENIA_OK)
+        return 1;
+    wrong += lenia_set_tiling(&tiled, 32, 0.0f) != LENIA_OK;
+    wrong += lenia_set_tiling(&dense, 0, 0.0f) != LENIA_OK;
+
+    size_t active = 0;
+    for(size_t k = 0; k < 4; k++) {
+        seed(&tiled, k);
+        seed(&dense, k);
+        for(size_t s = 0; s < STEPS; s++) {
+            lenia_step(&tiled);
+            lenia_step(&dense);
+            active += tiled.active_tiles;
+            for(size_t y = 0; y < HEIGHT; y++)
+                for(size_t x = 0; x < WIDTH; x++)
+                    wrong += field_get(&tiled.state, x, y) != field_get(&dense.state, x, y);
+        }
+    }
+    // the seeds reach most but not all of the board, so tiles were skipped
+    wrong += active == 4 * STEPS * tiled.tiles_x * tiled.tiles_y;
+
+    printf("%dx%d board, %zu of %zu tiles convolved, %lu wrong\n", WIDTH, HEIGHT, active,
+        4 * STEPS * tiled.tiles_x * tiled.tiles_y, (unsigned long) wrong);
+    lenia_destroy(&tiled);
+    lenia_destroy(&dense);
+    return wrong != 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macrocell.h"
+
+// A board made of one tile repeated has to become a handful of shared nodes
+// and be written that way, read back to the same cells, bounds and node
+// count. A file that repeats a subtree has to load it once, and a window
+// has to only see the leaves under it.
+
+#define SIDE 1000
+#define PERIOD 64
+#define GLIDERS ((SIDE - 4) / PERIOD + 1)  /* per side */
+
+static unsigned char grid[SIDE][SIDE];      // [y][x]
+static unsigned char read_back[SIDE][SIDE];
+static uint64_t leaves;
+
+uint64_t grid_tile(void* ctx, uint64_t x, uint64_t y) {
+    (void) ctx;
+    uint64_t bits = 0;
+    for(uint64_t dx = 0; dx < 8 && x + dx < SIDE; dx++)
+        for(uint64_t dy = 0; dy < 8 && y + dy < SIDE; dy++)
+            bits |= (uint64_t) grid[y + dy][x + dx] << (8 * dx + dy);
+    return bits;
+}
+
+void mark_leaf(void* ctx, uint64_t x, uint64_t y, uint64_t bits) {
+    (void) ctx;
+    leaves++;
+    for(uint64_t dx = 0; dx < 8; dx++)
+        for(uint64_t dy = 0; dy < 8; dy++)
+            if(bits >> (8 * dx + dy) & 1 && x + dx < SIDE && y + dy < SIDE)
+                read_back[y + dy][x + dx] = 1;
+}
+
+void write_file(const char* path, const char* text) {
+    FILE* fp = fopen(path, "wb");
+    fputs(text, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    size_t wrong = 0;
+    mc_tree t, u;
+
+    // a glider every PERIOD cells, off the tile grid so it spans four leaves
+    const char* glider[3] = { ".*.", "..*", "***" };
+    for(size_t y = 0; y + 3 < SIDE; y += PERIOD)
+        for(size_t x = 0; x + 3 < SIDE; x += PERIOD)
+            for(size_t dy = 0; dy < 3; dy++)
+                for(size_t dx = 0; dx < 3; dx++)
+                    grid[y + dy + 6][x + dx + 6] = glider[dy][dx] == '*';
+    grid[SIDE - 1][SIDE - 1] = 1;
+
+    if(mc_init(&t) != MC_OK || mc_init(&u) != MC_OK)
+        return 1;
+    mc_build(&t, SIDE, SIDE, grid_tile, NULL);
+    wrong += t.root_level != 10 || t.nodes[t.root].population != GLIDERS * GLIDERS * 5 + 1;
+    uint32_t built_nodes = t.count;
+    t.generation = 1234;
+    wrong += mc_write(&t, "test_macrocell.mc") != MC_OK;
+
+    wrong += mc_read(&u, "test_macrocell.mc") != MC_OK;
+    wrong += u.count != built_nodes || u.root_level != 10 || u.generation != 1234 || strcmp(u.rule, "B3/S23") != 0;
+    mc_for_each_leaf(&u, 0, 0, SIDE, SIDE, mark_leaf, NULL);
+    wrong += memcmp(grid, read_back, sizeof(grid)) != 0;
+
+    uint64_t x0, y0, x1, y1;
+    wrong += !mc_bounds(&u, &x0, &y0, &x1, &y1) || x0 != 6 || y0 != 6 || x1 != SIDE || y1 != SIDE;
+
+    // only the leaves under the first glider, which straddles four
+    leaves = 0;
+    mc_for_each_leaf(&u, 6, 6, 3, 3, mark_leaf, NULL);
+    wrong += leaves != 4;
+
+    // the same leaf twice and a node using both copies: one leaf, and a
+    // block in all four corners of a 16x16 square
+    write_file("test_macrocell.mc",
+        "[M2] (hand written)\n#R B3/S23\n$$$$$$.**$.**$\n$$$$$$.**$.**$\n4 1 2 1 2\n");
+    wrong += mc_read(&u, "test_macrocell.mc") != MC_OK || u.count != 3 || u.root_level != 4;
+    wrong += !mc_bounds(&u, &x0, &y0, &x1, &y1) || x0 != 1 || y0 != 6 || x1 != 11 || y1 != 16;
+    wrong += u.nodes[u.root].population != 16;
+
+    // a child that isn't one level down, a multi-state leaf, no header
+    write_file("test_macrocell.mc", "[M2]\n.*$\n5 1 0 0 0\n");
+    wrong += mc_read(&u, "test_macrocell.mc") != MC_FORMAT_ERROR;
+    write_file("test_macrocell.mc", "[M2]\n1 0 1 0 1\n");
+    wrong += mc_read(&u, "test_macrocell.mc") != MC_FORMAT_ERROR;
+    write_file("test_macrocell.mc", ".*$\n");
+    wrong += mc_read(&u, "test_macrocell.mc") != MC_FORMAT_ERROR;
+    wrong += mc_read(&u, "no_such_file.mc") != MC_FILE_ERROR;
+    remove("test_macrocell.mc");
+
+    printf("%dx%d board of %d gliders: %lu nodes, %lu wrong\n", SIDE, SIDE, GLIDERS * GLIDERS,
+        (unsigned long) built_nodes - 1, (unsigned long) wrong);
+    mc_destroy(&t);
+    mc_destroy(&u);
+    return wrong != 0;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "ring.h"
+
+// Producers push (id << 32 | seq) in batches of varying size through a small
+// ring while consumers drain it; every value has to come out exactly once.
+
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define PER_PRODUCER 1000000
+#define CAPACITY 1024
+
+Ring ring;
+unsigned char seen[PRODUCERS][PER_PRODUCER];
+uint64_t consumed = 0;
+int failed = 0;
+
+void* produce(void* arg) {
+    uint64_t id = (uint64_t) (uintptr_t) arg;
+    uint64_t batch[64];
+    uint64_t seq = 0, rng = id + 1;
+
+    while(seq < PER_PRODUCER) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        uint64_t want = 1 + rng % 64;
+        if(want > PER_PRODUCER - seq)
+            want = PER_PRODUCER - seq;
+
+        for(uint64_t k = 0; k < want; k++)
+            batch[k] = id << 32 | (seq + k);
+
+        uint64_t n = ring_push_n(&ring, batch, want);
+        if(n == 0)
+            sched_yield();
+        seq += n;
+    }
+    return NULL;
+}
+
+void* consume(void* arg) {
+    (void) arg;
+    uint64_t batch[64];
+
+    while(__atomic_load_n(&consumed, __ATOMIC_RELAXED) < (uint64_t) PRODUCERS * PER_PRODUCER) {
+        uint64_t n = ring_pop_n(&ring, batch, 64);
+        if(n == 0)
+            sched_yield();
+        for(uint64_t k = 0; k < n; k++) {
+            uint64_t id = batch[k] >> 32, seq = batch[k] & 0xFFFFFFFF;
+            if(id >= PRODUCERS || seq >= PER_PRODUCER || __atomic_exchange_n(&seen[id][seq], 1, __ATOMIC_RELAXED)) {
+                __atomic_store_n(&failed, 1, __ATOMIC_RELAXED);
+                fprintf(stderr, "bad or duplicate value %lx\n", (unsigned long) batch[k]);
+            }
+        }
+        __atomic_fetch_add(&consumed, n, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+
+    if(ring_init(&ring, CAPACITY) != RING_OK)
+        return 1;
+
+    for(uintptr_t i = 0; i < CONSUMERS; i++)
+        pthread_create(&consumers[i], NULL, consume, NULL);
+    for(uintptr_t i = 0; i < PRODUCERS; i++)
+        pthread_create(&producers[i], NULL, produce, (void*) i);
+
+    for(int i = 0; i < PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+    for(int i = 0; i < CONSUMERS; i++)
+        pthread_join(consumers[i], NULL);
+
+    for(int p = 0; p < PRODUCERS; p++)
+        for(int s = 0; s < PER_PRODUCER; s++)
+            if(!seen[p][s]) {
+                fprintf(stderr, "lost value %d:%d\n", p, s);
+                failed = 1;
+            }
+
+    if(ring_size(&ring) != 0)
+        failed = 1;
+
+    ring_destroy(&ring);
+    printf("%s: %lu values through %d producers / %d consumers\n", failed ? "FAIL" : "ok",
+        (unsigned long) consumed, PRODUCERS, CONSUMERS);
+    return failed;
+}
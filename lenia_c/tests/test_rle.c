@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rle.h"
+
+// A hand written file with comments, multi-digit counts, skipped rows and
+// runs split across tokens has to read as the cells it describes, a random
+// board written out has to read back cell for cell in lines no longer than
+// RLE_LINE_MAX, and broken files have to say so.
+
+#define WIDTH 1500
+#define HEIGHT 700
+
+static unsigned char grid[HEIGHT][WIDTH];
+static unsigned char read_back[HEIGHT][WIDTH];
+static uint64_t runs;
+
+bool mark_run(void* ctx, uint64_t x, uint64_t y, uint64_t count) {
+    (void) ctx;
+    runs++;
+    if(y >= HEIGHT || x + count > WIDTH)
+        return false;
+    memset(&read_back[y][x], 1, count);
+    return true;
+}
+
+bool grid_row(void* ctx, uint64_t y, uint64_t* bits) {
+    (void) ctx;
+    for(uint64_t x = 0; x < WIDTH; x++)
+        bits[x / 64] |= (uint64_t) grid[y][x] << (x % 64);
+    return true;
+}
+
+bool stop_at_third(void* ctx, uint64_t x, uint64_t y, uint64_t count) {
+    (void) x, (void) y, (void) count;
+    return ++*(int*) ctx < 3;
+}
+
+void write_file(const char* path, const char* text) {
+    FILE* fp = fopen(path, "wb");
+    fputs(text, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    size_t wrong = 0;
+    rle_reader r;
+
+    write_file("test_rle_hand.rle",
+        "#N hand written\n#C 2o3o is one run\n"
+        "x = 12, y = 5, rule = B3/S23\n"
+        "2o3o$3b2o\n2$o2bo5bo$10b2o!\nnot read\n");
+    memset(read_back, 0, sizeof(read_back));
+    runs = 0;
+    wrong += rle_open(&r, "test_rle_hand.rle") != RLE_OK;
+    wrong += r.width != 12 || r.height != 5 || strcmp(r.rule, "B3/S23") != 0;
+    wrong += rle_read_runs(&r, mark_run, NULL) != RLE_OK;
+    wrong += runs != 6 || r.cells != 12;
+    const char* expect[5] = { "ooooo", "...oo", "", "o..o.....o", "..........oo" };
+    for(size_t y = 0; y < 5; y++)
+        for(size_t x = 0; x < 12; x++)
+            wrong += read_back[y][x] != (x < strlen(expect[y]) && expect[y][x] == 'o');
+    rle_close(&r);
+
+    // the callback can stop the read
+    int seen = 0;
+    rle_open(&r, "test_rle_hand.rle");
+    wrong += rle_read_runs(&r, stop_at_third, &seen) != RLE_STOPPED || seen != 3;
+    rle_close(&r);
+
+    write_file("test_rle_hand.rle", "x = 3, y = 2\n3o$o?o!\n");
+    wrong += rle_open(&r, "test_rle_hand.rle") != RLE_OK || r.rule[0] != '\0';
+    wrong += rle_read_runs(&r, mark_run, NULL) != RLE_FORMAT_ERROR;
+    rle_close(&r);
+    write_file("test_rle_hand.rle", "x = , y = 2\n3o!\n");
+    wrong += rle_open(&r, "test_rle_hand.rle") != RLE_FORMAT_ERROR;
+    wrong += rle_open(&r, "no_such_file.rle") != RLE_FILE_ERROR;
+    remove("test_rle_hand.rle");
+
+    // blobs and empty bands, so there are long runs, short runs and skipped rows
+    for(size_t y = 0; y < HEIGHT; y++)
+        for(size_t x = 0; x < WIDTH; x++)
+            grid[y][x] = (y / 50) % 3 != 1 && (rand() % 3 == 0 || (x / 40 + y / 30) % 4 == 0);
+    wrong += rle_write("test_rle_board.rle", WIDTH, HEIGHT, "B3/S23", grid_row, NULL) != RLE_OK;
+
+    FILE* fp = fopen("test_rle_board.rle", "rb");
+    char line[256];
+    size_t bytes = 0;
+    while(fp && fgets(line, sizeof(line), fp)) {
+        bytes += strlen(line);
+        wrong += line[0] != 'x' && strlen(line) > RLE_LINE_MAX + 1;
+    }
+    if(fp)
+        fclose(fp);
+
+    memset(read_back, 0, sizeof(read_back));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    wrong += rle_open(&r, "test_rle_board.rle") != RLE_OK || r.width != WIDTH || r.height != HEIGHT;
+    wrong += rle_read_runs(&r, mark_run, NULL) != RLE_OK;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rle_close(&r);
+    wrong += memcmp(grid, read_back, sizeof(grid)) != 0;
+    remove("test_rle_board.rle");
+
+    printf("%dx%d board, %zu byte file read in %.2f ms, %lu wrong\n", WIDTH, HEIGHT, bytes,
+        (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6, (unsigned long) wrong);
+    return wrong != 0;
+}
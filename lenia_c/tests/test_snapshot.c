@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "snapshot.h"
+
+// The writer flips random cells of its board, marks them and publishes as
+// fast as it can while the reader keeps acquiring. Every snapshot has to
+// hash to what the writer's board was at that generation (only the marked
+// tiles are copied into a slot, so this checks nothing was missed or torn),
+// generations must never go back, and a reader copying only the tiles each
+// snapshot lists as changed has to end up with the same board.
+
+#define GENERATIONS 200000
+#define ROWS 100
+#define ROW_CELLS 77
+#define SHIFT 3
+
+snapshot_buffer snapshots;
+uint64_t board[(ROWS * ROW_CELLS + 63) / 64];
+uint64_t hashes[GENERATIONS + 1];
+
+uint64_t hash(const uint64_t* bits, uint64_t words) {
+    uint64_t h = 1469598103934665603ull;
+    for(uint64_t w = 0; w < words; w++)
+        h = (h ^ bits[w]) * 1099511628211ull;
+    return h;
+}
+
+void* write_snapshots(void* arg) {
+    (void) arg;
+    uint64_t rng = 88172645463325252ull;
+    for(uint64_t g = 1; g <= GENERATIONS; g++) {
+        for(int f = 0; f < 5; f++) {
+            rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+            uint64_t i = rng % ROWS, j = (rng >> 32) % ROW_CELLS, k = i * ROW_CELLS + j;
+            board[k / 64] ^= (uint64_t) 1 << (k % 64);
+            snapshot_mark(&snapshots, i, j);
+        }
+        hashes[g] = hash(board, snapshots.words);
+        snapshot_publish(&snapshots, board, g);
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t writer;
+    static uint64_t followed[(ROWS * ROW_CELLS + 63) / 64];
+    uint64_t last = 0, fresh_count = 0;
+    int failed = 0;
+
+    if(snapshot_init(&snapshots, ROWS, ROW_CELLS, SHIFT) != SNAPSHOT_OK)
+        return 1;
+
+    pthread_create(&writer, NULL, write_snapshots, NULL);
+
+    while(last < GENERATIONS && !failed) {
+        bool fresh;
+        const board_snapshot* s = snapshot_acquire(&snapshots, &fresh);
+        if(!fresh) {
+            sched_yield();
+            continue;
+        }
+        fresh_count++;
+
+        if(s->generation <= last) {
+            fprintf(stderr, "generation went from %lu to %lu\n", (unsigned long) last, (unsigned long) s->generation);
+            failed = 1;
+        }
+        if(hash(s->bits, snapshots.words) != hashes[s->generation]) {
+            fprintf(stderr, "snapshot of generation %lu doesn't match the board\n", (unsigned long) s->generation);
+            failed = 1;
+        }
+
+        for(uint64_t i = 0; i < ROWS; i++) {
+            for(uint64_t j = 0; j < ROW_CELLS; j++) {
+                if(snapshot_tile_changed(&snapshots, s, i >> SHIFT, j >> SHIFT)) {
+                    uint64_t k = i * ROW_CELLS + j, bit = (uint64_t) 1 << (k % 64);
+                    followed[k / 64] = (followed[k / 64] & ~bit) | (s->bits[k / 64] & bit);
+                }
+            }
+        }
+        if(memcmp(followed, s->bits, snapshots.words * sizeof(uint64_t)) != 0) {
+            fprintf(stderr, "changed tiles of generation %lu miss a change\n", (unsigned long) s->generation);
+            failed = 1;
+        }
+        last = s->generation;
+    }
+    pthread_join(writer, NULL);
+
+    snapshot_destroy(&snapshots);
+    printf("%s: %lu of %d generations seen, last %lu\n", failed ? "FAIL" : "ok",
+        (unsigned long) fresh_count, GENERATIONS, (unsigned long) last);
+    return failed;
+}
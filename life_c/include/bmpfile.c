@@ -44,6 +44,8 @@
 #define DEFAULT_DPI_Y 3780
 #define DPI_FACTOR 39.37007874015748
 
+#define STREAM_BUFFER_SIZE (1 << 20)    /* stdio buffer for bmp_save_rows */
+
 typedef struct {
   uint32_t filesz;    /* the size of the BMP file in bytes */
   uint16_t creator1;  /* reserved. */
@@ -742,3 +744,89 @@ bmp_save(bmpfile_t *bmp, const char *filename)
 
   return TRUE;
 }
+
+typedef struct {
+  const uint8_t *const *rows;
+  size_t bytes;
+} bmp_row_pointers_t;
+
+static bool
+bmp_copy_row(void *ctx, uint32_t y, uint8_t *row)
+{
+  bmp_row_pointers_t *src = ctx;
+
+  memcpy(row, src->rows[y], src->bytes);
+  return TRUE;
+}
+
+bool
+bmp_save_rows(const char *filename, uint32_t width, uint32_t height,
+	      uint32_t depth, bmp_row_source_t source, void *ctx)
+{
+  bmpfile_t bmp;
+  rgb_pixel_t colors[256];
+  FILE *fp;
+  size_t bytes_per_line;
+  uint32_t row;
+  unsigned char *buf;
+  bool ok = TRUE;
+
+  if (depth != 1 && depth != 8)
+    return FALSE;
+
+  memset(&bmp, 0, sizeof(bmpfile_t));
+  bmp.magic[0] = 'B';
+  bmp.magic[1] = 'M';
+  bmp.dib.header_sz = 40;
+  bmp.dib.width = width;
+  bmp.dib.height = height;
+  bmp.dib.nplanes = 1;
+  bmp.dib.depth = depth;
+  bmp.dib.hres = DEFAULT_DPI_X;
+  bmp.dib.vres = DEFAULT_DPI_Y;
+  bmp.dib.compress_type = BI_RGB;
+  bmp.dib.ncolors = uint32_pow(2, depth);
+  bmp.colors = colors;
+  bmp_create_grayscale_color_table(&bmp);
+
+  bytes_per_line = ((size_t)width * depth + 31) / 32 * 4;
+  bmp.dib.bmp_bytesz = (uint32_t)(bytes_per_line * height);
+  bmp.header.offset = 14 + bmp.dib.header_sz + bmp.dib.ncolors * 4;
+  bmp.header.filesz = bmp.header.offset + bmp.dib.bmp_bytesz;
+
+  /* sources only fill (width * depth + 7) / 8 bytes, the padding stays zero */
+  if ((buf = calloc(bytes_per_line + 1, 1)) == NULL)
+    return FALSE;
+  if ((fp = fopen(filename, "wb")) == NULL) {
+    free(buf);
+    return FALSE;
+  }
+  setvbuf(fp, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+  bmp_write_header(&bmp, fp);
+  bmp_write_dib(&bmp, fp);
+  fwrite(colors, sizeof(rgb_pixel_t), bmp.dib.ncolors, fp);
+
+  for (row = height; ok && row-- > 0;) {
+    ok = source(ctx, row, buf);
+    if (ok)
+      ok = fwrite(buf, bytes_per_line, 1, fp) == 1;
+  }
+
+  free(buf);
+  if (fclose(fp) != 0)
+    ok = FALSE;
+  if (!ok)
+    remove(filename);
+
+  return ok;
+}
+
+bool
+bmp_save_row_pointers(const char *filename, uint32_t width, uint32_t height,
+		      uint32_t depth, const uint8_t *const *rows)
+{
+  bmp_row_pointers_t src = { rows, ((size_t)width * depth + 7) / 8 };
+
+  return bmp_save_rows(filename, width, height, depth, bmp_copy_row, &src);
+}
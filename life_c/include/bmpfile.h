@@ -37,8 +37,15 @@
 
 BMP_BEGIN_DECLS
 
-#ifndef bool
+/* the real bool wherever there is one, row sources are called through it */
+#if defined(__cplusplus)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#include <stdbool.h>
+#elif !defined(bool)
 typedef int bool;
+#endif
+
+#ifndef TRUE
 #define FALSE (0)
 #define TRUE !FALSE
 #endif
@@ -94,6 +101,25 @@ bool bmp_set_pixel(bmpfile_t *bmp, uint32_t x, uint32_t y, rgb_pixel_t pixel);
 
 bool bmp_save(bmpfile_t *bmp, const char *filename);
 
+/*
+ * Streaming writer, for images too big to hold as rgb_pixel_t. The caller
+ * fills one row at a time in file format and nothing larger than a row is
+ * ever allocated. Depth 1 is one bit per pixel, the leftmost pixel in the
+ * high bit of the first byte, 0 black and 1 white. Depth 8 is one grey
+ * level per pixel. Row y = 0 is the top of the image, the same as for
+ * bmp_set_pixel, but rows are asked for bottom first, the order BMP stores
+ * them in. The source returns FALSE to abandon the file.
+ */
+typedef bool (*bmp_row_source_t)(void *ctx, uint32_t y, uint8_t *row);
+
+bool bmp_save_rows(const char *filename, uint32_t width, uint32_t height,
+		   uint32_t depth, bmp_row_source_t source, void *ctx);
+
+/* Same, with rows[y] pointing at each row's (width * depth + 7) / 8 bytes */
+bool bmp_save_row_pointers(const char *filename, uint32_t width,
+			   uint32_t height, uint32_t depth,
+			   const uint8_t *const *rows);
+
 BMP_END_DECLS
 
 #endif /* __bmpfile_h__ */
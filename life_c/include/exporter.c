@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "exporter.h"
+#include "bmpfile.h"
+
+/* PRIVATE FUNCTIONS */
+static void* __write_jobs(void* arg);
+static bool __job_row(void* ctx, uint32_t y, uint8_t* row);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int exporter_start(exporter* e, size_t capacity) {
+    e->capacity = capacity ? capacity : 1;
+    e->head = 0;
+    e->count = 0;
+    e->stopping = false;
+    e->written = 0;
+    e->failed = 0;
+    e->dropped = 0;
+    e->jobs = malloc(e->capacity * sizeof(export_job));
+    if(e->jobs == NULL)
+        return EXPORTER_MALLOC_ERROR;
+
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->not_empty, NULL);
+    pthread_cond_init(&e->not_full, NULL);
+    if(pthread_create(&e->thread, NULL, __write_jobs, e) != 0) {
+        pthread_cond_destroy(&e->not_full);
+        pthread_cond_destroy(&e->not_empty);
+        pthread_mutex_destroy(&e->lock);
+        free(e->jobs);
+        e->jobs = NULL;
+        return EXPORTER_THREAD_ERROR;
+    }
+    return EXPORTER_OK;
+}
+
+int exporter_submit(exporter* e, const export_job* job, bool wait) {
+    pthread_mutex_lock(&e->lock);
+    while(wait && e->count == e->capacity)
+        pthread_cond_wait(&e->not_full, &e->lock);
+
+    if(e->count == e->capacity) {
+        e->dropped++;
+        pthread_mutex_unlock(&e->lock);
+        free(job->data);
+        return EXPORTER_FULL;
+    }
+
+    e->jobs[(e->head + e->count) % e->capacity] = *job;
+    e->jobs[(e->head + e->count) % e->capacity].path[EXPORTER_PATH_MAX - 1] = '\0';
+    e->count++;
+    pthread_cond_signal(&e->not_empty);
+    pthread_mutex_unlock(&e->lock);
+    return EXPORTER_OK;
+}
+
+void exporter_stop(exporter* e) {
+    if(e->jobs == NULL)
+        return;
+
+    pthread_mutex_lock(&e->lock);
+    e->stopping = true;
+    pthread_cond_signal(&e->not_empty);
+    pthread_mutex_unlock(&e->lock);
+    pthread_join(e->thread, NULL);
+
+    pthread_cond_destroy(&e->not_full);
+    pthread_cond_destroy(&e->not_empty);
+    pthread_mutex_destroy(&e->lock);
+    free(e->jobs);
+    e->jobs = NULL;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+
+// the writer: one job at a time, the lock is only held to take it off the queue
+static void* __write_jobs(void* arg) {
+    exporter* e = (exporter*) arg;
+
+    while(true) {
+        pthread_mutex_lock(&e->lock);
+        while(e->count == 0 && !e->stopping)
+            pthread_cond_wait(&e->not_empty, &e->lock);
+        if(e->count == 0) {
+            pthread_mutex_unlock(&e->lock);
+            return NULL;
+        }
+        export_job job = e->jobs[e->head];
+        e->head = (e->head + 1) % e->capacity;
+        e->count--;
+        pthread_cond_signal(&e->not_full);
+        pthread_mutex_unlock(&e->lock);
+
+        bool ok = bmp_save_rows(job.path, job.width, job.height, job.depth, __job_row, &job);
+        free(job.data);
+
+        pthread_mutex_lock(&e->lock);
+        if(ok)
+            e->written++;
+        else
+            e->failed++;
+        pthread_mutex_unlock(&e->lock);
+    }
+}
+
+static bool __job_row(void* ctx, uint32_t y, uint8_t* row) {
+    const export_job* job = (const export_job*) ctx;
+    size_t bytes = ((size_t) job->width * job->depth + 7) / 8;
+    memcpy(row, job->data + y * bytes, bytes);
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+// Snapshot export off the simulation's thread. The caller copies the board
+// into a packed image (which costs a memcpy, not a disk write) and submits
+// it. A writer thread then saves the queued images as BMPs in order. The
+// queue is bounded, so a writer that falls behind costs at most capacity
+// images of memory. Once it is full, each submit either drops the image or
+// waits for room, whichever the caller asks for.
+//
+//     exporter e;
+//     exporter_start(&e, 4);
+//     export_job job = { .data = data, .width = w, .height = h, .depth = 1 };   // malloc'd, rows top first
+//     snprintf(job.path, EXPORTER_PATH_MAX, "board_%lu.bmp", generation);
+//     exporter_submit(&e, &job, false);              // never blocks
+//     exporter_stop(&e);                             // writes what is queued, then joins
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define EXPORTER_PATH_MAX 256
+
+#define EXPORTER_OK 0
+#define EXPORTER_FULL 1
+#define EXPORTER_MALLOC_ERROR -2
+#define EXPORTER_THREAD_ERROR -3
+
+typedef struct {
+    uint8_t* data;          // height rows of (width * depth + 7) / 8 bytes, bmp_save_rows format
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;         // 1 or 8
+    char path[EXPORTER_PATH_MAX];
+} export_job;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    export_job* jobs;       // capacity slots, count queued from head on
+    size_t capacity;
+    size_t head;
+    size_t count;
+    bool stopping;
+    uint64_t written;
+    uint64_t failed;
+    uint64_t dropped;
+} exporter;
+
+/*  Start the writer thread with room for capacity queued images
+
+    Returns:
+        EXPORTER_OK on success
+        EXPORTER_MALLOC_ERROR if the queue could not be allocated
+        EXPORTER_THREAD_ERROR if the thread could not be started
+*/
+int exporter_start(exporter* e, size_t capacity);
+
+/*  Queue job->data to be written to job->path. The exporter owns data from
+    here on in every case and frees it once written or dropped. With the
+    queue full, wait blocks until the writer makes room, otherwise the image
+    is dropped.
+
+    Returns:
+        EXPORTER_OK if queued
+        EXPORTER_FULL if dropped
+*/
+int exporter_submit(exporter* e, const export_job* job, bool wait);
+
+/* Write everything still queued, stop the thread and free the queue */
+void exporter_stop(exporter* e);
+
+#endif
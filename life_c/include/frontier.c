@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "frontier.h"
+
+/* PRIVATE FUNCTIONS */
+static int __claim_atomic(Frontier *f, uint64_t index);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int frontier_init(Frontier *f, uint64_t number_cells) {
+    uint64_t words = (number_cells + 63) / 64;
+    f->bits = (uint64_t*) calloc(words ? words : 1, sizeof(uint64_t));
+    f->list = (uint64_t*) malloc((number_cells ? number_cells : 1) * sizeof(uint64_t));
+    if (f->bits == NULL || f->list == NULL) {
+        free(f->bits);
+        free(f->list);
+        f->bits = NULL;
+        f->list = NULL;
+        return SET_MALLOC_ERROR;
+    }
+    f->length = 0;
+    f->number_cells = number_cells;
+    f->local = NULL;
+    f->threads = 0;
+    return SET_TRUE;
+}
+
+int frontier_init_local(Frontier *f, int threads) {
+    int t;
+    for (t = 0; t < f->threads; ++t)
+        free(f->local[t].items);
+    free(f->local);
+
+    f->threads = 0;
+    f->local = (frontier_local*) calloc(threads, sizeof(frontier_local));
+    if (f->local == NULL)
+        return SET_MALLOC_ERROR;
+    f->threads = threads;
+    return SET_TRUE;
+}
+
+int frontier_destroy(Frontier *f) {
+    int t;
+    for (t = 0; t < f->threads; ++t)
+        free(f->local[t].items);
+    free(f->local);
+    f->local = NULL;
+    f->threads = 0;
+    free(f->bits);
+    free(f->list);
+    f->bits = NULL;
+    f->list = NULL;
+    f->length = 0;
+    f->number_cells = 0;
+    return SET_TRUE;
+}
+
+int frontier_clear(Frontier *f) {
+    uint64_t i;
+    // past one index per word a plain memset is cheaper than chasing the list
+    if (f->length > f->number_cells / 64) {
+        memset(f->bits, 0, (f->number_cells + 63) / 64 * sizeof(uint64_t));
+    } else {
+        for (i = 0; i < f->length; ++i)
+            f->bits[f->list[i] >> 6] = 0;
+    }
+    f->length = 0;
+    int t;
+    for (t = 0; t < f->threads; ++t)
+        f->local[t].length = 0;
+    return SET_TRUE;
+}
+
+int frontier_add(Frontier *f, uint64_t index) {
+    uint64_t mask = (uint64_t) 1 << (index & 63);
+    uint64_t *word = &f->bits[index >> 6];
+    if (*word & mask)
+        return SET_ALREADY_PRESENT;
+    *word |= mask;
+    f->list[f->length++] = index;
+    return SET_TRUE;
+}
+
+uint64_t frontier_add_run(Frontier *f, uint64_t first, uint64_t count, uint64_t stride) {
+    uint64_t added = 0, index = first;
+    stride %= f->number_cells ? f->number_cells : 1;
+    for (; count; --count) {
+        uint64_t mask = (uint64_t) 1 << (index & 63);
+        uint64_t *word = &f->bits[index >> 6];
+        if (!(*word & mask)) {
+            *word |= mask;
+            f->list[f->length++] = index;
+            added++;
+        }
+        index += stride;
+        if (index >= f->number_cells)
+            index -= f->number_cells;
+    }
+    return added;
+}
+
+int frontier_add_atomic(Frontier *f, uint64_t index) {
+    if (__claim_atomic(f, index) != SET_TRUE)
+        return SET_ALREADY_PRESENT;
+    f->list[__atomic_fetch_add(&f->length, 1, __ATOMIC_RELAXED)] = index;
+    return SET_TRUE;
+}
+
+int frontier_add_local(Frontier *f, int thread, uint64_t index) {
+    frontier_local *local = &f->local[thread];
+    // grow first so a failed realloc doesn't leave a claimed but unlisted cell
+    if (local->length == local->capacity) {
+        uint64_t capacity = local->capacity ? local->capacity * 2 : 1024;
+        uint64_t *items = (uint64_t*) realloc(local->items, capacity * sizeof(uint64_t));
+        if (items == NULL)
+            return SET_MALLOC_ERROR;
+        local->items = items;
+        local->capacity = capacity;
+    }
+
+    // a single worker has nobody to race with, skip the locked op
+    if (f->threads == 1) {
+        uint64_t mask = (uint64_t) 1 << (index & 63);
+        if (f->bits[index >> 6] & mask)
+            return SET_ALREADY_PRESENT;
+        f->bits[index >> 6] |= mask;
+    } else if (__claim_atomic(f, index) != SET_TRUE) {
+        return SET_ALREADY_PRESENT;
+    }
+    local->items[local->length++] = index;
+    return SET_TRUE;
+}
+
+void frontier_merge(Frontier *f) {
+    int t;
+    uint64_t offset = f->length;
+
+    // exclusive prefix sum over the buffer lengths
+    for (t = 0; t < f->threads; ++t) {
+        f->local[t].start = offset;
+        offset += f->local[t].length;
+    }
+
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (t = 0; t < f->threads; ++t) {
+        memcpy(f->list + f->local[t].start, f->local[t].items, f->local[t].length * sizeof(uint64_t));
+        f->local[t].length = 0;
+    }
+
+    f->length = offset;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static int __claim_atomic(Frontier *f, uint64_t index) {
+    uint64_t mask = (uint64_t) 1 << (index & 63);
+    uint64_t *word = &f->bits[index >> 6];
+    // cheap relaxed read first, most repeat hits never need the locked op
+    if (__atomic_load_n(word, __ATOMIC_RELAXED) & mask)
+        return SET_ALREADY_PRESENT;
+    if (__atomic_fetch_or(word, mask, __ATOMIC_ACQ_REL) & mask)
+        return SET_ALREADY_PRESENT;
+    return SET_TRUE;
+}
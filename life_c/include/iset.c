@@ -0,0 +1,431 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "iset.h"
+
+#define ISET_MAX_FULLNESS_PERCENT 0.5   /* linear probing stays short below half full */
+#define ISET_RADIX_BITS 11              /* 2048 counters stay in L1 */
+#define ISET_RADIX_BUCKETS (1u << ISET_RADIX_BITS)
+
+/* PRIVATE FUNCTIONS */
+static uint64_t __hash(IntSet *set, uint64_t key);
+static uint64_t __next_pow2(uint64_t n);
+static int __get_index(IntSet *set, uint64_t key, uint64_t *index);
+static int __grow(IntSet *set);
+static void __insert_at(IntSet *set, uint64_t key, uint64_t index);
+static void __radix_sort(uint64_t *keys, uint64_t *tmp, uint64_t n);
+static int __merge_into(IntSet *res, IntSet *s1, IntSet *s2,
+    uint64_t (*merge)(const uint64_t*, uint64_t, const uint64_t*, uint64_t, uint64_t*));
+
+#define __USED(set, i) ((set)->slots[i].epoch == (set)->epoch)
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int iset_init_alt(IntSet *set, uint64_t num_els) {
+    num_els = __next_pow2(num_els < 16 ? 16 : num_els);
+    set->slots = (iset_slot*) calloc(num_els, sizeof(iset_slot));
+    if (set->slots == NULL) {
+        return SET_MALLOC_ERROR;
+    }
+    set->number_nodes = num_els;
+    set->used_nodes = 0;
+    set->epoch = 1;
+    return SET_TRUE;
+}
+
+int iset_clear(IntSet *set) {
+    // every slot stamped with an older epoch reads as empty
+    if (++set->epoch == 0) {
+        uint64_t i;
+        for (i = 0; i < set->number_nodes; ++i)
+            set->slots[i].epoch = 0;
+        set->epoch = 1;
+    }
+    set->used_nodes = 0;
+    return SET_TRUE;
+}
+
+int iset_destroy(IntSet *set) {
+    free(set->slots);
+    set->slots = NULL;
+    set->number_nodes = 0;
+    set->used_nodes = 0;
+    return SET_TRUE;
+}
+
+int iset_add(IntSet *set, uint64_t key) {
+    uint64_t index;
+    if (__get_index(set, key, &index) == SET_TRUE)
+        return SET_ALREADY_PRESENT;
+
+    if ((double)(set->used_nodes + 1) > set->number_nodes * ISET_MAX_FULLNESS_PERCENT) {
+        if (__grow(set) != SET_TRUE)
+            return SET_MALLOC_ERROR;
+        __get_index(set, key, &index);
+    }
+    __insert_at(set, key, index);
+    ++set->used_nodes;
+    return SET_TRUE;
+}
+
+int iset_contains(IntSet *set, uint64_t key) {
+    uint64_t index;
+    return __get_index(set, key, &index);
+}
+
+int iset_remove(IntSet *set, uint64_t key) {
+    uint64_t hole, i;
+    if (__get_index(set, key, &hole) != SET_TRUE)
+        return SET_FALSE;
+
+    // backward shift: pull later members of the run into the hole when their
+    // home slot does not lie cyclically in (hole, i]
+    const uint64_t mask = set->number_nodes - 1;
+    i = hole;
+    while (1) {
+        i = (i + 1) & mask;
+        if (!__USED(set, i))
+            break;
+        uint64_t home = __hash(set, set->slots[i].key) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            set->slots[hole].key = set->slots[i].key;
+            hole = i;
+        }
+    }
+    set->slots[hole].epoch = set->epoch - 1;
+    --set->used_nodes;
+    return SET_TRUE;
+}
+
+uint64_t iset_length(IntSet *set) {
+    return set->used_nodes;
+}
+
+uint64_t* iset_to_array(IntSet *set, uint64_t *size) {
+    *size = set->used_nodes;
+    uint64_t* results = (uint64_t*) malloc((set->used_nodes + 1) * sizeof(uint64_t));
+    if (results == NULL)
+        return NULL;
+    uint64_t i, j = 0;
+    for (i = 0; i < set->number_nodes; ++i) {
+        if (__USED(set, i))
+            results[j++] = set->slots[i].key;
+    }
+    return results;
+}
+
+int iset_union(IntSet *res, IntSet *s1, IntSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (__USED(s1, i) && iset_add(res, s1->slots[i].key) == SET_MALLOC_ERROR)
+            return SET_MALLOC_ERROR;
+    }
+    for (i = 0; i < s2->number_nodes; ++i) {
+        if (__USED(s2, i) && iset_add(res, s2->slots[i].key) == SET_MALLOC_ERROR)
+            return SET_MALLOC_ERROR;
+    }
+    return SET_TRUE;
+}
+
+int iset_intersection(IntSet *res, IntSet *s1, IntSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (__USED(s1, i) && iset_contains(s2, s1->slots[i].key) == SET_TRUE) {
+            if (iset_add(res, s1->slots[i].key) == SET_MALLOC_ERROR)
+                return SET_MALLOC_ERROR;
+        }
+    }
+    return SET_TRUE;
+}
+
+int iset_difference(IntSet *res, IntSet *s1, IntSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (__USED(s1, i) && iset_contains(s2, s1->slots[i].key) != SET_TRUE) {
+            if (iset_add(res, s1->slots[i].key) == SET_MALLOC_ERROR)
+                return SET_MALLOC_ERROR;
+        }
+    }
+    return SET_TRUE;
+}
+
+int iset_symmetric_difference(IntSet *res, IntSet *s1, IntSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (__USED(s1, i) && iset_contains(s2, s1->slots[i].key) != SET_TRUE) {
+            if (iset_add(res, s1->slots[i].key) == SET_MALLOC_ERROR)
+                return SET_MALLOC_ERROR;
+        }
+    }
+    for (i = 0; i < s2->number_nodes; ++i) {
+        if (__USED(s2, i) && iset_contains(s1, s2->slots[i].key) != SET_TRUE) {
+            if (iset_add(res, s2->slots[i].key) == SET_MALLOC_ERROR)
+                return SET_MALLOC_ERROR;
+        }
+    }
+    return SET_TRUE;
+}
+
+int iset_is_subset(IntSet *test, IntSet *against) {
+    uint64_t i;
+    for (i = 0; i < test->number_nodes; ++i) {
+        if (__USED(test, i) && iset_contains(against, test->slots[i].key) == SET_FALSE)
+            return SET_FALSE;
+    }
+    return SET_TRUE;
+}
+
+int iset_is_subset_strict(IntSet *test, IntSet *against) {
+    if (test->used_nodes >= against->used_nodes) {
+        return SET_FALSE;
+    }
+    return iset_is_subset(test, against);
+}
+
+uint64_t* iset_to_sorted_array(IntSet *set, uint64_t *size) {
+    uint64_t* results = iset_to_array(set, size);
+    uint64_t* tmp = (uint64_t*) malloc((*size + 1) * sizeof(uint64_t));
+    if (results == NULL || tmp == NULL) {
+        free(results);
+        free(tmp);
+        return NULL;
+    }
+    __radix_sort(results, tmp, *size);
+    free(tmp);
+    return results;
+}
+
+/*  The merges below advance both cursors with compares instead of branches,
+    so the loops compile to conditional moves and never mispredict on how
+    the two inputs interleave. Leftovers are copied in bulk. */
+
+uint64_t iset_merge_union(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out) {
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) {
+        uint64_t x = a[i], y = b[j];
+        out[k++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out + k, a + i, (na - i) * sizeof(uint64_t));
+    k += na - i;
+    memcpy(out + k, b + j, (nb - j) * sizeof(uint64_t));
+    return k + nb - j;
+}
+
+uint64_t iset_merge_intersection(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out) {
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) {
+        uint64_t x = a[i], y = b[j];
+        out[k] = x;         // kept only if the cursor moves past it
+        k += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return k;
+}
+
+uint64_t iset_merge_difference(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out) {
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) {
+        uint64_t x = a[i], y = b[j];
+        out[k] = x;
+        k += x < y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out + k, a + i, (na - i) * sizeof(uint64_t));
+    return k + na - i;
+}
+
+uint64_t iset_merge_symmetric_difference(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out) {
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) {
+        uint64_t x = a[i], y = b[j];
+        out[k] = x < y ? x : y;
+        k += x != y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out + k, a + i, (na - i) * sizeof(uint64_t));
+    k += na - i;
+    memcpy(out + k, b + j, (nb - j) * sizeof(uint64_t));
+    return k + nb - j;
+}
+
+int iset_from_sorted(IntSet *res, const uint64_t *keys, uint64_t n) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    // room for n keys without crossing the fullness iset_add grows at
+    uint64_t need = __next_pow2(n * 2 < 16 ? 16 : n * 2);
+    if (res->number_nodes < need) {
+        iset_slot* slots = (iset_slot*) calloc(need, sizeof(iset_slot));
+        if (slots == NULL)
+            return SET_MALLOC_ERROR;
+        free(res->slots);
+        res->slots = slots;
+        res->number_nodes = need;
+        res->epoch = 1;
+    }
+
+    // ascending keys land in mostly ascending slots, the table fills front to back
+    const uint64_t mask = res->number_nodes - 1;
+    uint64_t k;
+    for (k = 0; k < n; ++k) {
+        uint64_t i = __hash(res, keys[k]) & mask;
+        while (__USED(res, i))
+            i = (i + 1) & mask;
+        __insert_at(res, keys[k], i);
+    }
+    res->used_nodes = n;
+    return SET_TRUE;
+}
+
+int iset_union_sorted(IntSet *res, IntSet *s1, IntSet *s2) {
+    return __merge_into(res, s1, s2, iset_merge_union);
+}
+
+int iset_intersection_sorted(IntSet *res, IntSet *s1, IntSet *s2) {
+    return __merge_into(res, s1, s2, iset_merge_intersection);
+}
+
+int iset_difference_sorted(IntSet *res, IntSet *s1, IntSet *s2) {
+    return __merge_into(res, s1, s2, iset_merge_difference);
+}
+
+int iset_symmetric_difference_sorted(IntSet *res, IntSet *s1, IntSet *s2) {
+    return __merge_into(res, s1, s2, iset_merge_symmetric_difference);
+}
+
+int iset_cmp(IntSet *left, IntSet *right) {
+    if (left->used_nodes < right->used_nodes) {
+        return SET_RIGHT_GREATER;
+    } else if (right->used_nodes < left->used_nodes) {
+        return SET_LEFT_GREATER;
+    }
+    uint64_t i;
+    for (i = 0; i < left->number_nodes; ++i) {
+        if (__USED(left, i) && iset_contains(right, left->slots[i].key) != SET_TRUE)
+            return SET_UNEQUAL;
+    }
+    return SET_EQUAL;
+}
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static uint64_t __hash(IntSet *set, uint64_t key) {
+    // keys are board indices: fold the bits above the table size down so dense
+    // keys keep their order (neighbours probe neighbouring slots) while strided
+    // ones like a single column still spread out
+    const unsigned bits = __builtin_ctzll(set->number_nodes);
+    return key ^ (key >> bits) ^ (key >> 2 * bits);
+}
+
+static uint64_t __next_pow2(uint64_t n) {
+    uint64_t m = 1;
+    while (m < n)
+        m <<= 1;
+    return m;
+}
+
+static int __get_index(IntSet *set, uint64_t key, uint64_t *index) {
+    const uint64_t mask = set->number_nodes - 1;
+    uint64_t i = __hash(set, key) & mask;
+    // the table is never more than half full so an empty slot always ends the probe
+    while (__USED(set, i)) {
+        if (set->slots[i].key == key) {
+            *index = i;
+            return SET_TRUE;
+        }
+        i = (i + 1) & mask;
+    }
+    *index = i;
+    return SET_FALSE;
+}
+
+static void __insert_at(IntSet *set, uint64_t key, uint64_t index) {
+    set->slots[index].key = key;
+    set->slots[index].epoch = set->epoch;
+}
+
+static int __grow(IntSet *set) {
+    IntSet bigger;
+    if (iset_init_alt(&bigger, set->number_nodes * 2) != SET_TRUE)
+        return SET_MALLOC_ERROR;
+
+    uint64_t i, index;
+    for (i = 0; i < set->number_nodes; ++i) {
+        if (__USED(set, i)) {
+            __get_index(&bigger, set->slots[i].key, &index);
+            __insert_at(&bigger, set->slots[i].key, index);
+        }
+    }
+    bigger.used_nodes = set->used_nodes;
+    iset_destroy(set);
+    *set = bigger;
+    return SET_TRUE;
+}
+
+static void __radix_sort(uint64_t *keys, uint64_t *tmp, uint64_t n) {
+    // LSD radix on 11 bit digits, only as many as the widest key needs: board
+    // indices of a 1024x1024 board sort in two passes
+    uint64_t counts[ISET_RADIX_BUCKETS];
+    uint64_t i, all = 0, *src = keys, *dst = tmp;
+    unsigned shift;
+    if (n < 2)
+        return;
+    for (i = 0; i < n; ++i)
+        all |= keys[i];
+    for (shift = 0; shift < 64 && (all >> shift) != 0; shift += ISET_RADIX_BITS) {
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < n; ++i)
+            ++counts[(src[i] >> shift) & (ISET_RADIX_BUCKETS - 1)];
+        uint64_t sum = 0, c;
+        for (c = 0; c < ISET_RADIX_BUCKETS; ++c) {
+            uint64_t count = counts[c];
+            counts[c] = sum;
+            sum += count;
+        }
+        for (i = 0; i < n; ++i)
+            dst[counts[(src[i] >> shift) & (ISET_RADIX_BUCKETS - 1)]++] = src[i];
+        uint64_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != keys)
+        memcpy(keys, src, n * sizeof(uint64_t));
+}
+
+static int __merge_into(IntSet *res, IntSet *s1, IntSet *s2,
+    uint64_t (*merge)(const uint64_t*, uint64_t, const uint64_t*, uint64_t, uint64_t*)) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t na, nb;
+    uint64_t *a = iset_to_sorted_array(s1, &na);
+    uint64_t *b = iset_to_sorted_array(s2, &nb);
+    uint64_t *out = (uint64_t*) malloc((na + nb + 1) * sizeof(uint64_t));
+    int r = SET_MALLOC_ERROR;
+    if (a != NULL && b != NULL && out != NULL)
+        r = iset_from_sorted(res, out, merge(a, na, b, nb, out));
+    free(a);
+    free(b);
+    free(out);
+    return r;
+}
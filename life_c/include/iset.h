@@ -0,0 +1,147 @@
+#ifndef ISET_H
+#define ISET_H
+
+// Integer keyed counterpart of SimpleSet for the hot loop: uint64_t keys held
+// inline in an open addressing table (linear probing, backward shift delete),
+// no allocation per insert, and an O(1) clear that just bumps the epoch.
+// Return codes and the set algebra follow set.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "set.h"
+
+typedef struct {
+    uint64_t key;
+    uint32_t epoch;         // in use iff equal to the owning set's epoch
+} iset_slot;
+
+typedef struct {
+    iset_slot* slots;
+    uint64_t number_nodes;  // always a power of two
+    uint64_t used_nodes;
+    uint32_t epoch;
+} IntSet;
+
+/*  Initialize the set with room for about num_els / 2 keys before it grows
+
+    Returns:
+        SET_MALLOC_ERROR: If an error occured setting up the memory
+        SET_TRUE: On success
+*/
+int iset_init_alt(IntSet *set, uint64_t num_els);
+static __inline__ int iset_init(IntSet *set) {
+    return iset_init_alt(set, 1024);
+}
+
+/* Forget every key in O(1), keeps the allocation */
+int iset_clear(IntSet *set);
+
+/* Free all memory that is part of the set */
+int iset_destroy(IntSet *set);
+
+/*  Add element to set
+
+    Returns:
+        SET_TRUE if added
+        SET_ALREADY_PRESENT if already present
+        SET_MALLOC_ERROR if unable to grow the set
+*/
+int iset_add(IntSet *set, uint64_t key);
+
+/*  Remove element from the set
+
+    Returns:
+        SET_TRUE if removed
+        SET_FALSE if not present
+*/
+int iset_remove(IntSet *set, uint64_t key);
+
+/*  Check if key in set
+
+    Returns:
+        SET_TRUE if present,
+        SET_FALSE if not found
+*/
+int iset_contains(IntSet *set, uint64_t key);
+
+/* Return the number of elements in the set */
+uint64_t iset_length(IntSet *set);
+
+/* res = s1 ∪ s2, res must be empty (SET_OCCUPIED_ERROR otherwise) */
+int iset_union(IntSet *res, IntSet *s1, IntSet *s2);
+
+/* res = s1 ∩ s2 */
+int iset_intersection(IntSet *res, IntSet *s1, IntSet *s2);
+
+/* res = s1 ∖ s2 */
+int iset_difference(IntSet *res, IntSet *s1, IntSet *s2);
+
+/* res = s1 △ s2 */
+int iset_symmetric_difference(IntSet *res, IntSet *s1, IntSet *s2);
+
+/* SET_TRUE if test ⊆ against, SET_FALSE otherwise */
+int iset_is_subset(IntSet *test, IntSet *against);
+
+/* SET_TRUE if test ⊂ against, SET_FALSE otherwise */
+int iset_is_subset_strict(IntSet *test, IntSet *against);
+
+static __inline__ int iset_is_superset(IntSet *test, IntSet *against) {
+    return iset_is_subset(against, test);
+}
+
+static __inline__ int iset_is_superset_strict(IntSet *test, IntSet *against) {
+    return iset_is_subset_strict(against, test);
+}
+
+/*  Return an array of the keys in the set (unordered)
+    NOTE: Up to the caller to free the memory */
+uint64_t* iset_to_array(IntSet *set, uint64_t *size);
+
+/*  Return the keys in ascending order (radix sort), NULL on malloc failure
+    NOTE: Up to the caller to free the memory */
+uint64_t* iset_to_sorted_array(IntSet *set, uint64_t *size);
+
+/*  Merge two ascending arrays of distinct keys into out, which must have
+    room for na + nb keys (union, symmetric difference) or na (intersection,
+    difference). Returns the number of keys written, still ascending.
+*/
+uint64_t iset_merge_union(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out);
+uint64_t iset_merge_intersection(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out);
+uint64_t iset_merge_difference(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out);
+uint64_t iset_merge_symmetric_difference(const uint64_t *a, uint64_t na, const uint64_t *b, uint64_t nb, uint64_t *out);
+
+/*  Fill the empty set res with n distinct keys in one pass: the table is
+    sized once and no key is looked up before it is placed.
+
+    Returns:
+        SET_OCCUPIED_ERROR if res is not empty
+        SET_MALLOC_ERROR if the table could not be sized
+        SET_TRUE on success
+*/
+int iset_from_sorted(IntSet *res, const uint64_t *keys, uint64_t n);
+
+/*  Bulk versions of the set algebra above: both inputs are exported to
+    sorted arrays, merged linearly and res is rebuilt with iset_from_sorted.
+    Pays off for union and symmetric difference on large inputs (diffing
+    whole frontiers between generations), where the hashed versions insert
+    every key; intersection and difference only probe and rarely gain.
+    Same return values as iset_union.
+*/
+int iset_union_sorted(IntSet *res, IntSet *s1, IntSet *s2);
+int iset_intersection_sorted(IntSet *res, IntSet *s1, IntSet *s2);
+int iset_difference_sorted(IntSet *res, IntSet *s1, IntSet *s2);
+int iset_symmetric_difference_sorted(IntSet *res, IntSet *s1, IntSet *s2);
+
+/* Same return values as set_cmp */
+int iset_cmp(IntSet *left, IntSet *right);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* END ISET HEADER */
@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "pixels.h"
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int pixels_init(pixel_buffer* p, size_t board_width, size_t board_height, uint32_t alive, uint32_t dead) {
+    p->width = board_height;
+    p->height = board_width;
+    p->alive = alive;
+    p->dead = dead;
+    p->data = malloc(p->width * p->height * sizeof(uint32_t));
+    if(p->data == NULL)
+        return PIXELS_MALLOC_ERROR;
+
+    for(size_t k = 0; k < p->width * p->height; k++)
+        p->data[k] = dead;
+    return PIXELS_OK;
+}
+
+void pixels_destroy(pixel_buffer* p) {
+    free(p->data);
+    p->data = NULL;
+    p->width = 0;
+    p->height = 0;
+}
+
+void pixels_row_from_bools(pixel_buffer* p, size_t row, const void* first, size_t stride) {
+    pixels_span_from_bools(p, row, 0, p->width, first, stride);
+}
+
+// every texel is dead ^ (mask & (alive ^ dead)), a select without branches
+void pixels_span_from_bools(pixel_buffer* p, size_t row, size_t col, size_t count, const void* first, size_t stride) {
+    uint32_t* out = pixels_row(p, row) + col;
+    const uint8_t* cells = (const uint8_t*) first;
+    const uint32_t flip = p->alive ^ p->dead;
+    size_t j = 0;
+
+#ifdef __SSE2__
+    if(stride == 1) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i dead = _mm_set1_epi32((int) p->dead);
+        const __m128i flip4 = _mm_set1_epi32((int) flip);
+        for(; j + 16 <= count; j += 16) {
+            // 0x00 / 0xff per cell, then widened to 32 bit lanes
+            __m128i live = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*) (cells + j)), zero);
+            __m128i lo = _mm_unpacklo_epi8(live, live);
+            __m128i hi = _mm_unpackhi_epi8(live, live);
+            _mm_storeu_si128((__m128i*) (out + j), _mm_xor_si128(dead, _mm_and_si128(flip4, _mm_unpacklo_epi16(lo, lo))));
+            _mm_storeu_si128((__m128i*) (out + j + 4), _mm_xor_si128(dead, _mm_and_si128(flip4, _mm_unpackhi_epi16(lo, lo))));
+            _mm_storeu_si128((__m128i*) (out + j + 8), _mm_xor_si128(dead, _mm_and_si128(flip4, _mm_unpacklo_epi16(hi, hi))));
+            _mm_storeu_si128((__m128i*) (out + j + 12), _mm_xor_si128(dead, _mm_and_si128(flip4, _mm_unpackhi_epi16(hi, hi))));
+        }
+    }
+#endif
+
+    for(; j < count; j++)
+        out[j] = p->dead ^ (flip & -(uint32_t) (cells[j * stride] != 0));
+}
+
+void pixels_from_bits(pixel_buffer* p, const uint64_t* bits) {
+    const size_t n = p->width * p->height;
+    const uint32_t flip = p->alive ^ p->dead;
+    uint32_t* out = p->data;
+    size_t k = 0;
+
+#ifdef __SSE2__
+    // x86 is little endian: byte b of the words holds bits 8b .. 8b + 7
+    const uint8_t* bytes = (const uint8_t*) bits;
+    const __m128i lanes_lo = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i lanes_hi = _mm_set_epi32(128, 64, 32, 16);
+    const __m128i dead = _mm_set1_epi32((int) p->dead);
+    const __m128i flip4 = _mm_set1_epi32((int) flip);
+    for(; k + 8 <= n; k += 8) {
+        __m128i byte = _mm_set1_epi32(bytes[k / 8]);
+        __m128i lo = _mm_cmpeq_epi32(_mm_and_si128(byte, lanes_lo), lanes_lo);
+        __m128i hi = _mm_cmpeq_epi32(_mm_and_si128(byte, lanes_hi), lanes_hi);
+        _mm_storeu_si128((__m128i*) (out + k), _mm_xor_si128(dead, _mm_and_si128(flip4, lo)));
+        _mm_storeu_si128((__m128i*) (out + k + 4), _mm_xor_si128(dead, _mm_and_si128(flip4, hi)));
+    }
+#endif
+
+    for(; k < n; k++)
+        out[k] = p->dead ^ (flip & -(uint32_t) ((bits[k / 64] >> (k % 64)) & 1));
+}
+
+void pixels_span_from_bits(pixel_buffer* p, size_t row, size_t col, size_t count, const uint64_t* bits) {
+    uint32_t* out = pixels_row(p, row) + col;
+    const uint32_t flip = p->alive ^ p->dead;
+    size_t k = row * p->width + col;
+
+    for(size_t t = 0; t < count; t++, k++)
+        out[t] = p->dead ^ (flip & -(uint32_t) ((bits[k / 64] >> (k % 64)) & 1));
+}
+
+int dirty_init(dirty_tiles* d, size_t width, size_t height, unsigned shift) {
+    d->shift = shift;
+    d->width = width;
+    d->height = height;
+    d->tiles_x = (width + ((size_t) 1 << shift) - 1) >> shift;
+    d->tiles_y = (height + ((size_t) 1 << shift) - 1) >> shift;
+    d->row_words = (d->tiles_x + 63) / 64;
+    size_t words = d->tiles_y * d->row_words;
+    d->bits = malloc((words ? words : 1) * sizeof(uint64_t));
+    // open rects of the row above and of this row, at most one per two tiles each
+    d->open = malloc((d->tiles_x + 2) * sizeof(size_t));
+    if(d->bits == NULL || d->open == NULL) {
+        free(d->bits);
+        free(d->open);
+        d->bits = NULL;
+        d->open = NULL;
+        return PIXELS_MALLOC_ERROR;
+    }
+    dirty_mark_all(d);
+    return PIXELS_OK;
+}
+
+void dirty_destroy(dirty_tiles* d) {
+    free(d->bits);
+    free(d->open);
+    d->bits = NULL;
+    d->open = NULL;
+}
+
+void dirty_mark_all(dirty_tiles* d) {
+    for(size_t ty = 0; ty < d->tiles_y; ty++) {
+        for(size_t w = 0; w < d->row_words; w++) {
+            size_t left = d->tiles_x - w * 64;
+            d->bits[ty * d->row_words + w] = left >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << left) - 1;
+        }
+    }
+}
+
+size_t dirty_collect(dirty_tiles* d, dirty_rect* rects) {
+    const size_t tile = (size_t) 1 << d->shift;
+    size_t n = 0;
+    // rects ending on the row above, in column order, and those of this row
+    size_t* above = d->open;
+    size_t* here = d->open + (d->tiles_x + 2) / 2;
+    size_t n_above = 0;
+
+    for(size_t ty = 0; ty < d->tiles_y; ty++) {
+        uint64_t* row = d->bits + ty * d->row_words;
+        size_t n_here = 0, a = 0;
+        size_t tx = 0;
+
+        while(tx < d->tiles_x) {
+            // jump to the next marked tile, a word at a time
+            uint64_t word = row[tx / 64] >> (tx % 64);
+            if(word == 0) {
+                tx = (tx / 64 + 1) * 64;
+                continue;
+            }
+            tx += __builtin_ctzll(word);
+
+            // and past the end of its run
+            size_t end = tx;
+            while(end < d->tiles_x) {
+                uint64_t rest = ~row[end / 64] >> (end % 64);
+                if(rest != 0) {
+                    end += __builtin_ctzll(rest);
+                    break;
+                }
+                end = (end / 64 + 1) * 64;
+            }
+            if(end > d->tiles_x)
+                end = d->tiles_x;
+
+            size_t x = tx * tile, width = end * tile - x;
+            if(x + width > d->width)
+                width = d->width - x;
+
+            // grow the rect above when it spans exactly the same columns
+            while(a < n_above && rects[above[a]].x < x)
+                a++;
+            if(a < n_above && rects[above[a]].x == x && rects[above[a]].width == width) {
+                dirty_rect* r = &rects[above[a]];
+                r->height = (ty + 1) * tile - r->y;
+                here[n_here++] = above[a++];
+            } else {
+                rects[n] = (dirty_rect) { x, ty * tile, width, tile };
+                here[n_here++] = n++;
+            }
+            tx = end;
+        }
+
+        for(size_t w = 0; w < d->row_words; w++)
+            row[w] = 0;
+
+        size_t* swap = above;
+        above = here;
+        here = swap;
+        n_above = n_here;
+    }
+
+    // the last row of tiles may hang past the image
+    for(size_t k = 0; k < n; k++) {
+        if(rects[k].y + rects[k].height > d->height)
+            rects[k].height = d->height - rects[k].y;
+    }
+    return n;
+}
@@ -0,0 +1,411 @@
+/*  Swiss table implementation of the set.h API, compiled instead of set.c
+    with -DSET_SWISS.
+
+    Each slot has a control byte: SWISS_EMPTY or the top 7 bits of the hash.
+    Lookups compare 16 control bytes against those 7 bits at once (SSE2
+    movemask), so a probe touches the slot array only on a likely match. The
+    probe is linear at slot granularity, which keeps every run contiguous:
+    removal shifts the rest of the run back instead of leaving tombstones.
+    The first 16 control bytes are mirrored after the last slot so a window
+    starting near the end never needs to wrap.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "set.h"
+
+#define MAX_FULLNESS_PERCENT 0.75       /* the control bytes keep probes short */
+#define SWISS_GROUP 16
+#define SWISS_EMPTY 0x80
+
+/* PRIVATE FUNCTIONS */
+static uint64_t __default_hash(const char *key);
+static uint32_t __group_match(const uint8_t *ctrl, uint8_t byte);
+static void __set_ctrl(SimpleSet *set, uint64_t index, uint8_t byte);
+static const char* __slot_key(const swiss_set_slot *slot);
+static int __get_index(SimpleSet *set, const char *key, size_t len, uint64_t hash, uint64_t *index);
+static int __assign_slot(SimpleSet *set, const char *key, size_t len, uint64_t hash, uint64_t index);
+static void __free_slot(SimpleSet *set, uint64_t index);
+static int __set_contains(SimpleSet *set, const char *key, uint64_t hash);
+static int __set_add(SimpleSet *set, const char *key, uint64_t hash);
+static int __grow(SimpleSet *set);
+
+/*******************************************************************************
+***        FUNCTIONS DEFINITIONS
+*******************************************************************************/
+
+int set_init_alt(SimpleSet *set, uint64_t num_els, set_hash_function hash) {
+    uint64_t n = SWISS_GROUP;
+    while (n < num_els)
+        n <<= 1;
+    set->ctrl = (uint8_t*) malloc(n + SWISS_GROUP);
+    set->slots = (swiss_set_slot*) malloc(n * sizeof(swiss_set_slot));
+    if (set->ctrl == NULL || set->slots == NULL) {
+        free(set->ctrl);
+        free(set->slots);
+        set->ctrl = NULL;
+        set->slots = NULL;
+        return SET_MALLOC_ERROR;
+    }
+    memset(set->ctrl, SWISS_EMPTY, n + SWISS_GROUP);
+    set->number_nodes = n;
+    set->used_nodes = 0;
+    set->hash_function = (hash == NULL) ? &__default_hash : hash;
+    set->arena = NULL;
+    return SET_TRUE;
+}
+
+int set_init_arena(SimpleSet *set, uint64_t num_els, set_hash_function hash, set_arena *arena) {
+    int res = set_init_alt(set, num_els, hash);
+    if (res == SET_TRUE)
+        set->arena = arena;
+    return res;
+}
+
+int set_clear(SimpleSet *set) {
+    uint64_t i;
+    if (set->arena == NULL) { // only long keys own memory
+        for (i = 0; i < set->number_nodes; ++i) {
+            if (set->ctrl[i] != SWISS_EMPTY)
+                __free_slot(set, i);
+        }
+    }
+    memset(set->ctrl, SWISS_EMPTY, set->number_nodes + SWISS_GROUP);
+    set->used_nodes = 0;
+    return SET_TRUE;
+}
+
+int set_destroy(SimpleSet *set) {
+    set_clear(set);
+    free(set->ctrl);
+    free(set->slots);
+    set->ctrl = NULL;
+    set->slots = NULL;
+    set->number_nodes = 0;
+    set->used_nodes = 0;
+    set->hash_function = NULL;
+    set->arena = NULL;
+    return SET_TRUE;
+}
+
+int set_add(SimpleSet *set, const char *key) {
+    uint64_t hash = set->hash_function(key);
+    return __set_add(set, key, hash);
+}
+
+int set_contains(SimpleSet *set, const char *key) {
+    uint64_t hash = set->hash_function(key);
+    return __set_contains(set, key, hash);
+}
+
+int set_remove(SimpleSet *set, const char *key) {
+    uint64_t index, hash = set->hash_function(key);
+    uint64_t mask = set->number_nodes - 1;
+    int pos = __get_index(set, key, strlen(key), hash, &index);
+    if (pos != SET_TRUE) {
+        return pos;
+    }
+    __free_slot(set, index);
+
+    // backward shift: pull back every later entry of the run that may sit in the hole
+    uint64_t hole = index, i = (index + 1) & mask;
+    while (set->ctrl[i] != SWISS_EMPTY) {
+        uint64_t home = set->slots[i]._hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            set->slots[hole] = set->slots[i];
+            __set_ctrl(set, hole, set->ctrl[i]);
+            hole = i;
+        }
+        i = (i + 1) & mask;
+    }
+    __set_ctrl(set, hole, SWISS_EMPTY);
+    --set->used_nodes;
+    return SET_TRUE;
+}
+
+uint64_t set_length(SimpleSet *set) {
+    return set->used_nodes;
+}
+
+char** set_to_array(SimpleSet *set, uint64_t *size) {
+    *size = set->used_nodes;
+    char** results = (char**)calloc(set->used_nodes + 1, sizeof(char*));
+    uint64_t i, j = 0;
+    size_t len;
+    for (i = 0; i < set->number_nodes; ++i) {
+        if (set->ctrl[i] != SWISS_EMPTY) {
+            len = set->slots[i]._len;
+            results[j] = (char*)calloc(len + 1, sizeof(char));
+            memcpy(results[j], __slot_key(&set->slots[i]), len);
+            ++j;
+        }
+    }
+    return results;
+}
+
+int set_union(SimpleSet *res, SimpleSet *s1, SimpleSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (s1->ctrl[i] != SWISS_EMPTY) {
+            __set_add(res, __slot_key(&s1->slots[i]), s1->slots[i]._hash);
+        }
+    }
+    for (i = 0; i < s2->number_nodes; ++i) {
+        if (s2->ctrl[i] != SWISS_EMPTY) {
+            __set_add(res, __slot_key(&s2->slots[i]), s2->slots[i]._hash);
+        }
+    }
+    return SET_TRUE;
+}
+
+int set_intersection(SimpleSet *res, SimpleSet *s1, SimpleSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (s1->ctrl[i] != SWISS_EMPTY) {
+            const char *key = __slot_key(&s1->slots[i]);
+            if (__set_contains(s2, key, s1->slots[i]._hash) == SET_TRUE) {
+                __set_add(res, key, s1->slots[i]._hash);
+            }
+        }
+    }
+    return SET_TRUE;
+}
+
+/* difference is s1 - s2 */
+int set_difference(SimpleSet *res, SimpleSet *s1, SimpleSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (s1->ctrl[i] != SWISS_EMPTY) {
+            const char *key = __slot_key(&s1->slots[i]);
+            if (__set_contains(s2, key, s1->slots[i]._hash) != SET_TRUE) {
+                __set_add(res, key, s1->slots[i]._hash);
+            }
+        }
+    }
+    return SET_TRUE;
+}
+
+int set_symmetric_difference(SimpleSet *res, SimpleSet *s1, SimpleSet *s2) {
+    if (res->used_nodes != 0) {
+        return SET_OCCUPIED_ERROR;
+    }
+    uint64_t i;
+    for (i = 0; i < s1->number_nodes; ++i) {
+        if (s1->ctrl[i] != SWISS_EMPTY) {
+            const char *key = __slot_key(&s1->slots[i]);
+            if (__set_contains(s2, key, s1->slots[i]._hash) != SET_TRUE) {
+                __set_add(res, key, s1->slots[i]._hash);
+            }
+        }
+    }
+    for (i = 0; i < s2->number_nodes; ++i) {
+        if (s2->ctrl[i] != SWISS_EMPTY) {
+            const char *key = __slot_key(&s2->slots[i]);
+            if (__set_contains(s1, key, s2->slots[i]._hash) != SET_TRUE) {
+                __set_add(res, key, s2->slots[i]._hash);
+            }
+        }
+    }
+    return SET_TRUE;
+}
+
+int set_is_subset(SimpleSet *test, SimpleSet *against) {
+    uint64_t i;
+    for (i = 0; i < test->number_nodes; ++i) {
+        if (test->ctrl[i] != SWISS_EMPTY) {
+            if (__set_contains(against, __slot_key(&test->slots[i]), test->slots[i]._hash) == SET_FALSE) {
+                return SET_FALSE;
+            }
+        }
+    }
+    return SET_TRUE;
+}
+
+int set_is_subset_strict(SimpleSet *test, SimpleSet *against) {
+    if (test->used_nodes >= against->used_nodes) {
+        return SET_FALSE;
+    }
+    return set_is_subset(test, against);
+}
+
+int set_cmp(SimpleSet *left, SimpleSet *right) {
+    if (left->used_nodes < right->used_nodes) {
+        return SET_RIGHT_GREATER;
+    } else if (right->used_nodes < left->used_nodes) {
+        return SET_LEFT_GREATER;
+    }
+    uint64_t i;
+    for (i = 0; i < left->number_nodes; ++i) {
+        if (left->ctrl[i] != SWISS_EMPTY) {
+            if (set_contains(right, __slot_key(&left->slots[i])) != SET_TRUE) {
+                return SET_UNEQUAL;
+            }
+        }
+    }
+
+    return SET_EQUAL;
+}
+
+
+/*******************************************************************************
+***        PRIVATE FUNCTIONS
+*******************************************************************************/
+static uint64_t __default_hash(const char *key) {
+    // FNV-1a hash (http://www.isthe.com/chongo/tech/comp/fnv/)
+    size_t i, len = strlen(key);
+    uint64_t h = 14695981039346656037ULL; // FNV_OFFSET 64 bit
+    for (i = 0; i < len; ++i) {
+        h = h ^ (unsigned char) key[i];
+        h = h * 1099511628211ULL; // FNV_PRIME 64 bit
+    }
+    return h;
+}
+
+/* bit k set when ctrl[k] == byte, for the 16 bytes at ctrl */
+static uint32_t __group_match(const uint8_t *ctrl, uint8_t byte) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) byte)));
+#else
+    uint32_t k, bits = 0;
+    for (k = 0; k < SWISS_GROUP; ++k)
+        bits |= (uint32_t)(ctrl[k] == byte) << k;
+    return bits;
+#endif
+}
+
+static void __set_ctrl(SimpleSet *set, uint64_t index, uint8_t byte) {
+    set->ctrl[index] = byte;
+    if (index < SWISS_GROUP)
+        set->ctrl[set->number_nodes + index] = byte;
+}
+
+static const char* __slot_key(const swiss_set_slot *slot) {
+    return slot->_len < SET_SWISS_INLINE ? slot->_key._small : slot->_key._big;
+}
+
+static int __set_contains(SimpleSet *set, const char *key, uint64_t hash) {
+    uint64_t index;
+    return __get_index(set, key, strlen(key), hash, &index);
+}
+
+static int __set_add(SimpleSet *set, const char *key, uint64_t hash) {
+    uint64_t index;
+    size_t len = strlen(key);
+    int res = __get_index(set, key, len, hash, &index);
+    if (res == SET_TRUE)
+        return SET_ALREADY_PRESENT;
+
+    if ((float)(set->used_nodes + 1) / set->number_nodes > MAX_FULLNESS_PERCENT) {
+        if (__grow(set) != SET_TRUE)
+            return SET_MALLOC_ERROR;
+        res = __get_index(set, key, len, hash, &index);
+    }
+    if (res == SET_FALSE) { // this is the first open slot
+        if (__assign_slot(set, key, len, hash, index) != SET_TRUE)
+            return SET_MALLOC_ERROR;
+        ++set->used_nodes;
+        return SET_TRUE;
+    }
+    return res;
+}
+
+static int __get_index(SimpleSet *set, const char *key, size_t len, uint64_t hash, uint64_t *index) {
+    uint64_t mask = set->number_nodes - 1;
+    uint64_t i = hash & mask, probed = 0;
+    uint8_t h2 = (uint8_t)(hash >> 57);
+    while (probed < set->number_nodes) {
+        uint32_t match = __group_match(set->ctrl + i, h2);
+        uint32_t empty = __group_match(set->ctrl + i, SWISS_EMPTY);
+        if (empty)  // the run ends at the first empty slot, ignore what follows it
+            match &= (empty & -empty) - 1;
+        while (match) {
+            uint64_t j = (i + __builtin_ctz(match)) & mask;
+            swiss_set_slot *slot = &set->slots[j];
+            if (slot->_hash == hash && slot->_len == len && memcmp(__slot_key(slot), key, len) == 0) {
+                *index = j;
+                return SET_TRUE;
+            }
+            match &= match - 1;
+        }
+        if (empty) {
+            *index = (i + __builtin_ctz(empty)) & mask;
+            return SET_FALSE; // not here OR first open slot
+        }
+        i = (i + SWISS_GROUP) & mask;
+        probed += SWISS_GROUP;
+    }
+    return SET_CIRCULAR_ERROR;
+}
+
+static int __assign_slot(SimpleSet *set, const char *key, size_t len, uint64_t hash, uint64_t index) {
+    swiss_set_slot *slot = &set->slots[index];
+    char *dst = slot->_key._small;
+    if (len >= SET_SWISS_INLINE) {
+        if (set->arena != NULL)
+            dst = (char*)set_arena_alloc(set->arena, len + 1);
+        else
+            dst = (char*)malloc(len + 1);
+        if (dst == NULL)
+            return SET_MALLOC_ERROR;
+        slot->_key._big = dst;
+    }
+    memcpy(dst, key, len);
+    dst[len] = '\0';
+    slot->_hash = hash;
+    slot->_len = len;
+    __set_ctrl(set, index, (uint8_t)(hash >> 57));
+    return SET_TRUE;
+}
+
+static void __free_slot(SimpleSet *set, uint64_t index) {
+    if (set->arena == NULL && set->slots[index]._len >= SET_SWISS_INLINE)
+        free(set->slots[index]._key._big);
+}
+
+/* double the table, entries are moved by their stored hash without touching the keys */
+static int __grow(SimpleSet *set) {
+    uint64_t i, n = set->number_nodes * 2, mask = n - 1;
+    uint8_t *ctrl = (uint8_t*) malloc(n + SWISS_GROUP);
+    swiss_set_slot *slots = (swiss_set_slot*) malloc(n * sizeof(swiss_set_slot));
+    if (ctrl == NULL || slots == NULL) {
+        free(ctrl);
+        free(slots);
+        return SET_MALLOC_ERROR;
+    }
+    memset(ctrl, SWISS_EMPTY, n + SWISS_GROUP);
+
+    for (i = 0; i < set->number_nodes; ++i) {
+        if (set->ctrl[i] == SWISS_EMPTY)
+            continue;
+        uint64_t j = set->slots[i]._hash & mask;
+        while (ctrl[j] != SWISS_EMPTY)
+            j = (j + 1) & mask;
+        slots[j] = set->slots[i];
+        ctrl[j] = set->ctrl[i];
+        if (j < SWISS_GROUP)
+            ctrl[n + j] = set->ctrl[i];
+    }
+
+    free(set->ctrl);
+    free(set->slots);
+    set->ctrl = ctrl;
+    set->slots = slots;
+    set->number_nodes = n;
+    return SET_TRUE;
+}
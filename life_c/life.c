@@ -6,6 +6,7 @@
 #include <math.h>
 
 #include "raylib.h"
+#include "render.h"
 
 #define BOARD_WIDTH 50
 #define BOARD_HEIGHT 50
@@ -95,19 +96,14 @@ void updateBoard(cell_board* board) {
     }
 }
 
-void drawBoard(cell_board* board) {
+void drawBoard(cell_board* board, board_texture* texture) {
+    for(size_t i = 0; i < BOARD_WIDTH; i++)
+        pixels_row_from_bools(&texture->pixels, i, board->cells[i], sizeof(bool));
+    render_upload(texture);
+
     BeginDrawing();
     ClearBackground(GRAY);
-    for(size_t i = 0; i < BOARD_WIDTH; i++) {
-        for(size_t j = 0; j < BOARD_HEIGHT; j++) {
-            bool cell = board->cells[i][j];
-            Color color = BLACK;
-            if(cell)
-                color = WHITE;
-
-            DrawRectangle(i * CELL_WIDTH_PX / 2, j * CELL_WIDTH_PX / 2, CELL_WIDTH_PX, CELL_WIDTH_PX, color);
-        }
-    }
+    render_draw(texture, 0, 0, CELL_WIDTH_PX / 2.0f);
     EndDrawing();
 }
 
@@ -203,6 +199,13 @@ int main(int argc, char **argv) {
 
     SetTargetFPS(120);
 
+    board_texture texture;
+    if(render_init(&texture, BOARD_WIDTH, BOARD_HEIGHT) != PIXELS_OK) {
+        CloseWindow();
+        free(board);
+        return 1;
+    }
+
     //randomizeBoard(board);
     printBoard(board);
     
@@ -255,9 +258,10 @@ int main(int argc, char **argv) {
         }
 
         //updateBoard(board);
-        drawBoard(board);
+        drawBoard(board, &texture);
     }
     
+    render_unload(&texture);
     CloseWindow();
     //printf("%zu", sizeof(cell_board));
     free(board);
@@ -7,7 +7,9 @@
 
 #include "raylib.h"
 #include "queue.h"
-#include "set.h"
+#include "frontier.h"
+#include "render.h"
+#include "checkpoint.h"
 
 
 //#define CELL_WIDTH_PX 30
@@ -22,6 +24,8 @@
 #define GLIDER_I_0 12
 #define GLIDER_J_0 4
 
+#define CHECKPOINT_PATH "board.ckpt"    /* F5 and quitting write it, F9 goes back to it */
+
 typedef enum {
     paused = 0,
     running = 1
@@ -38,6 +42,9 @@ GameMode mode = paused;
 size_t board_width = 50; // default
 size_t board_height = 50; // default
 unsigned int cell_width_px = 30; // default
+const char* checkpoint_path = CHECKPOINT_PATH; // or a .ckpt given as argv[4], the run starts from it
+uint64_t board_rng = 0x9E3779B97F4A7C15ULL; // xorshift64* state, so a checkpoint can carry it
+uint64_t generation = 0;
 
 typedef struct {
     bool alive;
@@ -51,12 +58,14 @@ typedef struct {
     cell** cells;
     size_t board_width;
     size_t board_height;
+    Frontier frontier;  // cells already enqueued this generation, cleared per step
+    dirty_tiles* dirty; // tiles of the board texture to re-upload, NULL when not drawn
     // TODO: dynamically allocate cells depending on size specified at runtime
 
     //unsigned int cn_cells[BOARD_WIDTH][BOARD_HEIGHT];
 } cell_board;
 
-void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, size_t j_0);
+void setEnqueuedNCells(cell_board* board, Queue* q, Frontier* s, size_t i_0, size_t j_0);
 
 void setCellBQ(cell_board* board, Queue* q, unsigned int i, unsigned int j, bool status) {
     board->cells[i][j].alive = status;
@@ -82,12 +91,18 @@ cell_board* init_board(size_t width, size_t height) {
         return NULL;
     }
 
+    if(frontier_init(&board->frontier, (uint64_t) width * height) != SET_TRUE) {
+        free(board);
+        return NULL;
+    }
+
     board->cells = malloc(board_width * sizeof(cell*));
     for (size_t i = 0; i < board_width; i++)
         board->cells[i] = malloc(board_height * sizeof(cell));
 
     board->board_width = board_width;
     board->board_height = board_height;
+    board->dirty = NULL;
 
     if(board->cells == NULL) {
         free(board);
@@ -113,6 +128,7 @@ void free_board(cell_board* board) {
         free(board->cells);
     }
     if(board) {
+        frontier_destroy(&board->frontier);
         free(board);
     }
 }
@@ -160,7 +176,7 @@ void updateEnqueuedNeighbors(cell_board* board, Queue* q) {
 
 }
 
-void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, size_t j_0) {
+void setEnqueuedNCells(cell_board* board, Queue* q, Frontier* s, size_t i_0, size_t j_0) {
 
     for(int i = -1; i <= 1; i++) {
         for(int j = -1; j <= 1; j++) {
@@ -171,19 +187,13 @@ void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, si
 
             //fprintf(stderr, "Setting neighboring cells\n");
             //printf("Neighbor at (%u, %u): %u", (unsigned int) used_i, (unsigned int) used_j, (unsigned int) board->cells[used_i][used_j]);
-            uint64_t key_addr = (uint64_t) ( (neighbor_i << ((unsigned int) log2(board_width) + 1)) ) + neighbor_j;
-            char key[8];
+            uint64_t key = (uint64_t) neighbor_i * board_height + neighbor_j;
 
-            for (int i = 0; i < 8; i++)
-                key[i] = (key_addr >> (i * 8)) & 0xFF;
-            
-            //printf(key);
-            
             if(!s) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
-            else if(set_add(s, (const char*) key) == SET_TRUE) {
+            else if(frontier_add(s, key) == SET_TRUE) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
@@ -201,8 +211,8 @@ void updateBoard(cell_board* board, Queue* q) {
 
     //printf("Calculating neighbors");
 
-    SimpleSet s;
-    set_init(&s);
+    Frontier* s = &board->frontier;
+    frontier_clear(s);
 
     //printf("Calculating neighbors");
     
@@ -211,37 +221,40 @@ void updateBoard(cell_board* board, Queue* q) {
         for(size_t j = 0; j < board_height; j++) {
             bool cell = board->cells[i][j].alive;
             unsigned int neighbors = board->cells[i][j].neighbors;
+            bool next = neighbors == NEIGHBOR_THRESHOLD || (cell && neighbors == NEIGHBOR_THRESHOLD - 1);
+            if(next != cell && board->dirty)
+                dirty_mark(board->dirty, i, j);
             
             if(cell && (neighbors == NEIGHBOR_THRESHOLD || neighbors == NEIGHBOR_THRESHOLD - 1)) {
                 setCellB(board, i, j, alive);
                 
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             } else if(!cell && neighbors == NEIGHBOR_THRESHOLD) {
                 setCellB(board, i, j, alive);
 
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             } else {
                 setCellB(board, i, j, dead);
             }
         }
     }
-
-    set_destroy(&s);
 }
 
-void drawBoard(cell_board* board) {
+void drawBoard(cell_board* board, board_texture* texture) {
+    // refill only the tiles that flipped, each column of cells is one texel
+    // row read through the cell structs
+    size_t n = render_collect(texture);
+    for(size_t k = 0; k < n; k++) {
+        dirty_rect r = texture->rects[k];
+        for(size_t i = r.y; i < r.y + r.height; i++)
+            pixels_span_from_bools(&texture->pixels, i, r.x, r.width, &board->cells[i][r.x].alive, sizeof(cell));
+    }
+    render_upload_rects(texture, n);
+
     BeginDrawing();
     ClearBackground(GRAY);
-    for(size_t i = 0; i < board_width; i++) {
-        for(size_t j = 0; j < board_height; j++) {
-            bool cell = board->cells[i][j].alive;
-            Color color = BLACK;
-            if(cell)
-                color = WHITE;
-
-            DrawRectangle(i * cell_width_px / 2, j * cell_width_px / 2, cell_width_px, cell_width_px, color);
-        }
-    }
+    render_draw(texture, 0, 0, cell_width_px / 2.0f);
+    DrawText(TextFormat("upload %.1f KiB", texture->bytes_uploaded / 1024.0), 10, 10, 10, RED);
     EndDrawing();
 }
 
@@ -271,30 +284,39 @@ void printNeighbors(cell_board* board) {
     }
 }
 
+uint64_t nextRand(uint64_t* state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
 void randomizeBoard(cell_board* board, Queue* q) {
     const float coverage = COVERAGE;
     fprintf(stderr, "Randomizing board\n");
     resetQueue(q);
 
-    SimpleSet s;
-    set_init(&s);
+    Frontier* s = &board->frontier;
+    frontier_clear(s);
 
     fprintf(stderr, "Gotten board set\n");
 
     for(size_t i = 0; i < board_width; i++) {
         for(size_t j = 0; j < board_height; j++) {
-            if((float) rand()/RAND_MAX > (1 - coverage)) {
+            if((float) (nextRand(&board_rng) >> 40) / (float) (1 << 24) > (1 - coverage)) {
                 //fprintf(stderr, "Setting single cell\n");
                 setCellB(board, i, j, alive);
                 //fprintf(stderr, "Setting neighboring cells to queue\n");
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             }
             else
                 setCellB(board, i, j, dead);
         }
     }
     //printQueue(q);
-    set_destroy(&s);
 }
 
 
@@ -307,13 +329,16 @@ void clearBoard(cell_board* board) {
             //board->cells[i][j].j = j;
         }
     }
+    // R and G refill the board right after, this covers them too
+    if(board->dirty)
+        dirty_mark_all(board->dirty);
 }
 
 void drawTile(cell_board* board, Queue* q, unsigned int mouse_x, unsigned int mouse_y) {
     size_t cell_i = round((float) board_width * (float) mouse_x / (board_width * cell_width_px) * 2);
     size_t cell_j = round((float) board_height * (float) mouse_y / (board_height * cell_width_px) * 2);
 
-    if(cell_i > board_width || cell_j > board_height) {
+    if(cell_i >= board_width || cell_j >= board_height) {
         return;
     }
     
@@ -322,6 +347,8 @@ void drawTile(cell_board* board, Queue* q, unsigned int mouse_x, unsigned int mo
     bool* status = &board->cells[cell_i][cell_j].alive;
 
     *status = !*status;
+    if(board->dirty)
+        dirty_mark(board->dirty, cell_i, cell_j);
 
     if(board->cells[cell_i][cell_j].alive)
         setEnqueuedNCells(board, q, NULL, cell_i, cell_j);
@@ -345,6 +372,89 @@ void setBoardGlider(cell_board* board, Queue* q, size_t i_0, size_t j_0) {
 
 }
 
+bool hasExtension(const char* path, const char* extension) {
+    size_t length = strlen(path), ext_length = strlen(extension);
+    return length > ext_length && strcmp(path + length - ext_length, extension) == 0;
+}
+
+/*  The board packed a bit per cell, column after column (cell (i, j) is bit
+    i * board_height + j), with its generation and RNG state: the layout
+    lenia_c's window writes, so a checkpoint opens in either. See checkpoint.h
+*/
+bool checkpointBoard(cell_board* board, const char* path) {
+    const size_t words = (board_width * board_height + 63) / 64;
+    uint64_t* bits = calloc(words, sizeof(uint64_t));
+    if(bits == NULL) {
+        fprintf(stderr, "could not write checkpoint %s\n", path);
+        return false;
+    }
+    for(size_t i = 0; i < board_width; i++)
+        for(size_t j = 0; j < board_height; j++) {
+            uint64_t k = (uint64_t) i * board_height + j;
+            bits[k / 64] |= (uint64_t) board->cells[i][j].alive << (k % 64);
+        }
+
+    checkpoint_header h;
+    checkpoint_describe(&h, "life", "B3/S23");
+    h.width = board_width;
+    h.height = board_height;
+    h.generation = generation;
+    h.rng = board_rng;
+    h.cell_bits = 1;
+    h.state_bytes = words * sizeof(uint64_t);
+
+    int status = checkpoint_write(path, &h, bits);
+    free(bits);
+    if(status != CHECKPOINT_OK)
+        fprintf(stderr, "could not write checkpoint %s (%d)\n", path, status);
+    else
+        fprintf(stderr, "checkpoint %s at generation %llu\n", path, (unsigned long long) generation);
+    return status == CHECKPOINT_OK;
+}
+
+/*  Put the board back as the checkpoint at path left it, reading the bits
+    straight out of the mapped file. Live cells queue their neighbourhood
+    the way randomizeBoard does.
+*/
+bool restoreBoard(cell_board* board, Queue* q, const char* path) {
+    checkpoint_map m;
+    int status = checkpoint_open(&m, path);
+    if(status != CHECKPOINT_OK) {
+        fprintf(stderr, "could not read checkpoint %s (%d)\n", path, status);
+        return false;
+    }
+    const checkpoint_header* h = m.header;
+    const size_t words = (board_width * board_height + 63) / 64;
+    if(strcmp(h->engine, "life") != 0 || h->width != board_width || h->height != board_height
+       || h->cell_bits != 1 || h->state_bytes != words * sizeof(uint64_t)) {
+        fprintf(stderr, "checkpoint %s is a %s board of %llux%llu, not this one\n", path, h->engine,
+            (unsigned long long) h->width, (unsigned long long) h->height);
+        checkpoint_close(&m);
+        return false;
+    }
+
+    clearBoard(board);
+    resetQueue(q);
+    Frontier* s = &board->frontier;
+    frontier_clear(s);
+
+    const uint64_t* bits = (const uint64_t*) m.state;
+    for(size_t i = 0; i < board_width; i++)
+        for(size_t j = 0; j < board_height; j++) {
+            uint64_t k = (uint64_t) i * board_height + j;
+            if(bits[k / 64] >> (k % 64) & 1) {
+                setCellB(board, i, j, alive);
+                setEnqueuedNCells(board, q, s, i, j);
+            }
+        }
+
+    generation = h->generation;
+    board_rng = h->rng;
+    fprintf(stderr, "restored %s at generation %llu\n", path, (unsigned long long) h->generation);
+    checkpoint_close(&m);
+    return true;
+}
+
 unsigned long safe_atoi(const char *str) {
     unsigned long value;
     if (sscanf(str, "%zu", &value) == 1) {
@@ -357,7 +467,8 @@ unsigned long safe_atoi(const char *str) {
 }
 
 int main(int argc, char** argv) {
-    srand(time(NULL));
+    board_rng ^= (uint64_t) time(NULL) * 0xBF58476D1CE4E5B9ULL;
+    bool restoring = false;
 
 
     //fprintf(stderr, "Num args: %i", argc);
@@ -372,6 +483,24 @@ int main(int argc, char** argv) {
         if(argc >= 4) {
             cell_width_px = (unsigned) safe_atoi(argv[3]);
         }
+
+        if(argc >= 5 && hasExtension(argv[4], ".ckpt")) {
+            checkpoint_path = argv[4];
+            restoring = true;
+        }
+    }
+
+    // a checkpoint brings its own board size
+    if(restoring) {
+        checkpoint_map restore;
+        if(checkpoint_open(&restore, checkpoint_path) != CHECKPOINT_OK || restore.header->width == 0
+           || restore.header->height == 0) {
+            fprintf(stderr, "could not read checkpoint %s\n", checkpoint_path);
+            return 1;
+        }
+        board_width = restore.header->width;
+        board_height = restore.header->height;
+        checkpoint_close(&restore);
     }
 
 
@@ -381,7 +510,6 @@ int main(int argc, char** argv) {
     cell_board* board = init_board(board_width, board_width);
     
     Queue* queue = malloc(sizeof(Queue));
-    initializeQueue(queue);
 
     if (board == NULL) {
         return 1;  // Return 1 to indicate memory allocation failure
@@ -389,6 +517,8 @@ int main(int argc, char** argv) {
     if (queue == NULL) {
         return 1;  // Return 1 to indicate memory allocation failure
     }
+    // the queue doubles on demand, no need to reserve the whole board up front
+    initializeQueue(queue, QUEUE_MIN_SIZE);
 
     fprintf(stderr, "Gotten board\n");
     
@@ -396,6 +526,17 @@ int main(int argc, char** argv) {
 
     SetTargetFPS(120);
 
+    board_texture texture;
+    if(render_init(&texture, board_width, board_height) != PIXELS_OK) {
+        CloseWindow();
+        free_board(board);
+        return 1;
+    }
+    board->dirty = &texture.dirty;
+
+    if(restoring)
+        restoreBoard(board, queue, checkpoint_path);
+
     //randomizeBoard(board);
     printBoard(board);
     
@@ -411,6 +552,9 @@ int main(int argc, char** argv) {
             // TODO: resize screen
         }
 
+        if(key_pressed == KEY_F5)
+            checkpointBoard(board, checkpoint_path);
+
         switch(mode) {
 
             case paused:
@@ -442,6 +586,10 @@ int main(int argc, char** argv) {
 
                     setBoardGlider(board, queue, GLIDER_I_0, GLIDER_J_0);
                 }
+
+                if(key_pressed == KEY_F9) {
+                    restoreBoard(board, queue, checkpoint_path);
+                }
                 
                 if(key_pressed == KEY_SPACE) {
                     mode = running;
@@ -472,6 +620,7 @@ int main(int argc, char** argv) {
                 }
 
                 updateBoard(board, queue);
+                generation++;
 
                 break;
 
@@ -482,12 +631,18 @@ int main(int argc, char** argv) {
         }
 
         //updateBoard(board);
-        drawBoard(board);
+        drawBoard(board, &texture);
     }
     
+    // a run that never stepped has nothing worth keeping, don't clobber an older one
+    if(generation)
+        checkpointBoard(board, checkpoint_path);
+
+    render_unload(&texture);
     CloseWindow();
     //printf("%zu", sizeof(cell_board));
     free_board(board);
+    freeQueue(queue);
     free(queue);
     return 0;
 }
\ No newline at end of file
@@ -8,8 +8,11 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "queue.h"
-#include "set.h"
+#include "iset.h"
 #include "bmpfile.h"
+#include "exporter.h"
+#include "render.h"
+#include "checkpoint.h"
 
 #define BOARD_WIDTH 50
 #define BOARD_HEIGHT 50
@@ -24,6 +27,10 @@
 
 #define FOV 45.0f
 
+#define UPDATE_INTERVAL_FRAMES 10   /* frames per generation, argv[1] overrides */
+#define SNAPSHOT_QUEUE 4            /* saves waiting for the writer thread, more are dropped */
+#define CHECKPOINT_PATH "board.ckpt"    /* F5 and quitting write it, F9 goes back to it */
+
 
 typedef enum {
     paused = 0,
@@ -36,6 +43,9 @@ enum {
 };
 
 GameMode mode = paused;
+const char* checkpoint_path = CHECKPOINT_PATH; // or a .ckpt given as argv[2], the run starts from it
+uint64_t board_rng = 0x9E3779B97F4A7C15ULL; // xorshift64* state, so a checkpoint can carry it
+uint64_t generation = 0;
 
 typedef struct {
     bool alive;
@@ -47,6 +57,7 @@ typedef struct {
 
 typedef struct {
     cell cells[BOARD_WIDTH][BOARD_HEIGHT];
+    IntSet frontier;    // cells already enqueued this generation, cleared per step
     //unsigned int cn_cells[BOARD_WIDTH][BOARD_HEIGHT];
 } cell_board;
 
@@ -72,6 +83,10 @@ cell_board* init_board(size_t width, size_t height) {
     if(board == NULL) {
         return NULL;
     }
+    if(iset_init(&board->frontier) != SET_TRUE) {
+        free(board);
+        return NULL;
+    }
     for(size_t i = 0; i < BOARD_WIDTH; i++) {
         for(size_t j = 0; j < BOARD_HEIGHT; j++) {
             board->cells[i][j].alive = dead;
@@ -126,7 +141,7 @@ void updateEnqueuedNeighbors(cell_board* board, Queue* q) {
 
 }
 
-void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, size_t j_0) {
+void setEnqueuedNCells(cell_board* board, Queue* q, IntSet* s, size_t i_0, size_t j_0) {
 
     for(int i = -1; i <= 1; i++) {
         for(int j = -1; j <= 1; j++) {
@@ -137,19 +152,13 @@ void setEnqueuedNCells(cell_board* board, Queue* q, SimpleSet* s, size_t i_0, si
 
             //fprintf(stderr, "Setting neighboring cells\n");
             //printf("Neighbor at (%u, %u): %u", (unsigned int) used_i, (unsigned int) used_j, (unsigned int) board->cells[used_i][used_j]);
-            uint64_t key_addr = (uint64_t) ( (neighbor_i << ((unsigned int) log2(BOARD_WIDTH) + 1)) ) + neighbor_j;
-            char key[8];
+            uint64_t key = (uint64_t) neighbor_i * BOARD_HEIGHT + neighbor_j;
 
-            for (int i = 0; i < 8; i++)
-                key[i] = (key_addr >> (i * 8)) & 0xFF;
-            
-            //printf(key);
-            
             if(!s) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
-            else if(set_add(s, (const char*) key) == SET_TRUE) {
+            else if(iset_add(s, key) == SET_TRUE) {
                 board->cells[neighbor_i][neighbor_j].enqueued = true;
                 enqueue(q, (uint64_t) &board->cells[neighbor_i][neighbor_j]);
             }
@@ -167,8 +176,8 @@ void updateBoard(cell_board* board, Queue* q) {
 
     //printf("Calculating neighbors");
 
-    SimpleSet s;
-    set_init(&s);
+    IntSet* s = &board->frontier;
+    iset_clear(s);
 
     //printf("Calculating neighbors");
     
@@ -181,18 +190,16 @@ void updateBoard(cell_board* board, Queue* q) {
             if(cell && (neighbors == NEIGHBOR_THRESHOLD || neighbors == NEIGHBOR_THRESHOLD - 1)) {
                 setCellB(board, i, j, alive);
                 
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             } else if(!cell && neighbors == NEIGHBOR_THRESHOLD) {
                 setCellB(board, i, j, alive);
 
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             } else {
                 setCellB(board, i, j, dead);
             }
         }
     }
-
-    set_destroy(&s);
 }
 
 void drawBoard(cell_board* board) {
@@ -237,30 +244,39 @@ void printNeighbors(cell_board* board) {
     }
 }
 
+uint64_t nextRand(uint64_t* state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
 void randomizeBoard(cell_board* board, Queue* q) {
     const float coverage = 0.2;
     fprintf(stderr, "Randomizing board\n");
     resetQueue(q);
 
-    SimpleSet s;
-    set_init(&s);
+    IntSet* s = &board->frontier;
+    iset_clear(s);
 
     fprintf(stderr, "Gotten board set\n");
 
     for(size_t i = 0; i < BOARD_WIDTH; i++) {
         for(size_t j = 0; j < BOARD_HEIGHT; j++) {
-            if((float) rand()/RAND_MAX > (1 - coverage)) {
+            if((float) (nextRand(&board_rng) >> 40) / (float) (1 << 24) > (1 - coverage)) {
                 //fprintf(stderr, "Setting single cell\n");
                 setCellB(board, i, j, alive);
                 //fprintf(stderr, "Setting neighboring cells to queue\n");
-                setEnqueuedNCells(board, q, &s, i, j);
+                setEnqueuedNCells(board, q, s, i, j);
             }
             else
                 setCellB(board, i, j, dead);
         }
     }
     //printQueue(q);
-    set_destroy(&s);
 }
 
 
@@ -294,71 +310,156 @@ void drawClickedTile(cell_board* board) {
     drawTile(board, GetMouseX(), GetMouseY());
 }
 
-unsigned char** getBoardBytes(cell_board* board) {
-    // Allocate memory for the row pointers
-    unsigned char** board_gs = malloc(BOARD_WIDTH * sizeof(unsigned char*));
-    if (board_gs == NULL) {
-        perror("Failed to allocate memory for board_gs");
-        return NULL; // Return NULL if allocation fails
+/* Image row y of the board in BMP 1 bit format: pixel x is cell (x, y), white alive */
+bool getBoardRow(void* ctx, uint32_t y, uint8_t* row) {
+    cell_board* board = (cell_board*) ctx;
+    for(size_t i = 0; i < BOARD_WIDTH; i += 8) {
+        uint8_t byte = 0;
+        for(size_t b = 0; b < 8 && i + b < BOARD_WIDTH; b++)
+            byte |= (uint8_t) board->cells[i + b][y].alive << (7 - b);
+        row[i / 8] = byte;
     }
+    return true;
+}
 
-    // Allocate memory for each row and set initial values
-    for (size_t i = 0; i < BOARD_WIDTH; i++) {
-        board_gs[i] = malloc(BOARD_HEIGHT * sizeof(unsigned char));
-        if (board_gs[i] == NULL) {
-            perror("Failed to allocate memory for board_gs row");
-            // Free any previously allocated rows if allocation fails
-            for (size_t k = 0; k < i; k++) {
-                free(board_gs[k]);
-            }
-            free(board_gs);
-            return NULL;
-        }
-
-        for (size_t j = 0; j < BOARD_HEIGHT; j++) {
-            board_gs[i][j] = board->cells[i][j].alive ? 255 : 0;
-        }
+/*  Queue the board as a 1 bit board.bmp. Only the packing happens here, the
+    file is written on the exporter's thread so the frame never waits on disk.
+*/
+void saveBoard(cell_board* board, exporter* out) {
+    const size_t row_bytes = (BOARD_WIDTH + 7) / 8;
+    export_job job = { .data = malloc(row_bytes * BOARD_HEIGHT), .width = BOARD_WIDTH, .height = BOARD_HEIGHT, .depth = 1 };
+    if(job.data == NULL) {
+        fprintf(stderr, "could not save board.bmp\n");
+        return;
     }
+    for(uint32_t y = 0; y < BOARD_HEIGHT; y++)
+        getBoardRow(board, y, job.data + y * row_bytes);
+    snprintf(job.path, EXPORTER_PATH_MAX, "board.bmp");
+
+    if(exporter_submit(out, &job, false) == EXPORTER_OK)
+        fprintf(stderr, "saving board image\n");
+    else
+        fprintf(stderr, "still writing earlier images, board.bmp dropped\n");
+}
 
-    return board_gs;
+/* Refill the torus texture in place, the texture and its buffer live as long as the window */
+void updateBoardTexture(cell_board* board, board_texture* texture) {
+    for(size_t i = 0; i < BOARD_WIDTH; i++)
+        pixels_row_from_bools(&texture->pixels, i, &board->cells[i][0].alive, sizeof(cell));
+    render_upload(texture);
 }
 
-Image getBoardImageGS(cell_board* board) {
-    // TODO: see if i or j need to be swapped here
-    unsigned char board_gs[BOARD_WIDTH][BOARD_HEIGHT];
+unsigned long safe_atoi(const char *str) {
+    unsigned long value;
+    if (sscanf(str, "%lu", &value) == 1) {
+        return value;
+    } else {
+        // Handle conversion error
+        fprintf(stderr, "Invalid input\n");
+        return 0;
+    }
+}
 
-    for(size_t i = 0; i < BOARD_WIDTH; i++) {
-        for(size_t j = 0; j < BOARD_WIDTH; j++) {
-            if(board->cells[i][j].alive)
-                board_gs[i][j] = 255;
-            else
-                board_gs[i][j] = 0;
+bool hasExtension(const char* path, const char* extension) {
+    size_t length = strlen(path), ext_length = strlen(extension);
+    return length > ext_length && strcmp(path + length - ext_length, extension) == 0;
+}
+
+/*  The board packed a bit per cell, column after column (cell (i, j) is bit
+    i * BOARD_HEIGHT + j), with its generation and RNG state, as life_q and
+    lenia_c's window write it. See checkpoint.h
+*/
+bool checkpointBoard(cell_board* board, const char* path) {
+    uint64_t bits[(BOARD_WIDTH * BOARD_HEIGHT + 63) / 64] = { 0 };
+    for(size_t i = 0; i < BOARD_WIDTH; i++)
+        for(size_t j = 0; j < BOARD_HEIGHT; j++) {
+            size_t k = i * BOARD_HEIGHT + j;
+            bits[k / 64] |= (uint64_t) board->cells[i][j].alive << (k % 64);
         }
+
+    checkpoint_header h;
+    checkpoint_describe(&h, "life", "B3/S23");
+    h.width = BOARD_WIDTH;
+    h.height = BOARD_HEIGHT;
+    h.generation = generation;
+    h.rng = board_rng;
+    h.cell_bits = 1;
+    h.state_bytes = sizeof(bits);
+
+    int status = checkpoint_write(path, &h, bits);
+    if(status != CHECKPOINT_OK)
+        fprintf(stderr, "could not write checkpoint %s (%d)\n", path, status);
+    else
+        fprintf(stderr, "checkpoint %s at generation %llu\n", path, (unsigned long long) generation);
+    return status == CHECKPOINT_OK;
+}
+
+/*  Put the board back as the checkpoint at path left it. The torus is fixed
+    at BOARD_WIDTH x BOARD_HEIGHT, a checkpoint of any other size is refused.
+*/
+bool restoreBoard(cell_board* board, Queue* q, const char* path) {
+    checkpoint_map m;
+    int status = checkpoint_open(&m, path);
+    if(status != CHECKPOINT_OK) {
+        fprintf(stderr, "could not read checkpoint %s (%d)\n", path, status);
+        return false;
+    }
+    const checkpoint_header* h = m.header;
+    const size_t words = (BOARD_WIDTH * BOARD_HEIGHT + 63) / 64;
+    if(strcmp(h->engine, "life") != 0 || h->width != BOARD_WIDTH || h->height != BOARD_HEIGHT
+       || h->cell_bits != 1 || h->state_bytes != words * sizeof(uint64_t)) {
+        fprintf(stderr, "checkpoint %s is a %s board of %llux%llu, not this one\n", path, h->engine,
+            (unsigned long long) h->width, (unsigned long long) h->height);
+        checkpoint_close(&m);
+        return false;
     }
-    Image img = {
-        .data = board_gs,
-        .width = BOARD_WIDTH,
-        .height = BOARD_HEIGHT,
-        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
-        .mipmaps = 1
-    };
-
-    return img;
+
+    clearBoard(board);
+    resetQueue(q);
+    IntSet* s = &board->frontier;
+    iset_clear(s);
+
+    const uint64_t* bits = (const uint64_t*) m.state;
+    for(size_t i = 0; i < BOARD_WIDTH; i++)
+        for(size_t j = 0; j < BOARD_HEIGHT; j++) {
+            size_t k = i * BOARD_HEIGHT + j;
+            if(bits[k / 64] >> (k % 64) & 1) {
+                setCellB(board, i, j, alive);
+                setEnqueuedNCells(board, q, s, i, j);
+            }
+        }
+
+    generation = h->generation;
+    board_rng = h->rng;
+    fprintf(stderr, "restored %s at generation %llu\n", path, (unsigned long long) h->generation);
+    checkpoint_close(&m);
+    return true;
 }
 
 
 int main(int argc, char **argv) {
-    srand(time(NULL));
+    board_rng ^= (uint64_t) time(NULL) * 0xBF58476D1CE4E5B9ULL;
+    bool restoring = false;
 
     for (int i = 0; i < argc; i++) {
         printf("%s\n", argv[i]);
     }
 
+    unsigned int update_interval = UPDATE_INTERVAL_FRAMES;
+    if(argc >= 2) {
+        update_interval = (unsigned int) safe_atoi(argv[1]);
+        if(update_interval == 0)
+            update_interval = 1;
+    }
+    if(argc >= 3 && hasExtension(argv[2], ".ckpt")) {
+        checkpoint_path = argv[2];
+        restoring = true;
+    }
+
     fprintf(stderr, "Started prog\n");
 
     cell_board* board = init_board(BOARD_WIDTH, BOARD_HEIGHT);
     Queue* queue = malloc(sizeof(Queue));
-    initializeQueue(queue);
 
     if (board == NULL) {
         free(board);
@@ -368,6 +469,15 @@ int main(int argc, char **argv) {
         free(queue);
         return 1;  // Return 1 to indicate memory allocation failure
     }
+    // the queue doubles on demand, no need to reserve the whole board up front
+    initializeQueue(queue, QUEUE_MIN_SIZE);
+
+    if(restoring && !restoreBoard(board, queue, checkpoint_path)) {
+        iset_destroy(&board->frontier);
+        free(board);
+        freeQueue(queue);
+        return 1;
+    }
 
     fprintf(stderr, "Gotten board\n");
     
@@ -395,20 +505,37 @@ int main(int argc, char **argv) {
     
     SetTargetFPS(120);
 
-    //model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+    // one texture for the whole run, UpdateTexture rewrites it every generation
+    board_texture texture;
+    if(render_init(&texture, BOARD_WIDTH, BOARD_HEIGHT) != PIXELS_OK) {
+        UnloadModel(model);
+        CloseWindow();
+        return 1;
+    }
+    exporter snapshots;
+    if(exporter_start(&snapshots, SNAPSHOT_QUEUE) != EXPORTER_OK) {
+        render_unload(&texture);
+        UnloadModel(model);
+        CloseWindow();
+        return 1;
+    }
+    SetTextureWrap(texture.texture, TEXTURE_WRAP_REPEAT);
+    updateBoardTexture(board, &texture);
+    model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture.texture;
 
     unsigned int frame_ctr = 0;
 
     while (!WindowShouldClose()) {
+        int key_pressed = GetKeyPressed();
+
         switch(mode) {
             case paused:
                 //DrawText(TextFormat("Paused"), 80, CELL_WIDTH_PX * BOARD_HEIGHT + 20, 20, RED);
 
-                int key_pressed = GetKeyPressed();
-
                 if(key_pressed == KEY_R) {
                     clearBoard(board);
                     randomizeBoard(board, queue);
+                    updateBoardTexture(board, &texture);
                 }
 
                 if(key_pressed == KEY_C) {
@@ -417,32 +544,15 @@ int main(int argc, char **argv) {
                     
                     resetQueue(queue);
                     fprintf(stderr, "reset queue\n");
+                    updateBoardTexture(board, &texture);
                 }
 
                 if(key_pressed == KEY_S) {
-                    fprintf(stderr, "saved board image\n");
-                    const unsigned char** b = (const unsigned char**) getBoardBytes(board);
-                    
-                    
-                    bmpfile_t* bmp = bmp_create(BOARD_WIDTH, BOARD_HEIGHT, 24);
-
-                    // Define a red pixel
-                    for(size_t i = 0; i < BOARD_WIDTH; i++)
-                        for(size_t j = 0; j < BOARD_WIDTH; j++) {
-                            rgb_pixel_t pixel = { .red = b[i][j], .green = b[i][j], .blue = b[i][j], .alpha = 0 };
-                            // Set the pixel at (50, 50) to red
-                            bmp_set_pixel(bmp, i, j, pixel);
-                        }
-
-                    // Save the BMP file
-                    bmp_save(bmp, "board.bmp");
-
-                    // Clean up
-                    bmp_destroy(bmp);
-
-                    free(b);
-
+                    saveBoard(board, &snapshots);
                 }
+
+                if(key_pressed == KEY_F9 && restoreBoard(board, queue, checkpoint_path))
+                    updateBoardTexture(board, &texture);
                 
                 if(key_pressed == KEY_SPACE) {
                     mode = running;
@@ -452,11 +562,17 @@ int main(int argc, char **argv) {
 
             case running:
                 //DrawText(TextFormat("Running"), 80, CELL_WIDTH_PX * BOARD_HEIGHT + 20, 20, RED);
-                if(GetKeyPressed() == KEY_SPACE) {
+                if(key_pressed == KEY_SPACE) {
                     mode = paused;
                     SetWindowTitle("GoL (rip Conway) on a torus! : (paused)");
                 }
 
+                // = steps faster, - slower
+                if(key_pressed == KEY_EQUAL && update_interval > 1)
+                    update_interval--;
+                if(key_pressed == KEY_MINUS)
+                    update_interval++;
+
                 break;
 
             default:
@@ -465,43 +581,17 @@ int main(int argc, char **argv) {
                 break;
         }
 
+        if(key_pressed == KEY_F5)
+            checkpointBoard(board, checkpoint_path);
+
         UpdateCamera(&camera, CAMERA_ORBITAL);
         BeginDrawing();
 
-        if(mode == running && frame_ctr++ == 10) {
-            //updateBoard(board, queue);
-            //printBoard(board);
-            //printf("Updated board");
-            
-            //Image board_image = getBoardImage(board);
-
-            //UnloadTexture(texture);
-            //texture = LoadTextureFromImage(board_image);
-            //SetTextureWrap(texture, TEXTURE_WRAP_REPEAT);
-            //model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
-            //UnloadImage(board_image);
-
+        if(mode == running && ++frame_ctr >= update_interval) {
             updateBoard(board, queue);
+            generation++;
             printBoard(board);
-
-            Image board_image = getBoardImageGS(board);
-
-            // Unload the previous texture to prevent memory buildup
-            //UnloadTexture(texture);
-
-            // Load new texture from the updated image
-            Texture2D texture = LoadTextureFromImage(board_image);
-
-            // Set texture wrapping and filtering modes
-            SetTextureWrap(texture, TEXTURE_WRAP_REPEAT);
-            SetTextureFilter(texture, TEXTURE_FILTER_POINT);
-
-            // Apply the texture to the torus model
-            model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
-
-            // Free the image now that it's loaded as a texture
-            //UnloadImage(board_image);
-
+            updateBoardTexture(board, &texture);
             frame_ctr = 0;
         }
 
@@ -519,20 +609,29 @@ int main(int argc, char **argv) {
             //DrawRectangleLines(30, 400, 310, 30, Fade(DARKBLUE, 0.5f));
             //DrawText("MOUSE LEFT BUTTON to CYCLE PROCEDURAL MODELS", 40, 410, 10, BLUE);
         DrawText("Life on a torus :)", 500, 10, 20, DARKBLUE);
+        DrawText(TextFormat("%u frames / generation", update_interval), 500, 35, 10, DARKBLUE);
         EndDrawing();
 
 
     }
 
-    //UnloadTexture(texture); // Unload texture
+    // a run that never stepped has nothing worth keeping, don't clobber an older one
+    if(generation)
+        checkpointBoard(board, checkpoint_path);
 
-    // Unload models data (GPU VRAM)
+    // Unload models data (GPU VRAM), the model doesn't own the board texture
     UnloadModel(model);
+    render_unload(&texture);
+    exporter_stop(&snapshots);
+    if(snapshots.failed)
+        fprintf(stderr, "%lu board images could not be written\n", (unsigned long) snapshots.failed);
 
     CloseWindow();          // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
+    iset_destroy(&board->frontier);
     free(board);
+    freeQueue(queue);
     free(queue);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bmpfile.h"
+
+// The streaming writer has to give the same 1 bit file as building the
+// image with bmp_set_pixel and saving it, 8 bit rows have to read back as
+// written with zero padding, and a source that gives up leaves no file.
+
+#define WIDTH 37
+#define HEIGHT 23
+
+static unsigned char cells[HEIGHT][WIDTH];
+static unsigned char grey[HEIGHT][WIDTH];
+
+bool packed_row(void* ctx, uint32_t y, uint8_t* row) {
+    (void) ctx;
+    for(size_t x = 0; x < WIDTH; x += 8) {
+        uint8_t byte = 0;
+        for(size_t b = 0; b < 8 && x + b < WIDTH; b++)
+            byte |= cells[y][x + b] << (7 - b);
+        row[x / 8] = byte;
+    }
+    return true;
+}
+
+bool failing_row(void* ctx, uint32_t y, uint8_t* row) {
+    (void) row;
+    return y != *(uint32_t*) ctx;
+}
+
+unsigned char* slurp(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    unsigned char* data = malloc(*size + 1);
+    if(data == NULL || fread(data, 1, *size, fp) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+uint32_t le32(const unsigned char* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+int main(void) {
+    size_t wrong = 0, old_size = 0, new_size = 0;
+
+    for(size_t y = 0; y < HEIGHT; y++)
+        for(size_t x = 0; x < WIDTH; x++) {
+            cells[y][x] = rand() % 3 == 0;
+            grey[y][x] = rand() % 256;
+        }
+
+    bmpfile_t* bmp = bmp_create(WIDTH, HEIGHT, 1);
+    for(size_t y = 0; y < HEIGHT; y++)
+        for(size_t x = 0; x < WIDTH; x++) {
+            uint8_t v = cells[y][x] ? 255 : 0;
+            rgb_pixel_t pixel = { .red = v, .green = v, .blue = v, .alpha = 0 };
+            bmp_set_pixel(bmp, x, y, pixel);
+        }
+    bmp_save(bmp, "test_bmp_old.bmp");
+    bmp_destroy(bmp);
+    bmp_save_rows("test_bmp_new.bmp", WIDTH, HEIGHT, 1, packed_row, NULL);
+
+    unsigned char* old = slurp("test_bmp_old.bmp", &old_size);
+    unsigned char* new = slurp("test_bmp_new.bmp", &new_size);
+    wrong += old == NULL || new == NULL || old_size != new_size || memcmp(old, new, old_size) != 0;
+    free(old);
+    free(new);
+
+    const uint8_t* rows[HEIGHT];
+    for(size_t y = 0; y < HEIGHT; y++)
+        rows[y] = grey[y];
+    bmp_save_row_pointers("test_bmp_grey.bmp", WIDTH, HEIGHT, 8, rows);
+
+    size_t size = 0;
+    unsigned char* data = slurp("test_bmp_grey.bmp", &size);
+    size_t line = (WIDTH + 3) / 4 * 4;
+    if(data == NULL || size != 54 + 1024 + line * HEIGHT) {
+        wrong++;
+    } else {
+        wrong += le32(data + 10) != 54 + 1024 || le32(data + 18) != WIDTH || le32(data + 22) != HEIGHT;
+        wrong += data[28] != 8 || le32(data + 54 + 4 * 200) != 0x00c8c8c8;
+        for(size_t y = 0; y < HEIGHT; y++) {
+            const unsigned char* row = data + 54 + 1024 + (HEIGHT - 1 - y) * line;
+            wrong += memcmp(row, grey[y], WIDTH) != 0;
+            for(size_t x = WIDTH; x < line; x++)
+                wrong += row[x] != 0;
+        }
+    }
+    free(data);
+
+    uint32_t give_up = HEIGHT / 2;
+    wrong += bmp_save_rows("test_bmp_fail.bmp", WIDTH, HEIGHT, 1, failing_row, &give_up);
+    wrong += fopen("test_bmp_fail.bmp", "rb") != NULL;
+    wrong += bmp_save_rows("test_bmp_fail.bmp", WIDTH, HEIGHT, 24, packed_row, NULL);
+
+    remove("test_bmp_old.bmp");
+    remove("test_bmp_new.bmp");
+    remove("test_bmp_grey.bmp");
+    printf("%dx%d, 1 bit file %zu bytes, %lu wrong\n", WIDTH, HEIGHT, new_size, (unsigned long) wrong);
+    return wrong != 0;
+}
@@ -0,0 +1,28 @@
+#include <stdio.h>
+
+#include "frontier.h"
+
+
+int main(void) {
+    Frontier f;
+    frontier_init(&f, 50 * 50);
+
+    for(uint64_t i = 0; i < 50 * 50; i += 3) {
+        frontier_add(&f, i);
+    }
+
+    if(frontier_add(&f, 42) == SET_ALREADY_PRESENT && frontier_add_atomic(&f, 42) == SET_ALREADY_PRESENT) {
+        printf("42 was already there\n");
+    }
+
+    if(frontier_add_atomic(&f, 43) == SET_TRUE) {
+        printf("43 added atomically, frontier has %lu cells\n", (unsigned long) frontier_length(&f));
+    }
+
+    frontier_clear(&f);
+    if(frontier_length(&f) == 0 && frontier_contains(&f, 42) == SET_FALSE) {
+        printf("cleared frontier is empty\n");
+    }
+
+    frontier_destroy(&f);
+}
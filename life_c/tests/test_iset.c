@@ -0,0 +1,44 @@
+#include <stdio.h>
+
+#include "iset.h"
+
+
+int main(void) {
+    IntSet s, t, r;
+    iset_init(&s);
+    iset_init(&t);
+    iset_init(&r);
+
+    for(uint64_t i = 0; i < 10000; i++) {
+        iset_add(&s, i);
+        iset_add(&t, i * 2);
+    }
+
+    if(iset_add(&s, 42) == SET_ALREADY_PRESENT) {
+        printf("42 was already there\n");
+    }
+
+    iset_remove(&s, 42);
+    if(iset_contains(&s, 42) == SET_FALSE && iset_contains(&s, 43) == SET_TRUE) {
+        printf("42 removed, 43 still there\n");
+    }
+
+    iset_intersection(&r, &s, &t);
+    printf("intersection has %lu keys\n", (unsigned long) iset_length(&r));
+
+    // same result through the sorted merge path
+    IntSet m;
+    iset_init(&m);
+    iset_intersection_sorted(&m, &s, &t);
+    if(iset_cmp(&m, &r) == SET_EQUAL) {
+        printf("sorted intersection matches\n");
+    }
+    iset_destroy(&m);
+
+    iset_clear(&s);
+    printf("cleared set has %lu keys\n", (unsigned long) iset_length(&s));
+
+    iset_destroy(&s);
+    iset_destroy(&t);
+    iset_destroy(&r);
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pixels.h"
+
+#define WIDTH 37
+#define HEIGHT 45
+
+typedef struct {
+    bool alive;
+    bool enqueued;
+    unsigned short neighbors;
+    uint32_t i;
+    uint32_t j;
+} cell;
+
+
+int main(void) {
+    static bool cells[WIDTH][HEIGHT];
+    static cell structs[WIDTH][HEIGHT];
+    static uint64_t bits[(WIDTH * HEIGHT + 63) / 64];
+    pixel_buffer from_bools, from_structs, from_bits, from_spans;
+
+    pixels_init(&from_bools, WIDTH, HEIGHT, PIXELS_WHITE, PIXELS_BLACK);
+    pixels_init(&from_structs, WIDTH, HEIGHT, PIXELS_WHITE, PIXELS_BLACK);
+    pixels_init(&from_bits, WIDTH, HEIGHT, PIXELS_WHITE, PIXELS_BLACK);
+    pixels_init(&from_spans, WIDTH, HEIGHT, PIXELS_WHITE, PIXELS_BLACK);
+
+    for(size_t i = 0; i < WIDTH; i++) {
+        for(size_t j = 0; j < HEIGHT; j++) {
+            cells[i][j] = rand() % 5 == 0;
+            structs[i][j].alive = cells[i][j];
+            if(cells[i][j])
+                bits[(i * HEIGHT + j) / 64] |= (uint64_t) 1 << (i * HEIGHT + j) % 64;
+        }
+    }
+
+    for(size_t i = 0; i < WIDTH; i++) {
+        pixels_row_from_bools(&from_bools, i, cells[i], sizeof(bool));
+        pixels_row_from_bools(&from_structs, i, &structs[i][0].alive, sizeof(cell));
+    }
+    pixels_from_bits(&from_bits, bits);
+    // each row in two uneven spans
+    for(size_t i = 0; i < WIDTH; i++) {
+        pixels_span_from_bits(&from_spans, i, 0, i % HEIGHT, bits);
+        pixels_span_from_bits(&from_spans, i, i % HEIGHT, HEIGHT - i % HEIGHT, bits);
+    }
+
+    // cell (i, j) is texel j of row i whichever way it was filled
+    size_t wrong = 0;
+    for(size_t i = 0; i < WIDTH; i++) {
+        for(size_t j = 0; j < HEIGHT; j++) {
+            uint32_t expected = cells[i][j] ? PIXELS_WHITE : PIXELS_BLACK;
+            wrong += pixels_row(&from_bools, i)[j] != expected;
+            wrong += pixels_row(&from_structs, i)[j] != expected;
+            wrong += pixels_row(&from_bits, i)[j] != expected;
+            wrong += pixels_row(&from_spans, i)[j] != expected;
+        }
+    }
+    printf("%dx%d board, %lu wrong texels\n", WIDTH, HEIGHT, (unsigned long) wrong);
+
+    // the rects from dirty_collect cover every marked texel exactly once
+    dirty_tiles dirty;
+    static unsigned char covered[WIDTH][HEIGHT];
+    static bool marked[WIDTH][HEIGHT];
+    dirty_init(&dirty, HEIGHT, WIDTH, 3);
+    dirty_rect* rects = malloc(dirty_max_rects(&dirty) * sizeof(dirty_rect));
+    dirty_collect(&dirty, rects);   // starts all dirty
+
+    for(size_t i = 0; i < WIDTH; i++) {
+        for(size_t j = 0; j < HEIGHT; j++) {
+            marked[i][j] = rand() % 64 == 0;
+            if(marked[i][j])
+                dirty_mark(&dirty, i, j);
+        }
+    }
+
+    size_t n = dirty_collect(&dirty, rects), bad_rects = 0;
+    for(size_t k = 0; k < n; k++) {
+        bad_rects += rects[k].y + rects[k].height > WIDTH || rects[k].x + rects[k].width > HEIGHT;
+        for(size_t i = rects[k].y; i < rects[k].y + rects[k].height && i < WIDTH; i++)
+            for(size_t j = rects[k].x; j < rects[k].x + rects[k].width && j < HEIGHT; j++)
+                covered[i][j]++;
+    }
+    for(size_t i = 0; i < WIDTH; i++)
+        for(size_t j = 0; j < HEIGHT; j++)
+            bad_rects += covered[i][j] > 1 || (marked[i][j] && !covered[i][j]);
+    bad_rects += dirty_collect(&dirty, rects) != 0;
+    printf("%lu dirty rects, %lu bad\n", (unsigned long) n, (unsigned long) bad_rects);
+
+    pixels_destroy(&from_bools);
+    pixels_destroy(&from_structs);
+    pixels_destroy(&from_bits);
+    pixels_destroy(&from_spans);
+    dirty_destroy(&dirty);
+    free(rects);
+    return wrong != 0 || bad_rects != 0;
+}
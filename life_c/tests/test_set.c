@@ -2,11 +2,84 @@
 
 #include "set.h"
 
+// Also built against set_swiss.c (-DSET_SWISS). Both have to survive heavy
+// removal and keys that all hash alike: removal re-lays out or shifts back
+// the rest of the probe run, and the swiss table mirrors its first control
+// bytes after the last slot, which a run wrapping past the end goes through.
+
+#define KEYS 600
 
 const char* test[2] = {"Hi", "hello"};
 
+// every key lands on the slot before last, so runs wrap and collide in full
+static uint64_t colliding_hash(const char *key) {
+    (void) key;
+    return (uint64_t) -2;
+}
+
+// a few homes, the same top bits for all of them
+static uint64_t clustered_hash(const char *key) {
+    uint64_t h = 0;
+    for (; *key; key++)
+        h += (unsigned char) *key;
+    return h % 8;
+}
+
+static void make_key(char *buf, size_t k) {
+    // every third key is too long to sit inline in a swiss slot
+    snprintf(buf, 64, k % 3 ? "k%zu" : "a rather longer key number %zu", k);
+}
+
+/* Add KEYS keys, then remove them in a scrambled order, checking every key
+   after each removal. Returns the number of wrong answers. */
+static size_t churn(set_hash_function hash, uint64_t initial) {
+    SimpleSet s;
+    unsigned char present[KEYS] = { 0 };
+    char key[64];
+    size_t wrong = 0;
+
+    if (set_init_alt(&s, initial, hash) != SET_TRUE)
+        return 1;
+    for (size_t k = 0; k < KEYS; k++) {
+        make_key(key, k);
+        wrong += set_add(&s, key) != SET_TRUE;
+        present[k] = 1;
+    }
+
+    for (size_t r = 0; r < KEYS; r++) {
+        size_t k = r * 7 % KEYS;     // 7 is coprime with KEYS
+        make_key(key, k);
+        wrong += set_remove(&s, key) != SET_TRUE;
+        wrong += set_remove(&s, key) != SET_FALSE;
+        present[k] = 0;
+
+        // put an earlier one back now and then, it has to find a hole
+        if (r % 5 == 4) {
+            size_t back = (r - 2) * 7 % KEYS;
+            make_key(key, back);
+            wrong += set_add(&s, key) != SET_TRUE;
+            present[back] = 1;
+        }
+
+        if (r % 4 == 0 || r + 10 > KEYS) {
+            for (size_t j = 0; j < KEYS; j++) {
+                make_key(key, j);
+                wrong += (set_contains(&s, key) == SET_TRUE) != present[j];
+            }
+        }
+    }
+
+    size_t left = 0;
+    for (size_t j = 0; j < KEYS; j++)
+        left += present[j];
+    wrong += set_length(&s) != left;
+    set_destroy(&s);
+    return wrong;
+}
+
 int main(void) {
     SimpleSet s;
+    size_t wrong = 0;
     set_init(&s);
     printf("Hello, world!\n");
     
@@ -20,4 +93,28 @@ int main(void) {
         printf("Hello was already there\n");
     }
     set_destroy(&s);
+
+    // same set, nodes and keys carved from an arena and dropped in one reset
+    SetArena arena;
+    set_arena_init(&arena, 0);
+    set_init_arena(&s, 1024, NULL, &arena);
+
+    for(int i = 0; i < 2; i++) {
+        set_add(&s, test[i]);
+    }
+    if(set_contains(&s, "hello") == SET_TRUE && set_remove(&s, "Hi") == SET_TRUE) {
+        printf("arena backed set has %lu element\n", (unsigned long) set_length(&s));
+    }
+
+    set_destroy(&s);
+    set_arena_reset(&arena);
+    set_arena_destroy(&arena);
+
+    wrong += churn(NULL, 16);
+    wrong += churn(NULL, 4096);
+    wrong += churn(colliding_hash, 16);
+    wrong += churn(colliding_hash, 1024);
+    wrong += churn(clustered_hash, 16);
+    printf("%d keys added and removed under 5 hash layouts, %lu wrong\n", KEYS, (unsigned long) wrong);
+    return wrong != 0;
 }
\ No newline at end of file